@@ -12,6 +12,7 @@
 #include "../source/spc7110.h"
 #include "../source/srtc.h"
 #include "../source/sa1.h"
+#include "../source/fxemu.h"
 
 #ifdef PSP
 #include <pspkernel.h>
@@ -31,6 +32,68 @@ static retro_environment_t environ_cb = NULL;
 struct retro_perf_callback perf_cb;
 
 static float samples_per_frame = 0.0;
+static bool can_dupe = false;
+static struct retro_memory_descriptor* memory_descriptors = NULL;
+
+#ifndef USE_BLARGG_APU
+/* Dynamic rate control. The frontend tells us how full its audio buffer is
+ * before every frame; the mixed samples are then stretched or squeezed by at
+ * most DRC_MAX_DEVIATION so the buffer settles around half full instead of
+ * slowly draining or overflowing when the display and the emulated refresh
+ * rate don't quite match. Frontends that do their own rate control (and may
+ * only want the buffer status for frameskipping) would fight the resampler,
+ * so it only runs when the frontend asks for it through
+ * RETRO_ENVIRONMENT_GET_CORE_RATE_CONTROL. */
+#define DRC_MAX_DEVIATION 0.005f
+
+static bool drc_enabled = false;
+static bool drc_active = false;
+static unsigned drc_occupancy = 50;
+
+static uint32_t drc_phase = 0;
+static int16_t drc_last [2] = { 0, 0 };
+
+static void audio_buffer_status_cb(bool active, unsigned occupancy,
+                                   bool underrun_likely)
+{
+   drc_active = active;
+   drc_occupancy = underrun_likely ? 0 : occupancy > 100 ? 100 : occupancy;
+}
+
+/* Linear interpolating resampler for interleaved stereo. 'step' is the
+ * distance in input frames between two output frames, in 16.16 fixed point.
+ * The last input frame and the fractional position are carried over to the
+ * next call so consecutive blocks join without a click. */
+static int drc_resample(const int16_t* in, int in_frames, int16_t* out,
+                        uint32_t step)
+{
+   uint32_t pos = drc_phase;
+   uint32_t end = (uint32_t) in_frames << 16;
+   int out_frames = 0;
+
+   while (pos < end)
+   {
+      int idx = pos >> 16;
+      // 15 bits of fraction keep (l1 - l0) * frac inside an int even for a
+      // full-scale swing between two samples
+      int frac = (pos & 0xffff) >> 1;
+      int l0 = idx ? in [(idx - 1) * 2 + 0] : drc_last [0];
+      int r0 = idx ? in [(idx - 1) * 2 + 1] : drc_last [1];
+      int l1 = in [idx * 2 + 0];
+      int r1 = in [idx * 2 + 1];
+
+      out [out_frames * 2 + 0] = l0 + (((l1 - l0) * frac) >> 15);
+      out [out_frames * 2 + 1] = r0 + (((r1 - r0) * frac) >> 15);
+      out_frames++;
+      pos += step;
+   }
+
+   drc_phase = pos - end;
+   drc_last [0] = in [(in_frames - 1) * 2 + 0];
+   drc_last [1] = in [(in_frames - 1) * 2 + 1];
+   return out_frames;
+}
+#endif
 
 
 #ifdef PERF_TEST
@@ -110,6 +173,8 @@ void S9xMessage(int type, int number, const char* message)
 #endif
 }
 
+#define GFX_SCREEN_SAFETY 32
+
 void S9xDeinitDisplay(void)
 {
 #ifdef DS2_DMA
@@ -135,7 +200,7 @@ void S9xDeinitDisplay(void)
 void S9xInitDisplay(void)
 {
    int h = IMAGE_HEIGHT;
-   const int safety = 32;
+   const int safety = GFX_SCREEN_SAFETY;
 
    GFX.Pitch = IMAGE_WIDTH * 2;
 #ifdef DS2_DMA
@@ -166,11 +231,46 @@ const char* S9xBasename(const char* f)
    return (f);
 }
 
+/* Called at the start of every rendered frame. On the Vita, render straight
+ * into the frontend's texture so the frame doesn't have to be copied again
+ * in video_cb. The sub screen and Z buffers stay ours; only their pitch has
+ * to agree with GFX.Screen's.
+ *
+ * The renderers write up to GFX_SCREEN_SAFETY bytes in front of the frame,
+ * so the frame starts one spare line into the buffer and video_cb gets that
+ * offset pointer back. RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER
+ * leaves offset pointers undefined, which is why this is only done for our
+ * own frontend, whose refresh callback (vita_video.c) is written to accept
+ * them. The buffer starts out with unspecified contents and is only ours
+ * until retro_run returns, so when we use it every line is redrawn: nothing
+ * can be kept from the last frame and no frame is reported as a dupe. */
 bool S9xInitUpdate()
 {
-   //   IPPU.RenderThisFrame = 0;
-   //   video_cb(dummy_frame,256,224,512);
-   //   return (false);
+   uint8_t* screen = GFX.Screen_buffer + GFX_SCREEN_SAFETY;
+   bool foreign = false;
+#ifdef VITA
+   struct retro_framebuffer fb;
+
+   memset(&fb, 0, sizeof(fb));
+   fb.width = IMAGE_WIDTH;
+   fb.height = IMAGE_HEIGHT + 1;
+   fb.access_flags = RETRO_MEMORY_ACCESS_WRITE | RETRO_MEMORY_ACCESS_READ;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER, &fb) &&
+         fb.data && fb.format == RETRO_PIXEL_FORMAT_RGB565 &&
+         fb.pitch == GFX.RealPitch && fb.pitch >= GFX_SCREEN_SAFETY &&
+         fb.width >= IMAGE_WIDTH && fb.height >= IMAGE_HEIGHT + 1)
+   {
+      screen = (uint8_t*) fb.data + fb.pitch;
+      foreign = true;
+   }
+#endif
+
+   // Lines kept from the last frame only exist in our own buffer, and only
+   // if it was the one drawn into last time.
+   if (foreign || screen != GFX.Screen)
+      IPPU.ScreenChanged = true;
+   GFX.Screen = screen;
 
    return (true);
 }
@@ -272,6 +372,8 @@ void init_sfc_setting(void)
    Settings.Transparency = true;
    Settings.SupportHiRes = true;
    Settings.ThreadSound = false;
+   Settings.ThreadSuperFX = false;
+   Settings.SDD1CacheSize = 2 * 1024 * 1024;
 #ifdef USE_BLARGG_APU
    Settings.SoundSync = false;
 #endif
@@ -317,6 +419,21 @@ void retro_init(void)
       log_cb(RETRO_LOG_INFO,
              "Frontend supports RGB565 - will use that instead of XRGB1555.\n");
 
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_CAN_DUPE, &can_dupe))
+      can_dupe = false;
+
+#ifndef USE_BLARGG_APU
+   struct retro_audio_buffer_status_callback buf_status_cb = { audio_buffer_status_cb };
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_CORE_RATE_CONTROL, &drc_enabled))
+      drc_enabled = false;
+   if (!drc_enabled ||
+         !environ_cb(RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK, &buf_status_cb))
+   {
+      drc_enabled = false;
+      drc_active = false;
+   }
+#endif
+
    init_sfc_setting();
    S9xInitMemory();
    S9xInitAPU();
@@ -336,11 +453,12 @@ void retro_init(void)
 void retro_deinit(void)
 {
 
-   if (Settings.SPC7110)
-      (*CleanUp7110)();
+   S9xSpc7110Deinit();
 
    SaveSRAM(S9xGetFilename("srm"));
 
+   S9xSuperFXSync();
+   FxThreadDeinit();
    S9xDeinitGFX();
    S9xDeinitDisplay();
    S9xDeinitAPU();
@@ -405,14 +523,28 @@ void retro_run(void)
 
 #ifndef USE_BLARGG_APU
    static int16_t audio_buf[2048];
+   static int16_t drc_buf[2048];
 
    samples_to_play += samples_per_frame;
 
    if (samples_to_play > 512)
    {
-      S9xMixSamples((void*)audio_buf, ((int)samples_to_play) * 2);
-      if (Options.EmulateSound) { audio_batch_cb(audio_buf, (int)samples_to_play); }
-      samples_to_play -= (int)samples_to_play;
+      int frames = (int)samples_to_play;
+      S9xMixSamples((void*)audio_buf, frames * 2);
+      if (Options.EmulateSound)
+      {
+         if (drc_enabled && drc_active)
+         {
+            // below half full -> produce a little more, above -> a little less
+            float ratio = 1.0f + DRC_MAX_DEVIATION *
+                          (1.0f - (float) drc_occupancy / 50.0f);
+            audio_batch_cb(drc_buf, drc_resample(audio_buf, frames, drc_buf,
+                                                 (uint32_t)(65536.0f / ratio)));
+         }
+         else
+            audio_batch_cb(audio_buf, frames);
+      }
+      samples_to_play -= frames;
    }
 #endif
 
@@ -452,8 +584,13 @@ void retro_run(void)
       video_cb(texture_vram_p, IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight,
                GFX.Pitch);
 #else
-      video_cb(GFX.Screen, IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight,
-               GFX.Pitch);
+      // Nothing was redrawn this frame; let the frontend reuse its copy.
+      if (IPPU.ScreenReused && can_dupe)
+         video_cb(NULL, IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight,
+                  GFX.Pitch);
+      else
+         video_cb(GFX.Screen, IPPU.RenderedScreenWidth, IPPU.RenderedScreenHeight,
+                  GFX.Pitch);
 #endif
 
 #ifdef FRAMESKIP
@@ -501,51 +638,6 @@ void JustifierButtons(uint32_t* justifiers)
 {
 }
 
-char* osd_GetPackDir()
-{
-   static char filename[_MAX_PATH];
-   memset(filename, 0, _MAX_PATH);
-
-   char dir [_MAX_DIR + 1];
-   char drive [_MAX_DRIVE + 1];
-   char name [_MAX_FNAME + 1];
-   char ext [_MAX_EXT + 1];
-   _splitpath(Memory.ROMFilename, drive, dir, name, ext);
-   _makepath(filename, drive, dir, NULL, NULL);
-
-
-   if (!strncmp((char*)&Memory.ROM [0xffc0], "SUPER POWER LEAG 4   ", 21))
-   {
-      //if (getenv("SPL4PACK"))
-         //return getenv("SPL4PACK");
-      //else
-         strcat(filename, "/SPL4-SP7");
-   }
-   else if (!strncmp((char*)&Memory.ROM [0xffc0], "MOMOTETSU HAPPY      ", 21))
-   {
-      //if (getenv("MDHPACK"))
-         //return getenv("MDHPACK");
-      //else
-         strcat(filename, "/SMHT-SP7");
-   }
-   else if (!strncmp((char*)&Memory.ROM [0xffc0], "HU TENGAI MAKYO ZERO ", 21))
-   {
-      //if (getenv("FEOEZPACK"))
-         //return getenv("FEOEZPACK");
-      //else
-         strcat(filename, "/FEOEZSP7");
-   }
-   else if (!strncmp((char*)&Memory.ROM [0xffc0], "JUMP TENGAIMAKYO ZERO", 21))
-   {
-      //if (getenv("SJNSPACK"))
-         //return getenv("SJNSPACK");
-      //else
-         strcat(filename, "/SJUMPSP7");
-   }
-   else strcat(filename, "/MISC-SP7");
-   return filename;
-}
-
 unsigned retro_get_region(void)
 {
    return Settings.PAL ? RETRO_REGION_PAL : RETRO_REGION_NTSC;
@@ -609,6 +701,9 @@ bool retro_serialize(void* data, size_t size)
 {
    int i;
 
+   S9xSuperFXSync();
+   if (Settings.SuperFX)
+      fx_writeRegisterSpace();
    S9xUpdateRTC();
    S9xSRTCPreSaveState();
 #ifndef USE_BLARGG_APU
@@ -705,11 +800,16 @@ bool retro_unserialize(const void* data, size_t size)
    buffer += sizeof(rtc_f9);
 
    S9xFixSA1AfterSnapshotLoad();
+   if (Settings.SPC7110)
+      S9xSpc7110PostLoadState();
+   if (Settings.SuperFX)
+      fx_readRegisterSpace();
    FixROMSpeed();
    IPPU.ColorsChanged = true;
    IPPU.OBJChanged = true;
    CPU.InDMA = false;
    S9xFixColourBrightness();
+   S9xResetClipCache();
 
    S9xSA1UnpackStatus();
 #ifndef USE_BLARGG_APU
@@ -765,6 +865,7 @@ void retro_cheat_set(unsigned index, bool enabled, const char* code)
    Cheat.c[index].saved = false; // it'll be saved next time cheats run anyways
    
    Settings.ApplyCheats=true;
+   S9xUpdateCheatList();
    S9xApplyCheats();
 #endif
 }
@@ -843,9 +944,136 @@ static void init_descriptors(void)
    environ_cb(RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS, desc);
 }
 
+/* Describe the CPU address space to the frontend, one 4K Memory.Map block at
+ * a time, merging aligned power-of-two runs of blocks that are contiguous in
+ * the same chip. Only blocks that are plain memory are described: I/O,
+ * coprocessor windows and BW-RAM are left out, and so is ROM on carts that
+ * bank-switch it at run time, since the frontend takes the map as fixed. */
+typedef struct
+{
+   uint8_t* ptr;
+   size_t offset;
+   size_t len;
+   uint64_t flags;
+} block_desc;
+
+static bool describe_block(int block, block_desc* d)
+{
+   uint8_t* p = Memory.Map [block];
+   uint32_t address = block << MEMMAP_SHIFT;
+   uint32_t offset = address & 0xffff;
+
+   d->len = MEMMAP_BLOCK_SIZE;
+   d->flags = 0;
+
+   switch ((intptr_t) p)
+   {
+   case MAP_LOROM_SRAM:
+      if (!Memory.SRAMMask)
+         return false;
+      d->ptr = Memory.SRAM;
+      d->offset = (((address & 0xff0000) >> 1) | (address & 0x7fff)) &
+                  Memory.SRAMMask;
+      break;
+   case MAP_HIROM_SRAM:
+      if (!Memory.SRAMMask)
+         return false;
+      d->ptr = Memory.SRAM;
+      d->offset = ((address & 0x7fff) - 0x6000 + ((address & 0xf0000) >> 3)) &
+                  Memory.SRAMMask;
+      break;
+   default:
+      if (p < (uint8_t*) MAP_LAST)
+         return false;
+      p += offset;
+      if (p >= Memory.RAM && p < Memory.RAM + 0x20000)
+         d->ptr = Memory.RAM;
+      else if (p >= Memory.SRAM && p < Memory.SRAM + 0x20000)
+         d->ptr = Memory.SRAM;
+      else if (p >= Memory.ROM && p < Memory.ROM + MAX_ROM_SIZE &&
+               !Settings.SA1 && !Settings.SDD1 && !Settings.SPC7110)
+      {
+         d->ptr = Memory.ROM;
+         d->flags = RETRO_MEMDESC_CONST;
+      }
+      else
+         return false;
+      d->offset = p - d->ptr;
+      break;
+   }
+
+   // SRAM smaller than a block is mirrored inside it
+   if (d->ptr == Memory.SRAM && Memory.SRAMMask < MEMMAP_BLOCK_SIZE - 1)
+   {
+      d->offset = 0;
+      d->len = Memory.SRAMMask + 1;
+   }
+   return true;
+}
+
+static void set_memory_maps(void)
+{
+   struct retro_memory_map map;
+   unsigned count = 0;
+   int block = 0;
+
+   free(memory_descriptors);
+   memory_descriptors = (struct retro_memory_descriptor*) calloc(
+                           MEMMAP_NUM_BLOCKS, sizeof(struct retro_memory_descriptor));
+   if (!memory_descriptors)
+      return;
+
+   while (block < MEMMAP_NUM_BLOCKS)
+   {
+      block_desc d, next;
+      int run = 1;
+
+      if (!describe_block(block, &d))
+      {
+         block++;
+         continue;
+      }
+
+      // grow to 2, 4, 8 ... blocks while aligned and still contiguous
+      while (d.len == MEMMAP_BLOCK_SIZE && !(block & (run * 2 - 1)) &&
+             block + run * 2 <= MEMMAP_NUM_BLOCKS)
+      {
+         int i;
+         for (i = run; i < run * 2; i++)
+            if (!describe_block(block + i, &next) || next.ptr != d.ptr ||
+                  next.len != d.len || next.flags != d.flags ||
+                  next.offset != d.offset + i * MEMMAP_BLOCK_SIZE)
+               break;
+         if (i < run * 2)
+            break;
+         run *= 2;
+      }
+
+      struct retro_memory_descriptor* desc = &memory_descriptors [count++];
+      desc->flags = d.flags;
+      desc->ptr = d.ptr;
+      desc->offset = d.offset;
+      desc->start = block << MEMMAP_SHIFT;
+      desc->select = 0xffffff & ~((run << MEMMAP_SHIFT) - 1);
+      desc->len = d.len == MEMMAP_BLOCK_SIZE ? run << MEMMAP_SHIFT : d.len;
+
+      block += run;
+   }
+
+   map.descriptors = memory_descriptors;
+   map.num_descriptors = count;
+   environ_cb(RETRO_ENVIRONMENT_SET_MEMORY_MAPS, &map);
+}
+
 bool retro_load_game(const struct retro_game_info* game)
 
 {
+   // A GSU session of the previous game may still be running on the worker;
+   // it must be done with Memory.ROM and the memory map before they're
+   // rebuilt, and its busy flag mustn't carry over into the new game.
+   S9xSuperFXSync();
+   FxThreadDeinit();
+
    CPU.Flags = 0;
   init_descriptors();
 
@@ -860,6 +1088,7 @@ bool retro_load_game(const struct retro_game_info* game)
                          Settings.FrameTimeNTSC);
 
    LoadSRAM(S9xGetFilename("srm"));
+   set_memory_maps();
 
    struct retro_system_av_info av_info;
    retro_get_system_av_info(&av_info);
@@ -882,15 +1111,62 @@ bool retro_load_game_special(unsigned game_type,
 }
 void retro_unload_game(void)
 {
+   S9xSuperFXSync();
+   FxThreadDeinit();
+
+   free(memory_descriptors);
+   memory_descriptors = NULL;
+}
 
+/* Battery-backed part of Memory.SRAM, laid out exactly like the .srm file
+ * SaveSRAM() writes, including the S-RTC state behind it. */
+static size_t sram_save_size(void)
+{
+   size_t size;
+
+   if (Settings.SuperFX && Memory.ROMType < 0x15)
+      return 0;
+   if (Settings.SA1 && Memory.ROMType == 0x34)
+      return 0;
+
+   size = Memory.SRAMSize ? (1 << (Memory.SRAMSize + 3)) * 128 : 0;
+   if (size && Settings.SRTC)
+      size += SRTC_SRAM_PAD;
+   if (size > 0x20000)
+      size = 0x20000;
+   return size;
 }
 
 void* retro_get_memory_data(unsigned id)
 {
+   switch (id)
+   {
+   case RETRO_MEMORY_SAVE_RAM:
+      if (!sram_save_size())
+         return NULL;
+      // the GSU may still be writing its RAM on the SuperFX thread
+      S9xSuperFXSync();
+      if (Settings.SRTC)
+         S9xSRTCPreSaveState();
+      return Memory.SRAM;
+   case RETRO_MEMORY_SYSTEM_RAM:
+      return Memory.RAM;
+   case RETRO_MEMORY_VIDEO_RAM:
+      return Memory.VRAM;
+   }
    return NULL;
 }
 
 size_t retro_get_memory_size(unsigned id)
 {
+   switch (id)
+   {
+   case RETRO_MEMORY_SAVE_RAM:
+      return sram_save_size();
+   case RETRO_MEMORY_SYSTEM_RAM:
+      return 0x20000;
+   case RETRO_MEMORY_VIDEO_RAM:
+      return 0x10000;
+   }
    return 0;
 }
@@ -851,6 +851,54 @@ enum retro_mod
  * Returns the specified language of the frontend, if specified by the user.
  * It can be used by the core for localization purposes.
  */
+#define RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER (40 | RETRO_ENVIRONMENT_EXPERIMENTAL)
+/* struct retro_framebuffer * --
+ * Returns a preallocated framebuffer which the core can use for rendering
+ * the frame into when not using SET_HW_RENDER.
+ * The framebuffer returned from this call must not be used
+ * after the current call to retro_run() returns.
+ *
+ * The goal of this call is to allow zero-copy behavior where a core
+ * can render directly into video memory, avoiding extra bandwidth cost by copying
+ * memory from core to video memory.
+ *
+ * If this call succeeds and the core renders into it,
+ * the framebuffer pointer and pitch can be passed to retro_video_refresh_t.
+ * If the buffer from GET_CURRENT_SOFTWARE_FRAMEBUFFER is to be used,
+ * the core must pass the exact
+ * same pointer as returned by GET_CURRENT_SOFTWARE_FRAMEBUFFER;
+ * i.e. passing a pointer which is offset from the
+ * buffer is undefined. The pitch must match the value obtained from
+ * GET_CURRENT_SOFTWARE_FRAMEBUFFER; width and height may be smaller than
+ * the size that was requested.
+ *
+ * It is possible for a frontend to return a different pixel format
+ * than the one used in SET_PIXEL_FORMAT. This can happen if the frontend
+ * needs to perform conversion.
+ *
+ * It is still valid for a core to render to a different buffer
+ * even if GET_CURRENT_SOFTWARE_FRAMEBUFFER succeeds.
+ *
+ * A frontend must make sure that the pointer obtained from this function is
+ * writeable (and readable).
+ */
+#define RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK 62
+/* const struct retro_audio_buffer_status_callback * --
+ * Lets the core know how full the frontend's audio buffer is.
+ * The frontend calls the callback once before every retro_run() with
+ * the buffer occupancy in percent, so the core can decide whether to
+ * skip a frame or, if RETRO_ENVIRONMENT_GET_CORE_RATE_CONTROL allows it,
+ * adjust how many samples it produces.
+ * A NULL callback pointer disables the notifications again.
+ */
+
+#define RETRO_ENVIRONMENT_GET_CORE_RATE_CONTROL (1 | RETRO_ENVIRONMENT_PRIVATE)
+/* bool * --
+ * Set to true by a frontend that plays audio at a fixed rate and
+ * wants the core to do dynamic rate control on its own samples.
+ * Frontends that adjust the rate themselves leave this unanswered,
+ * so both sides don't correct for the same drift.
+ */
 
 #define RETRO_MEMDESC_CONST     (1 << 0)   /* The frontend will never change this memory area once retro_load_game has returned. */
 #define RETRO_MEMDESC_BIGENDIAN (1 << 1)   /* The memory area contains big endian data. Default is little endian. */
@@ -1106,6 +1154,18 @@ struct retro_log_callback
    retro_log_printf_t log;
 };
 
+/* Audio buffer status, see RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK.
+ * 'active' is false while the frontend isn't consuming audio at all,
+ * 'occupancy' is 0 to 100 and 'underrun_likely' is set when less than
+ * one output period is buffered. */
+typedef void (*retro_audio_buffer_status_callback_t)(bool active,
+      unsigned occupancy, bool underrun_likely);
+
+struct retro_audio_buffer_status_callback
+{
+   retro_audio_buffer_status_callback_t callback;
+};
+
 /* Performance related functions */
 
 /* ID values for SIMD CPU features */
@@ -1665,6 +1725,36 @@ enum retro_pixel_format
    RETRO_PIXEL_FORMAT_UNKNOWN  = INT_MAX
 };
 
+#define RETRO_MEMORY_ACCESS_WRITE (1 << 0)
+/* The core will write to the buffer provided by retro_framebuffer::data. */
+#define RETRO_MEMORY_ACCESS_READ (1 << 1)
+/* The core will read from retro_framebuffer::data. */
+#define RETRO_MEMORY_TYPE_CACHED (1 << 0)
+/* The memory in data is cached.
+ * If not cached, random writes and/or reading from the buffer is expected to be very slow. */
+struct retro_framebuffer
+{
+   void* data;                      /* The framebuffer which the core can render into.
+                                       Set by frontend in GET_CURRENT_SOFTWARE_FRAMEBUFFER.
+                                       The initial contents of data are unspecified. */
+   unsigned width;                  /* The framebuffer width used by the core. Set by core. */
+   unsigned height;                 /* The framebuffer height used by the core. Set by core. */
+   size_t pitch;                    /* The number of bytes between the beginning of a scanline,
+                                       and beginning of the next scanline.
+                                       Set by frontend in GET_CURRENT_SOFTWARE_FRAMEBUFFER. */
+   enum retro_pixel_format format;  /* The pixel format the core must use to render into data.
+                                       This format could differ from the format used in
+                                       SET_PIXEL_FORMAT.
+                                       Set by frontend in GET_CURRENT_SOFTWARE_FRAMEBUFFER. */
+
+   unsigned access_flags;           /* How the core will access the memory in the framebuffer.
+                                       RETRO_MEMORY_ACCESS_* flags.
+                                       Set by core. */
+   unsigned memory_flags;           /* Flags telling core how the memory has been mapped.
+                                       RETRO_MEMORY_TYPE_* flags.
+                                       Set by frontend in GET_CURRENT_SOFTWARE_FRAMEBUFFER. */
+};
+
 struct retro_message
 {
    const char* msg;        /* Message to be displayed. */
@@ -100,60 +100,72 @@ short C4WFY2Val;
 short C4WFDist;
 short C4WFScale;
 
-static double tanval;
-static double c4x, c4y, c4z;
-static double c4x2, c4y2, c4z2;
+// Wireframe angles count 1/128 turns and the shared sine tables 1/512
+// turns, both rotating clockwise. Coordinates are carried with 8 fraction
+// bits through the three rotations so the result only rounds once.
+#define C4_FRAC 8
 
-void C4TransfWireFrame()
+static int32_t C4Cos(int16_t Angle)
 {
-   c4x = (double) C4WFXVal;
-   c4y = (double) C4WFYVal;
-   c4z = (double) C4WFZVal - 0x95;
+   return C4CosTable[(Angle * 4) & 0x1ff];
+}
+
+static int32_t C4Sin(int16_t Angle)
+{
+   return -C4SinTable[(Angle * 4) & 0x1ff];
+}
+
+static void C4Rotate(int32_t* X, int32_t* Y, int32_t* Z)
+{
+   int32_t c, s, x2, y2, z2;
 
    // Rotate X
-   tanval = -(double) C4WFX2Val * 3.14159265 * 2 / 128;
-   c4y2 = c4y * cos(tanval) - c4z * sin(tanval);
-   c4z2 = c4y * sin(tanval) + c4z * cos(tanval);
+   c = C4Cos(C4WFX2Val);
+   s = C4Sin(C4WFX2Val);
+   y2 = (int32_t)(((int64_t) * Y * c - (int64_t) * Z * s) >> 15);
+   z2 = (int32_t)(((int64_t) * Y * s + (int64_t) * Z * c) >> 15);
 
    // Rotate Y
-   tanval = -(double)C4WFY2Val * 3.14159265 * 2 / 128;
-   c4x2 = c4x * cos(tanval) + c4z2 * sin(tanval);
-   c4z = c4x * - sin(tanval) + c4z2 * cos(tanval);
+   c = C4Cos(C4WFY2Val);
+   s = C4Sin(C4WFY2Val);
+   x2 = (int32_t)(((int64_t) * X * c + (int64_t) z2 * s) >> 15);
+   *Z = (int32_t)(((int64_t) z2 * c - (int64_t) * X * s) >> 15);
 
    // Rotate Z
-   tanval = -(double) C4WFDist * 3.14159265 * 2 / 128;
-   c4x = c4x2 * cos(tanval) - c4y2 * sin(tanval);
-   c4y = c4x2 * sin(tanval) + c4y2 * cos(tanval);
+   c = C4Cos(C4WFDist);
+   s = C4Sin(C4WFDist);
+   *X = (int32_t)(((int64_t) x2 * c - (int64_t) y2 * s) >> 15);
+   *Y = (int32_t)(((int64_t) x2 * s + (int64_t) y2 * c) >> 15);
+}
 
-   // Scale
-   C4WFXVal = (short)(c4x * (double)C4WFScale / (0x90 * (c4z + 0x95)) * 0x95);
-   C4WFYVal = (short)(c4y * (double)C4WFScale / (0x90 * (c4z + 0x95)) * 0x95);
+void C4TransfWireFrame()
+{
+   int32_t x = C4WFXVal << C4_FRAC;
+   int32_t y = C4WFYVal << C4_FRAC;
+   int32_t z = (C4WFZVal - 0x95) << C4_FRAC;
+   int64_t d;
+
+   C4Rotate(&x, &y, &z);
+
+   // Perspective scale
+   d = (int64_t) 0x90 * (z + (0x95 << C4_FRAC));
+   if (d == 0)
+      d = 1;
+   C4WFXVal = (short)((int64_t) x * C4WFScale * 0x95 / d);
+   C4WFYVal = (short)((int64_t) y * C4WFScale * 0x95 / d);
 }
 
 void C4TransfWireFrame2()
 {
-   c4x = (double)C4WFXVal;
-   c4y = (double)C4WFYVal;
-   c4z = (double)C4WFZVal;
+   int32_t x = C4WFXVal << C4_FRAC;
+   int32_t y = C4WFYVal << C4_FRAC;
+   int32_t z = C4WFZVal << C4_FRAC;
 
-   // Rotate X
-   tanval = -(double) C4WFX2Val * 3.14159265 * 2 / 128;
-   c4y2 = c4y * cos(tanval) - c4z * sin(tanval);
-   c4z2 = c4y * sin(tanval) + c4z * cos(tanval);
-
-   // Rotate Y
-   tanval = -(double) C4WFY2Val * 3.14159265 * 2 / 128;
-   c4x2 = c4x * cos(tanval) + c4z2 * sin(tanval);
-   c4z = c4x * -sin(tanval) + c4z2 * cos(tanval);
-
-   // Rotate Z
-   tanval = -(double)C4WFDist * 3.14159265 * 2 / 128;
-   c4x = c4x2 * cos(tanval) - c4y2 * sin(tanval);
-   c4y = c4x2 * sin(tanval) + c4y2 * cos(tanval);
+   C4Rotate(&x, &y, &z);
 
    // Scale
-   C4WFXVal = (short)(c4x * (double)C4WFScale / 0x100);
-   C4WFYVal = (short)(c4y * (double)C4WFScale / 0x100);
+   C4WFXVal = (short)((int64_t) x * C4WFScale / (0x100 << C4_FRAC));
+   C4WFYVal = (short)((int64_t) y * C4WFScale / (0x100 << C4_FRAC));
 }
 
 void C4CalcWireFrame()
@@ -163,7 +175,7 @@ void C4CalcWireFrame()
    if (abs(C4WFXVal) > abs(C4WFYVal))
    {
       C4WFDist = abs(C4WFXVal) + 1;
-      C4WFYVal = (short)(256 * (double) C4WFYVal / abs(C4WFXVal));
+      C4WFYVal = (short)(256 * C4WFYVal / abs(C4WFXVal));
       if (C4WFXVal < 0)
          C4WFXVal = -256;
       else
@@ -174,7 +186,7 @@ void C4CalcWireFrame()
       if (C4WFYVal != 0)
       {
          C4WFDist = abs(C4WFYVal) + 1;
-         C4WFXVal = (short)(256 * (double)C4WFXVal / abs(C4WFYVal));
+         C4WFXVal = (short)(256 * C4WFXVal / abs(C4WFYVal));
          if (C4WFYVal < 0)
             C4WFYVal = -256;
          else
@@ -191,6 +203,41 @@ short C41FAngleRes;
 short C41FDist;
 short C41FDistVal;
 
+// floor(sqrt(n)), bit by bit
+static uint32_t C4Sqrt(uint64_t n)
+{
+   uint64_t root = 0;
+   uint64_t bit = (uint64_t) 1 << 62;
+
+   while (bit > n)
+      bit >>= 2;
+   while (bit)
+   {
+      if (n >= root + bit)
+      {
+         n -= root + bit;
+         root = (root >> 1) + bit;
+      }
+      else
+         root >>= 1;
+      bit >>= 2;
+   }
+   return (uint32_t) root;
+}
+
+// C4AtanTable[k] is tan(k/512 turn) in 32.32 fixed point, the smallest ratio
+// |y|/|x| whose angle truncates to k. It is built with the same slightly
+// high value of pi the floating-point version used, so results match it.
+static uint64_t C4AtanTable[128];
+
+static void C4InitAtanTable()
+{
+   int k;
+   for (k = 1; k < 128; k++)
+      C4AtanTable[k] = (uint64_t)(tan(k * (3.141592675 * 2) / 512) * 4294967296.0);
+   C4AtanTable[0] = 1;
+}
+
 void C4Op1F()
 {
    if (C41FXVal == 0)
@@ -202,9 +249,24 @@ void C4Op1F()
    }
    else
    {
-      tanval = (double) C41FYVal / C41FXVal;
-      C41FAngleRes = (short)(atan(tanval) / (3.141592675 * 2) * 512);
-      C41FAngleRes = C41FAngleRes;
+      uint64_t x = abs(C41FXVal);
+      uint64_t y = (uint64_t) abs(C41FYVal) << 32;
+      int lo = 0, hi = 127;
+
+      if (!C4AtanTable[0])
+         C4InitAtanTable();
+
+      // largest k with tan(k) <= |y|/|x|
+      while (lo < hi)
+      {
+         int mid = (lo + hi + 1) >> 1;
+         if (C4AtanTable[mid] * x <= y)
+            lo = mid;
+         else
+            hi = mid - 1;
+      }
+
+      C41FAngleRes = ((C41FXVal < 0) != (C41FYVal < 0)) ? -lo : lo;
       if (C41FXVal < 0)
          C41FAngleRes += 0x100;
       C41FAngleRes &= 0x1FF;
@@ -213,16 +275,19 @@ void C4Op1F()
 
 void C4Op15()
 {
-   tanval = sqrt((double) C41FYVal * C41FYVal + (double) C41FXVal * C41FXVal);
-   C41FDist = (short) tanval;
+   C41FDist = (short) C4Sqrt((uint32_t)(C41FYVal * C41FYVal) + (uint32_t)(C41FXVal * C41FXVal));
 }
 
 void C4Op0D()
 {
-   tanval = sqrt((double) C41FYVal * C41FYVal + (double) C41FXVal * C41FXVal);
-   tanval = C41FDistVal / tanval;
-   C41FYVal = (short)(C41FYVal * tanval * 0.99);
-   C41FXVal = (short)(C41FXVal * tanval * 0.98);
+   // Scale (X, Y) to length C41FDistVal, with the same 0.98/0.99 fudge
+   // factors as before; the length is taken with 8 fraction bits.
+   uint32_t len = C4Sqrt((uint64_t)((uint32_t)(C41FYVal * C41FYVal) +
+                                    (uint32_t)(C41FXVal * C41FXVal)) << 16);
+   if (len == 0)
+      return;
+   C41FYVal = (short)((int64_t) C41FYVal * C41FDistVal * 99 * 256 / (100 * (int64_t) len));
+   C41FXVal = (short)((int64_t) C41FXVal * C41FDistVal * 98 * 256 / (100 * (int64_t) len));
 }
 
 #ifdef ZSNES_C4
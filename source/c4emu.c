@@ -89,7 +89,6 @@
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
-#include <math.h>
 #include "snes9x.h"
 #include "sar.h"
 #include "memmap.h"
@@ -293,42 +292,44 @@ static void C4DoScaleRotate(int row_padding)
    int32_t LineX = (Cx << 12) - Cx * A - Cx * B;
    int32_t LineY = (Cy << 12) - Cy * C - Cy * D;
 
-   // Start loop
+   // Start loop. Each output row is built eight pixels at a time in four
+   // bitplane bytes, which are then stored with one access per plane.
    uint32_t X, Y;
    uint8_t byte;
    int outidx = 0;
-   int x, y;
-   uint8_t bit = 0x80;
+   int x, y, b;
    for (y = 0; y < h; y++)
    {
       X = LineX;
       Y = LineY;
-      for (x = 0; x < w; x++)
+      for (x = 0; x < w; x += 8)
       {
-         if ((X >> 12) >= w || (Y >> 12) >= h)
-            byte = 0;
-         else
+         uint32_t p0 = 0, p1 = 0, p2 = 0, p3 = 0;
+         for (b = 0; b < 8; b++)
          {
-            uint32_t addr = (Y >> 12) * w + (X >> 12);
-            byte = Memory.C4RAM[0x600 + (addr >> 1)];
-            if (addr & 1) byte >>= 4;
-         }
+            if ((X >> 12) >= w || (Y >> 12) >= h)
+               byte = 0;
+            else
+            {
+               uint32_t addr = (Y >> 12) * w + (X >> 12);
+               byte = Memory.C4RAM[0x600 + (addr >> 1)];
+               if (addr & 1) byte >>= 4;
+            }
 
-         // De-bitplanify
-         if (byte & 1) Memory.C4RAM[outidx] |= bit;
-         if (byte & 2) Memory.C4RAM[outidx + 1] |= bit;
-         if (byte & 4) Memory.C4RAM[outidx + 16] |= bit;
-         if (byte & 8) Memory.C4RAM[outidx + 17] |= bit;
+            // De-bitplanify
+            p0 = (p0 << 1) | (byte & 1);
+            p1 = (p1 << 1) | ((byte >> 1) & 1);
+            p2 = (p2 << 1) | ((byte >> 2) & 1);
+            p3 = (p3 << 1) | ((byte >> 3) & 1);
 
-         bit >>= 1;
-         if (bit == 0)
-         {
-            bit = 0x80;
-            outidx += 32;
+            X += A; // Add 1 to output x => add an A and a C
+            Y += C;
          }
-
-         X += A; // Add 1 to output x => add an A and a C
-         Y += C;
+         Memory.C4RAM[outidx] |= p0;
+         Memory.C4RAM[outidx + 1] |= p1;
+         Memory.C4RAM[outidx + 16] |= p2;
+         Memory.C4RAM[outidx + 17] |= p3;
+         outidx += 32;
       }
       outidx += 2 + row_padding;
       if (outidx & 0x10)
@@ -378,8 +379,7 @@ static void C4DrawLine(int32_t X1, int32_t Y1, int16_t Z1,
       //.loop
       if (X1 > 0xff && Y1 > 0xff && X1 < 0x6000 && Y1 < 0x6000)
       {
-         uint16_t addr = ((X1 & ~0x7ff) + (Y1 & ~0x7ff) * 12 + (Y1 & 0x700)) >> 7;
-         addr = (((Y1 >> 8) >> 3) << 8) - (((Y1 >> 8) >> 3) << 6) + (((
+         uint16_t addr = (((Y1 >> 8) >> 3) << 8) - (((Y1 >> 8) >> 3) << 6) + (((
                    X1 >> 8) >> 3) << 4) + ((Y1 >> 8) & 7) * 2;
          uint8_t bit = 0x80 >> ((X1 >> 8) & 7);
          Memory.C4RAM[addr + 0x300] &= ~bit;
@@ -685,8 +685,7 @@ void S9xSetC4(uint8_t byte, uint16_t Address)
          case 0x15: // Pythagorean
             C41FXVal = READ_WORD(Memory.C4RAM + 0x1f80);
             C41FYVal = READ_WORD(Memory.C4RAM + 0x1f83);
-            C41FDist = (int16_t)sqrt((double)C41FXVal * C41FXVal + (double)C41FYVal *
-                                   C41FYVal);
+            C4Op15();
             WRITE_WORD(Memory.C4RAM + 0x1f80, C41FDist);
             break;
 
@@ -207,237 +207,160 @@ void S9xStartCheatSearch(SCheatData* d)
    memset((char*) d->IRAM_BITS, 0xff, 0x2000 >> 3);
 }
 
-#define BIT_CLEAR(a,v) \
-(a)[(v) >> 5] &= ~(1 << ((v) & 31))
-
 #define BIT_SET(a,v) \
 (a)[(v) >> 5] |= 1 << ((v) & 31)
 
 #define TEST_BIT(a,v) \
 ((a)[(v) >> 5] & (1 << ((v) & 31)))
 
-#define CHEATS_C(c,a,b) \
-((c) == S9X_LESS_THAN ? (a) < (b) : \
- (c) == S9X_GREATER_THAN ? (a) > (b) : \
- (c) == S9X_LESS_THAN_OR_EQUAL ? (a) <= (b) : \
- (c) == S9X_GREATER_THAN_OR_EQUAL ? (a) >= (b) : \
- (c) == S9X_EQUAL ? (a) == (b) : \
- (a) != (b))
-
-#define _D(s,m,o) \
-((s) == S9X_8_BITS ? (uint8_t) (*((m) + (o))) : \
- (s) == S9X_16_BITS ? ((uint16_t) (*((m) + (o)) + (*((m) + (o) + 1) << 8))) : \
- (s) == S9X_24_BITS ? ((uint32_t) (*((m) + (o)) + (*((m) + (o) + 1) << 8) + (*((m) + (o) + 2) << 16))) : \
-((uint32_t)  (*((m) + (o)) + (*((m) + (o) + 1) << 8) + (*((m) + (o) + 2) << 16) + (*((m) + (o) + 3) << 24))))
-
-#define _DS(s,m,o) \
-((s) == S9X_8_BITS ? ((int8_t) *((m) + (o))) : \
- (s) == S9X_16_BITS ? ((int16_t) (*((m) + (o)) + (*((m) + (o) + 1) << 8))) : \
- (s) == S9X_24_BITS ? (((int32_t) ((*((m) + (o)) + (*((m) + (o) + 1) << 8) + (*((m) + (o) + 2) << 16)) << 8)) >> 8): \
- ((int32_t) (*((m) + (o)) + (*((m) + (o) + 1) << 8) + (*((m) + (o) + 2) << 16) + (*((m) + (o) + 3) << 24))))
+/* Searches work on 32 addresses at a time, i.e. one word of the candidate
+ * bitmaps. A loader specialised on size and signedness widens the block into
+ * 32-bit keys (signed values get their sign bit flipped so every comparison
+ * can be done unsigned), then a kernel specialised on the comparison turns
+ * two key blocks into a result word. Both are fixed-length loops without
+ * branches so the compiler can vectorise them. Blocks with no candidates
+ * left are skipped without touching memory. */
+#define CHEAT_BLOCK 32
+
+typedef void (*CheatLoader)(uint32_t* key, const uint8_t* m);
+typedef uint32_t (*CheatCompare)(const uint32_t* a, const uint32_t* b);
+
+#define CHEAT_LOADER(name, expr) \
+static void name(uint32_t* key, const uint8_t* m) \
+{ \
+   int j; \
+   for (j = 0; j < CHEAT_BLOCK; j++) \
+      key [j] = (expr); \
+}
 
-void S9xSearchForChange(SCheatData* d, S9xCheatComparisonType cmp,
-                        S9xCheatDataSize size, bool is_signed, bool update)
+#define CHEAT_U16(j) ((uint32_t) m [j] | (m [(j) + 1] << 8))
+#define CHEAT_U24(j) (CHEAT_U16(j) | (m [(j) + 2] << 16))
+#define CHEAT_U32(j) (CHEAT_U24(j) | ((uint32_t) m [(j) + 3] << 24))
+
+CHEAT_LOADER(S9xCheatLoadU8, m [j])
+CHEAT_LOADER(S9xCheatLoadU16, CHEAT_U16(j))
+CHEAT_LOADER(S9xCheatLoadU24, CHEAT_U24(j))
+CHEAT_LOADER(S9xCheatLoadU32, CHEAT_U32(j))
+CHEAT_LOADER(S9xCheatLoadS8, (uint32_t)(int8_t) m [j] ^ 0x80000000)
+CHEAT_LOADER(S9xCheatLoadS16, (uint32_t)(int16_t) CHEAT_U16(j) ^ 0x80000000)
+CHEAT_LOADER(S9xCheatLoadS24, (uint32_t)((int32_t)(CHEAT_U24(j) << 8) >> 8) ^ 0x80000000)
+CHEAT_LOADER(S9xCheatLoadS32, CHEAT_U32(j) ^ 0x80000000)
+
+#define CHEAT_COMPARE(name, op) \
+static uint32_t name(const uint32_t* a, const uint32_t* b) \
+{ \
+   uint32_t result = 0; \
+   int j; \
+   for (j = 0; j < CHEAT_BLOCK; j++) \
+      result |= (uint32_t)(a [j] op b [j]) << j; \
+   return result; \
+}
+
+CHEAT_COMPARE(S9xCheatLess, <)
+CHEAT_COMPARE(S9xCheatGreater, >)
+CHEAT_COMPARE(S9xCheatLessEqual, <=)
+CHEAT_COMPARE(S9xCheatGreaterEqual, >=)
+CHEAT_COMPARE(S9xCheatEqual, ==)
+CHEAT_COMPARE(S9xCheatNotEqual, !=)
+
+static const CheatLoader S9xCheatLoaders [2][4] =
 {
-   int l;
+   { S9xCheatLoadU8, S9xCheatLoadU16, S9xCheatLoadU24, S9xCheatLoadU32 },
+   { S9xCheatLoadS8, S9xCheatLoadS16, S9xCheatLoadS24, S9xCheatLoadS32 }
+};
 
-   switch (size)
-   {
-   case S9X_8_BITS:
-      l = 0;
-      break;
-   case S9X_16_BITS:
-      l = 1;
-      break;
-   case S9X_24_BITS:
-      l = 2;
-      break;
-   default:
-   case S9X_32_BITS:
-      l = 3;
-      break;
-   }
+static const CheatCompare S9xCheatCompares [6] =
+{
+   S9xCheatLess, S9xCheatGreater, S9xCheatLessEqual,
+   S9xCheatGreaterEqual, S9xCheatEqual, S9xCheatNotEqual
+};
+
+// 'l' is the number of extra bytes a value of the searched size spans;
+// addresses whose value would run off the end of the region are left alone.
+// 'value' is NULL to compare against the snapshot instead.
+static void S9xCheatSearchRegion(uint32_t* bits, uint8_t* snap,
+                                 const uint8_t* mem, int size, int l,
+                                 CheatLoader load, CheatCompare compare,
+                                 const uint32_t* value, bool update)
+{
+   uint32_t a [CHEAT_BLOCK], b [CHEAT_BLOCK];
+   uint8_t tail_m [CHEAT_BLOCK + 3], tail_s [CHEAT_BLOCK + 3];
+   int count = size - l;
+   int base;
 
-   int i;
-   if (is_signed)
+   for (base = 0; base < count; base += CHEAT_BLOCK)
    {
-      for (i = 0; i < 0x20000 - l; i++)
-      {
-         if (TEST_BIT(d->WRAM_BITS, i) &&
-               CHEATS_C(cmp, _DS(size, d->RAM, i), _DS(size, d->CWRAM, i)))
-         {
-            if (update)
-               d->CWRAM [i] = d->RAM [i];
-         }
-         else
-            BIT_CLEAR(d->WRAM_BITS, i);
-      }
+      uint32_t* word = &bits [base >> 5];
+      if (!*word)
+         continue;
 
-      for (i = 0; i < 0x10000 - l; i++)
+      const uint8_t* m = mem + base;
+      const uint8_t* s = snap + base;
+      if (base + CHEAT_BLOCK + l > size)
       {
-         if (TEST_BIT(d->SRAM_BITS, i) &&
-               CHEATS_C(cmp, _DS(size, d->SRAM, i), _DS(size, d->CSRAM, i)))
-         {
-            if (update)
-               d->CSRAM [i] = d->SRAM [i];
-         }
-         else
-            BIT_CLEAR(d->SRAM_BITS, i);
+         memset(tail_m, 0, sizeof(tail_m));
+         memset(tail_s, 0, sizeof(tail_s));
+         memcpy(tail_m, m, size - base);
+         memcpy(tail_s, s, size - base);
+         m = tail_m;
+         s = tail_s;
       }
 
-      for (i = 0; i < 0x2000 - l; i++)
-      {
-         if (TEST_BIT(d->IRAM_BITS, i) &&
-               CHEATS_C(cmp, _DS(size, d->FillRAM + 0x3000, i), _DS(size, d->CIRAM, i)))
-         {
-            if (update)
-               d->CIRAM [i] = d->FillRAM [i + 0x3000];
-         }
-         else
-            BIT_CLEAR(d->IRAM_BITS, i);
-      }
-   }
-   else
-   {
-      for (i = 0; i < 0x20000 - l; i++)
-      {
-         if (TEST_BIT(d->WRAM_BITS, i) &&
-               CHEATS_C(cmp, _D(size, d->RAM, i), _D(size, d->CWRAM, i)))
-         {
-            if (update)
-               d->CWRAM [i] = d->RAM [i];
-         }
-         else
-            BIT_CLEAR(d->WRAM_BITS, i);
-      }
+      load(a, m);
+      if (!value)
+         load(b, s);
 
-      for (i = 0; i < 0x10000 - l; i++)
-      {
-         if (TEST_BIT(d->SRAM_BITS, i) &&
-               CHEATS_C(cmp, _D(size, d->SRAM, i), _D(size, d->CSRAM, i)))
-         {
-            if (update)
-               d->CSRAM [i] = d->SRAM [i];
-         }
-         else
-            BIT_CLEAR(d->SRAM_BITS, i);
-      }
+      uint32_t valid = count - base < CHEAT_BLOCK ?
+                       (1u << (count - base)) - 1 : ~0u;
+      uint32_t keep = *word & (compare(a, value ? value : b) | ~valid);
 
-      for (i = 0; i < 0x2000 - l; i++)
+      if (update)
       {
-         if (TEST_BIT(d->IRAM_BITS, i) &&
-               CHEATS_C(cmp, _D(size, d->FillRAM + 0x3000, i), _D(size, d->CIRAM, i)))
+         uint32_t u = keep & valid;
+         while (u)
          {
-            if (update)
-               d->CIRAM [i] = d->FillRAM [i + 0x3000];
+            int j = __builtin_ctz(u);
+            snap [base + j] = mem [base + j];
+            u &= u - 1;
          }
-         else
-            BIT_CLEAR(d->IRAM_BITS, i);
       }
+      *word = keep;
    }
 }
 
+static void S9xCheatSearch(SCheatData* d, S9xCheatComparisonType cmp,
+                           S9xCheatDataSize size, const uint32_t* value,
+                           bool is_signed, bool update)
+{
+   int l = size <= S9X_32_BITS ? size : S9X_32_BITS;
+   CheatLoader load = S9xCheatLoaders [is_signed ? 1 : 0][l];
+   CheatCompare compare = S9xCheatCompares [cmp <= S9X_NOT_EQUAL ? cmp :
+                                                  S9X_NOT_EQUAL];
+
+   S9xCheatSearchRegion(d->WRAM_BITS, d->CWRAM, d->RAM, 0x20000, l,
+                        load, compare, value, update);
+   S9xCheatSearchRegion(d->SRAM_BITS, d->CSRAM, d->SRAM, 0x10000, l,
+                        load, compare, value, update);
+   S9xCheatSearchRegion(d->IRAM_BITS, d->CIRAM, d->FillRAM + 0x3000, 0x2000, l,
+                        load, compare, value, update);
+}
+
+void S9xSearchForChange(SCheatData* d, S9xCheatComparisonType cmp,
+                        S9xCheatDataSize size, bool is_signed, bool update)
+{
+   S9xCheatSearch(d, cmp, size, NULL, is_signed, update);
+}
+
 void S9xSearchForValue(SCheatData* d, S9xCheatComparisonType cmp,
                        S9xCheatDataSize size, uint32_t value,
                        bool is_signed, bool update)
 {
-   int l;
-
-   switch (size)
-   {
-   case S9X_8_BITS:
-      l = 0;
-      break;
-   case S9X_16_BITS:
-      l = 1;
-      break;
-   case S9X_24_BITS:
-      l = 2;
-      break;
-   default:
-   case S9X_32_BITS:
-      l = 3;
-      break;
-   }
-
-   int i;
-
-   if (is_signed)
-   {
-      for (i = 0; i < 0x20000 - l; i++)
-      {
-         if (TEST_BIT(d->WRAM_BITS, i) &&
-               CHEATS_C(cmp, _DS(size, d->RAM, i), (int32_t) value))
-         {
-            if (update)
-               d->CWRAM [i] = d->RAM [i];
-         }
-         else
-            BIT_CLEAR(d->WRAM_BITS, i);
-      }
-
-      for (i = 0; i < 0x10000 - l; i++)
-      {
-         if (TEST_BIT(d->SRAM_BITS, i) &&
-               CHEATS_C(cmp, _DS(size, d->SRAM, i), (int32_t) value))
-         {
-            if (update)
-               d->CSRAM [i] = d->SRAM [i];
-         }
-         else
-            BIT_CLEAR(d->SRAM_BITS, i);
-      }
-
-      for (i = 0; i < 0x2000 - l; i++)
-      {
-         if (TEST_BIT(d->IRAM_BITS, i) &&
-               CHEATS_C(cmp, _DS(size, d->FillRAM + 0x3000, i), (int32_t) value))
-         {
-            if (update)
-               d->CIRAM [i] = d->FillRAM [i + 0x3000];
-         }
-         else
-            BIT_CLEAR(d->IRAM_BITS, i);
-      }
-   }
-   else
-   {
-      for (i = 0; i < 0x20000 - l; i++)
-      {
-         if (TEST_BIT(d->WRAM_BITS, i) &&
-               CHEATS_C(cmp, _D(size, d->RAM, i), value))
-         {
-            if (update)
-               d->CWRAM [i] = d->RAM [i];
-         }
-         else
-            BIT_CLEAR(d->WRAM_BITS, i);
-      }
+   uint32_t key [CHEAT_BLOCK];
+   int j;
 
-      for (i = 0; i < 0x10000 - l; i++)
-      {
-         if (TEST_BIT(d->SRAM_BITS, i) &&
-               CHEATS_C(cmp, _D(size, d->SRAM, i), value))
-         {
-            if (update)
-               d->CSRAM [i] = d->SRAM [i];
-         }
-         else
-            BIT_CLEAR(d->SRAM_BITS, i);
-      }
-
-      for (i = 0; i < 0x2000 - l; i++)
-      {
-         if (TEST_BIT(d->IRAM_BITS, i) &&
-               CHEATS_C(cmp, _D(size, d->FillRAM + 0x3000, i), value))
-         {
-            if (update)
-               d->CIRAM [i] = d->FillRAM [i + 0x3000];
-         }
-         else
-            BIT_CLEAR(d->IRAM_BITS, i);
-      }
-   }
+   for (j = 0; j < CHEAT_BLOCK; j++)
+      key [j] = is_signed ? value ^ 0x80000000 : value;
+   S9xCheatSearch(d, cmp, size, key, is_signed, update);
 }
 
 void S9xOutputCheatSearchResults(SCheatData* d)
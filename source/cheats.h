@@ -138,6 +138,7 @@ const char *S9xProActionReplayToRaw (const char *code, uint32_t *address, uint8_
 const char *S9xGoldFingerToRaw (const char *code, uint32_t *address, bool *sram,
 				uint8_t *num_bytes, uint8_t bytes[3]);
 void S9xApplyCheats(void);
+void S9xUpdateCheatList(void);
 void S9xApplyCheat (uint32_t which1);
 void S9xRemoveCheats ();
 void S9xRemoveCheat (uint32_t which1);
@@ -90,14 +90,130 @@
 #ifdef WANT_CHEATS
 
 #include <stdio.h>
+#include <stdlib.h>
 //#include <ctype.h>
 #include <string.h>
 #include "snes9x.h"
 #include "cheats.h"
 #include "memmap.h"
+#include "dma.h"
 
 extern SCheatData Cheat;
 
+// The enabled cheats, compiled by S9xUpdateCheatList. Cheats on ROM only
+// need writing once, so they are patched straight into the image and the
+// bytes they replaced are kept for undoing it; everything else is rewritten
+// by S9xApplyCheats every frame from an address sorted list. A NULL ptr means
+// the address has to go through the memory map each time, either because it
+// is not directly mapped, because the cartridge switches banks under us, or
+// because it is SuperFX RAM, which is locked away from the CPU while a GSU
+// session runs on its own thread.
+typedef struct
+{
+   uint32_t address;
+   uint32_t index;
+   uint8_t* ptr;
+   uint8_t  byte;
+} SCheatPatch;
+
+typedef struct
+{
+   uint8_t* ptr;
+   uint8_t  byte;
+} SCheatRestore;
+
+static SCheatPatch   CheatRAMPatches [MAX_CHEATS_T];
+static uint32_t      CheatRAMPatchCount = 0;
+static SCheatRestore CheatROMRestore [MAX_CHEATS_T];
+static uint32_t      CheatROMRestoreCount = 0;
+
+static int S9xCompareCheatPatches(const void* a, const void* b)
+{
+   const SCheatPatch* pa = (const SCheatPatch*) a;
+   const SCheatPatch* pb = (const SCheatPatch*) b;
+
+   if (pa->address != pb->address)
+      return pa->address < pb->address ? -1 : 1;
+   // Several codes on one address: the later one wins, as it always has.
+   return pa->index < pb->index ? -1 : pa->index > pb->index;
+}
+
+static void S9xRestoreROMCheats()
+{
+   if (CheatROMRestoreCount == 0)
+      return;
+
+   // Backwards, so that two codes on the same byte leave the original.
+   while (CheatROMRestoreCount > 0)
+   {
+      CheatROMRestoreCount--;
+      *CheatROMRestore [CheatROMRestoreCount].ptr = CheatROMRestore [CheatROMRestoreCount].byte;
+   }
+   S9xInvalidateHDMATables();
+}
+
+void S9xUpdateCheatList()
+{
+   uint32_t i;
+   bool bank_switched = Settings.SA1 || Settings.SDD1 || Settings.SPC7110;
+
+   S9xRestoreROMCheats();
+   CheatRAMPatchCount = 0;
+
+   for (i = 0; i < Cheat.num_cheats; i++)
+   {
+      uint32_t address;
+      int block;
+      uint8_t* ptr;
+
+      if (!Cheat.c [i].enabled)
+         continue;
+
+      address = Cheat.c [i].address;
+      if (!Cheat.c [i].saved)
+      {
+         Cheat.c [i].saved_byte = S9xGetByte(address);
+         Cheat.c [i].saved = true;
+      }
+
+      block = (address >> MEMMAP_SHIFT) & MEMMAP_MASK;
+      ptr = Memory.Map [block];
+
+      if (bank_switched || ptr < (uint8_t*) MAP_LAST)
+         ptr = NULL;
+      else
+         ptr += address & 0xffff;
+
+      if (Settings.SuperFX && ptr >= Memory.SRAM && ptr < Memory.SRAM + 0x20000)
+         ptr = NULL;
+
+      if (ptr && Memory.BlockIsROM [block])
+      {
+         if (!Settings.ApplyCheats)
+            continue;
+
+         CheatROMRestore [CheatROMRestoreCount].ptr = ptr;
+         CheatROMRestore [CheatROMRestoreCount].byte = *ptr;
+         CheatROMRestoreCount++;
+         *ptr = Cheat.c [i].byte;
+      }
+      else
+      {
+         CheatRAMPatches [CheatRAMPatchCount].address = address;
+         CheatRAMPatches [CheatRAMPatchCount].index = i;
+         CheatRAMPatches [CheatRAMPatchCount].ptr = ptr;
+         CheatRAMPatches [CheatRAMPatchCount].byte = Cheat.c [i].byte;
+         CheatRAMPatchCount++;
+      }
+   }
+
+   qsort(CheatRAMPatches, CheatRAMPatchCount, sizeof(CheatRAMPatches [0]),
+         S9xCompareCheatPatches);
+
+   if (CheatROMRestoreCount > 0)
+      S9xInvalidateHDMATables();
+}
+
 void S9xInitCheatData()
 {
    Cheat.RAM = Memory.RAM;
@@ -119,8 +235,9 @@ void S9xAddCheat(bool enable, bool save_current_value,
          Cheat.c [Cheat.num_cheats].saved = true;
       }
       Cheat.num_cheats++;
+      S9xUpdateCheatList();
       if (enable)
-         S9xApplyCheat(Cheat.num_cheats - 1);
+         S9xApplyCheats();
    }
 }
 
@@ -135,6 +252,7 @@ void S9xDeleteCheat(uint32_t which1)
       memmove(&Cheat.c [which1], &Cheat.c [which1 + 1],
               sizeof(Cheat.c [0]) * (Cheat.num_cheats - which1 - 1));
       Cheat.num_cheats--; //MK: This used to set it to 0??
+      S9xUpdateCheatList();
    }
 }
 
@@ -142,6 +260,7 @@ void S9xDeleteCheats()
 {
    S9xRemoveCheats();
    Cheat.num_cheats = 0;
+   S9xUpdateCheatList();
 }
 
 void S9xEnableCheat(uint32_t which1)
@@ -149,7 +268,8 @@ void S9xEnableCheat(uint32_t which1)
    if (which1 < Cheat.num_cheats && !Cheat.c [which1].enabled)
    {
       Cheat.c [which1].enabled = true;
-      S9xApplyCheat(which1);
+      S9xUpdateCheatList();
+      S9xApplyCheats();
    }
 }
 
@@ -159,6 +279,7 @@ void S9xDisableCheat(uint32_t which1)
    {
       S9xRemoveCheat(which1);
       Cheat.c [which1].enabled = false;
+      S9xUpdateCheatList();
    }
 }
 
@@ -177,6 +298,7 @@ void S9xRemoveCheat(uint32_t which1)
          S9xSetByte(Cheat.c [which1].saved_byte, address);
       // Unsave the address for the next call to S9xRemoveCheat.
       Cheat.c [which1].saved = false;
+      S9xInvalidateHDMATables();
    }
 }
 
@@ -195,16 +317,30 @@ void S9xApplyCheat(uint32_t which1)
    else
       S9xSetByte(Cheat.c [which1].byte, address);
    Cheat.c [which1].saved = true;
+   S9xInvalidateHDMATables();
 }
 
 void S9xApplyCheats()
 {
-   uint32_t i;
-   if (Settings.ApplyCheats)
+   const SCheatPatch* p = CheatRAMPatches;
+   const SCheatPatch* end = CheatRAMPatches + CheatRAMPatchCount;
+
+   if (!Settings.ApplyCheats)
+      return;
+
+   for (; p < end; p++)
    {
-      for (i = 0; i < Cheat.num_cheats; i++)
-         if (Cheat.c [i].enabled)
-            S9xApplyCheat(i);
+      if (p->ptr)
+         *p->ptr = p->byte;
+      else
+      {
+         uint8_t* ptr = Memory.Map [(p->address >> MEMMAP_SHIFT) & MEMMAP_MASK];
+
+         if (ptr >= (uint8_t*) MAP_LAST)
+            *(ptr + (p->address & 0xffff)) = p->byte;
+         else
+            S9xSetByte(p->byte, p->address);
+      }
    }
 }
 
@@ -220,6 +356,10 @@ bool S9xLoadCheatFile(const char* filename)
 {
    Cheat.num_cheats = 0;
 
+   // A new image has just been loaded, so there is nothing left to restore.
+   CheatROMRestoreCount = 0;
+   CheatRAMPatchCount = 0;
+
    FILE* fs = fopen(filename, "rb");
    uint8_t data [8 + MAX_SFCCHEAT_NAME];
 
@@ -244,6 +384,7 @@ bool S9xLoadCheatFile(const char* filename)
       Cheat.c [Cheat.num_cheats++].name [MAX_SFCCHEAT_NAME - 1] = 0;
    }
    fclose(fs);
+   S9xUpdateCheatList();
 
    return (true);
 }
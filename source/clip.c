@@ -113,25 +113,47 @@ struct Band
     R.Left = MAX(A.Left, B.Left); \
       R.Right = MIN(A.Right, B.Right);}
 
-static int IntCompare(const void* d1, const void* d2)
+// Everything the clip windows are computed from.
+struct ClipKey
 {
-   if (*(uint32_t*) d1 > *(uint32_t*) d2)
-      return (1);
-   else if (*(uint32_t*) d1 < * (uint32_t*) d2)
-      return (-1);
-   return (0);
-}
+   uint8_t r2130;
+   uint8_t r212c [4];
+   uint8_t Window1Left;
+   uint8_t Window1Right;
+   uint8_t Window2Left;
+   uint8_t Window2Right;
+   uint8_t OverlapLogic [6];
+   uint8_t Window1Enable [6];
+   uint8_t Window2Enable [6];
+   uint8_t Window1Inside [6];
+   uint8_t Window2Inside [6];
+};
+
+// Window settings that HDMA changes per line tend to cycle through the same
+// handful of values every frame, so recently computed results are kept.
+#define CLIP_CACHE_SIZE 64
+
+struct ClipCacheEntry
+{
+   bool Valid;
+   struct ClipKey Key;
+   struct ClipData Clip [2];
+};
+
+static struct ClipCacheEntry ClipCache [CLIP_CACHE_SIZE];
+static struct ClipKey LastClipKey;
+static bool LastClipKeyValid = false;
 
-static int BandCompare(const void* d1, const void* d2)
+// Returns edge i of a window's bands; the bands of one window are already
+// in left-to-right order.
+static uint32_t BandEdge(const struct Band* Win, uint32_t Count, uint32_t i)
 {
-   if (((struct Band*) d1)->Left > ((struct Band*) d2)->Left)
-      return (1);
-   else if (((struct Band*) d1)->Left < ((struct Band*) d2)->Left)
-      return (-1);
-   return (0);
+   if (i >= Count * 2)
+      return 0xffffffff;
+   return (i & 1) ? Win[i >> 1].Right : Win[i >> 1].Left;
 }
 
-void ComputeClipWindows()
+static void BuildClipWindows()
 {
    struct ClipData* pClip = &IPPU.Clip [0];
    int c, w, i;
@@ -479,25 +501,29 @@ void ComputeClipWindows()
                      {
                         uint32_t p = 0;
                         uint32_t points [10];
-                        uint32_t i;
+                        uint32_t i, k;
 
                         invert = !invert;
-                        // Build an array of points (window edges)
+                        // Build a sorted array of points (window edges) by
+                        // merging the two windows' edges, which are each
+                        // in order already.
                         points [p++] = 0;
-                        for (i = 0; i < Window1Enabled; i++)
-                        {
-                           points [p++] = Win1[i].Left;
-                           points [p++] = Win1[i].Right;
-                        }
-                        for (i = 0; i < Window2Enabled; i++)
+                        for (i = 0, k = 0; i < Window1Enabled * 2 || k < Window2Enabled * 2;)
                         {
-                           points [p++] = Win2[i].Left;
-                           points [p++] = Win2[i].Right;
+                           uint32_t e1 = BandEdge(Win1, Window1Enabled, i);
+                           uint32_t e2 = BandEdge(Win2, Window2Enabled, k);
+                           if (e1 <= e2)
+                           {
+                              points [p++] = e1;
+                              i++;
+                           }
+                           else
+                           {
+                              points [p++] = e2;
+                              k++;
+                           }
                         }
                         points [p++] = 256;
-                        // Sort them
-                        qsort((void*) points, p, sizeof(points [0]),
-                              IntCompare);
                         for (i = 0; i < p; i += 2)
                         {
                            if (points [i] == points [i + 1])
@@ -555,10 +581,16 @@ void ComputeClipWindows()
                         }
                         else
                         {
-                           // Now sort the bands into order
+                           // Now sort the bands into order; there are
+                           // at most three of them.
                            B = j;
-                           qsort((void*) Bands, B,
-                                 sizeof(Bands [0]), BandCompare);
+                           for (b = 1; b < B; b++)
+                           {
+                              struct Band t = Bands[b];
+                              for (j = b; j > 0 && Bands[j - 1].Left > t.Left; j--)
+                                 Bands[j] = Bands[j - 1];
+                              Bands[j] = t;
+                           }
 
                            // Now invert the area the bands cover
                            j = 0;
@@ -763,3 +795,55 @@ Clip_ok:
    } // for (int c...
 }
 
+// IPPU.Clip was cleared or the PPU state replaced behind our back (reset,
+// snapshot load), so nothing remembered about the windows can be trusted.
+void S9xResetClipCache()
+{
+   LastClipKeyValid = false;
+   memset(ClipCache, 0, sizeof(ClipCache));
+}
+
+void ComputeClipWindows()
+{
+   struct ClipKey Key;
+   struct ClipCacheEntry* Entry;
+   uint32_t Hash = 2166136261u;
+   uint32_t i;
+
+   Key.r2130 = Memory.FillRAM [0x2130] & 0xf0;
+   memcpy(Key.r212c, &Memory.FillRAM [0x212c], sizeof(Key.r212c));
+   Key.Window1Left = PPU.Window1Left;
+   Key.Window1Right = PPU.Window1Right;
+   Key.Window2Left = PPU.Window2Left;
+   Key.Window2Right = PPU.Window2Right;
+   for (i = 0; i < 6; i++)
+   {
+      Key.OverlapLogic [i] = PPU.ClipWindowOverlapLogic [i];
+      Key.Window1Enable [i] = PPU.ClipWindow1Enable [i];
+      Key.Window2Enable [i] = PPU.ClipWindow2Enable [i];
+      Key.Window1Inside [i] = PPU.ClipWindow1Inside [i];
+      Key.Window2Inside [i] = PPU.ClipWindow2Inside [i];
+   }
+
+   // Most requests (one per frame, and writes that change nothing the
+   // windows depend on) leave IPPU.Clip as it is.
+   if (LastClipKeyValid && memcmp(&Key, &LastClipKey, sizeof(Key)) == 0)
+      return;
+   LastClipKey = Key;
+   LastClipKeyValid = true;
+
+   for (i = 0; i < sizeof(Key); i++)
+      Hash = (Hash ^ ((uint8_t*) &Key) [i]) * 16777619u;
+   Entry = &ClipCache [(Hash ^ (Hash >> 16)) & (CLIP_CACHE_SIZE - 1)];
+
+   if (Entry->Valid && memcmp(&Entry->Key, &Key, sizeof(Key)) == 0)
+   {
+      memcpy(IPPU.Clip, Entry->Clip, sizeof(IPPU.Clip));
+      return;
+   }
+
+   BuildClipWindows();
+   Entry->Valid = true;
+   Entry->Key = Key;
+   memcpy(Entry->Clip, IPPU.Clip, sizeof(IPPU.Clip));
+}
@@ -108,6 +108,7 @@ extern struct FxInit_s SuperFX;
 
 void S9xResetSuperFX()
 {
+   S9xSuperFXSync();
    SuperFX.vFlags = 0; //FX_FLAG_ROM_BUFFER;// | FX_FLAG_ADDRESS_CHECKING;
    FxReset(&SuperFX);
 }
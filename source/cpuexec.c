@@ -194,8 +194,6 @@ void S9xMainLoop_SA1_SFX(void)
 
       (*ICPU.S9xOpcodes [*CPU.PC++].S9xOpcode)();
 
-      if (SA1.Executing)
-         S9xSA1MainLoop();
       DO_HBLANK_CHECK_SFX();
    }
 
@@ -291,8 +289,6 @@ void S9xMainLoop_SA1_NoSFX(void)
 
       (*ICPU.S9xOpcodes [*CPU.PC++].S9xOpcode)();
 
-      if (SA1.Executing)
-         S9xSA1MainLoop();
       DO_HBLANK_CHECK_NoSFX();
    }
 
@@ -531,6 +527,8 @@ void S9xClearIRQ(uint32_t source)
  */
 void S9xDoHBlankProcessing_SFX()
 {
+   if (Settings.SA1)
+      S9xSA1Sync();
 #ifdef CPU_SHUTDOWN
    CPU.WaitCounter++;
 #endif
@@ -566,6 +564,7 @@ void S9xDoHBlankProcessing_SFX()
       CPU.Cycles -= Settings.H_Max;
       S9xAPUSetReferenceTime(CPU.Cycles);
 #endif
+      SA1Cycles -= Settings.H_Max;
       CPU.NextEvent = -1;
       ICPU.Scanline++;
 
@@ -715,6 +714,8 @@ void S9xDoHBlankProcessing_SFX()
 }
 void S9xDoHBlankProcessing_NoSFX()
 {
+   if (Settings.SA1)
+      S9xSA1Sync();
 #ifdef CPU_SHUTDOWN
    CPU.WaitCounter++;
 #endif
@@ -749,6 +750,7 @@ void S9xDoHBlankProcessing_NoSFX()
       CPU.Cycles -= Settings.H_Max;
       S9xAPUSetReferenceTime(CPU.Cycles);
 #endif
+      SA1Cycles -= Settings.H_Max;
 
       CPU.NextEvent = -1;
       ICPU.Scanline++;
@@ -103,6 +103,7 @@
 #include "spc7110.h"
 
 #ifdef SDD1_DECOMP
+#include "sdd1.h"
 #include "sdd1emu.h"
 #endif
 
@@ -120,6 +121,149 @@ extern uint8_t* HDMABasePointers [8];
 uint32_t HDMARawPointers[8]; // Cart address space pointer
 #endif
 
+#ifndef SETA010_HDMA_FROM_CART
+/* HDMA tables that live in ROM cannot change under us, so at the start of
+ * each frame they are parsed once into a list of entries holding the line
+ * count byte, the resolved indirect address and the data pointer. The
+ * per-line loop then only has to check that the channel is still pointing
+ * where the list says it is. Tables in RAM, and carts that bank-switch their
+ * ROM, keep using the live walk through S9xGetByte(). */
+#define HDMA_MAX_ENTRIES 256
+
+typedef struct
+{
+   uint8_t* Data;
+   uint16_t Address;
+   uint16_t IndirectAddress;
+   uint8_t  Line;
+} SHDMAEntry;
+
+typedef struct
+{
+   uint16_t Count;
+   uint16_t Next;
+   uint16_t AAddress;
+   uint8_t  ABank;
+   uint8_t  IndirectBank;
+   uint8_t  TransferMode;
+   bool     Indirect;
+} SHDMATable;
+
+static SHDMAEntry HDMAEntries [8][HDMA_MAX_ENTRIES];
+static SHDMATable HDMATables [8];
+
+static INLINE uint8_t* S9xHDMAROMPointer(uint32_t Address)
+{
+   int block = (Address >> MEMMAP_SHIFT) & MEMMAP_MASK;
+   uint8_t* GetAddress = Memory.Map [block];
+
+   if (!Memory.BlockIsROM [block] || GetAddress < (uint8_t*) MAP_LAST)
+      return NULL;
+   return GetAddress + (Address & 0xffff);
+}
+
+static void S9xCompileHDMATable(uint8_t Channel)
+{
+   SDMA* p = &DMA [Channel];
+   SHDMATable* t = &HDMATables [Channel];
+   uint8_t IndirectBank = Memory.FillRAM [0x4307 + (Channel << 4)];
+
+   t->Next = 0;
+   if (t->Count && t->ABank == p->ABank && t->AAddress == p->AAddress &&
+         t->Indirect == p->HDMAIndirectAddressing &&
+         t->TransferMode == p->TransferMode &&
+         (!t->Indirect || t->IndirectBank == IndirectBank))
+      return;
+
+   t->Count = 0;
+   if (Settings.SA1 || Settings.SDD1 || Settings.SPC7110 || p->TransferMode > 7)
+      return;
+
+   uint32_t bank = p->ABank << 16;
+   uint16_t address = p->AAddress;
+   int lines = 0;
+   int n;
+   for (n = 0; n < HDMA_MAX_ENTRIES; n++)
+   {
+      SHDMAEntry* e = &HDMAEntries [Channel][n];
+      uint8_t* line = S9xHDMAROMPointer(bank + address);
+      if (!line)
+         return;
+
+      e->Address = address;
+      e->Line = *line;
+      e->Data = NULL;
+      e->IndirectAddress = 0;
+
+      int count = e->Line == 0x80 ? 128 : e->Line & 0x7f;
+      if (!count)
+      {
+         n++;
+         break;
+      }
+
+      address++;
+      if (p->HDMAIndirectAddressing)
+      {
+         uint8_t* lo = S9xHDMAROMPointer(bank + address);
+         uint8_t* hi = S9xHDMAROMPointer(bank + (uint16_t)(address + 1));
+         if (!lo || !hi || address == 0xffff)
+            return;
+         e->IndirectAddress = *lo | (*hi << 8);
+         e->Data = S9xGetMemPointer((IndirectBank << 16) + e->IndirectAddress);
+         address += 2;
+      }
+      else
+      {
+         e->IndirectAddress = address;
+         e->Data = S9xGetMemPointer(bank + address);
+         if (e->Line != 0x80 && (e->Line & 0x80))
+            address += HDMA_ModeByteCounts [p->TransferMode] * count;
+         else
+            address += HDMA_ModeByteCounts [p->TransferMode];
+      }
+
+      // Nothing past the end of the frame will ever be fetched.
+      lines += count;
+      if (lines >= 256)
+      {
+         n++;
+         break;
+      }
+   }
+
+   t->Count = n;
+   t->ABank = p->ABank;
+   t->AAddress = p->AAddress;
+   t->IndirectBank = IndirectBank;
+   t->TransferMode = p->TransferMode;
+   t->Indirect = p->HDMAIndirectAddressing;
+}
+
+/* The contents of an entry depend only on where it sits in ROM, so as long as
+ * the channel still points at the next compiled entry it can be used no matter
+ * what the game did to the DMA registers in between. */
+static INLINE const SHDMAEntry* S9xNextHDMAEntry(uint8_t Channel)
+{
+   SDMA* p = &DMA [Channel];
+   SHDMATable* t = &HDMATables [Channel];
+
+   if (t->Next >= t->Count)
+      return NULL;
+
+   const SHDMAEntry* e = &HDMAEntries [Channel][t->Next];
+   if (e->Address != p->Address || t->ABank != p->ABank ||
+         t->Indirect != p->HDMAIndirectAddressing ||
+         (t->Indirect && t->IndirectBank != Memory.FillRAM [0x4307 + (Channel << 4)]))
+   {
+      t->Next = t->Count;
+      return NULL;
+   }
+   t->Next++;
+   return e;
+}
+#endif
+
 #if defined(__linux__) || defined(__WIN32__)
 static int S9xCompareSDD1IndexEntries(const void* p1, const void* p2)
 {
@@ -143,7 +287,6 @@ void S9xDoDMA(uint8_t Channel)
    bool in_sa1_dma = false;
    uint8_t* in_sdd1_dma = NULL;
    uint8_t* spc7110_dma = NULL;
-   bool s7_wrap = false;
    SDMA* d = &DMA[Channel];
 
 
@@ -183,12 +326,18 @@ void S9xDoDMA(uint8_t Channel)
          inc = !d->AAddressDecrement ? 1 : -1;
 
          uint8_t *in_ptr = GetBasePointer(((d->ABank << 16) | d->AAddress));
+         in_sdd1_dma = sdd1_decode_buffer;
          if (in_ptr)
          {
                in_ptr += d->AAddress;
-               SDD1_decompress(sdd1_decode_buffer, in_ptr, d->TransferBytes);
+               // A decrementing transfer wraps round to the end of the
+               // buffer, which only the full-size decode buffer covers.
+               if (inc > 0)
+                  in_sdd1_dma = S9xSDD1Decompress(sdd1_decode_buffer, in_ptr,
+                                                  d->TransferBytes);
+               else
+                  SDD1_decompress(sdd1_decode_buffer, in_ptr, d->TransferBytes);
          }
-         in_sdd1_dma = sdd1_decode_buffer;
       }
 
       Memory.FillRAM [0x4801] = 0;
@@ -196,29 +345,12 @@ void S9xDoDMA(uint8_t Channel)
 #endif   
    if (Settings.SPC7110 && (d->AAddress == 0x4800 || d->ABank == 0x50))
    {
-      uint32_t i, j;
-      i = (s7r.reg4805 | (s7r.reg4806 << 8));
-      i *= s7r.AlignBy;
-      i += s7r.bank50Internal;
-      i %= DECOMP_BUFFER_SIZE;
-      j = 0;
-      if ((i + d->TransferBytes) < DECOMP_BUFFER_SIZE)
-         spc7110_dma = &s7r.bank50[i];
-      else
-      {
-         spc7110_dma = (uint8_t*)malloc(d->TransferBytes);
-         j = DECOMP_BUFFER_SIZE - i;
-         memcpy(spc7110_dma, &s7r.bank50[i], j);
-         memcpy(&spc7110_dma[j], s7r.bank50, d->TransferBytes - j);
-         s7_wrap = true;
-      }
       int icount = s7r.reg4809 | (s7r.reg480A << 8);
       icount -= d->TransferBytes;
       s7r.reg4809 = 0x00ff & icount;
       s7r.reg480A = (0xff00 & icount) >> 8;
 
-      s7r.bank50Internal += d->TransferBytes;
-      s7r.bank50Internal %= DECOMP_BUFFER_SIZE;
+      spc7110_dma = S9xSpc7110Decompress(count);
       inc = 1;
       d->AAddress -= count;
    }
@@ -258,24 +390,10 @@ void S9xDoDMA(uint8_t Channel)
             for (j = 0; j < char_count && p - buffer < count;
                   j++, line += 2)
             {
-               int b, l;
                uint8_t* q = line;
-               for (l = 0; l < 8; l++, q += bytes_per_line)
-               {
-                  for (b = 0; b < 2; b++)
-                  {
-                     uint8_t r = *(q + b);
-                     *(p + 0) = (*(p + 0) << 1) | ((r >> 0) & 1);
-                     *(p + 1) = (*(p + 1) << 1) | ((r >> 1) & 1);
-                     *(p + 0) = (*(p + 0) << 1) | ((r >> 2) & 1);
-                     *(p + 1) = (*(p + 1) << 1) | ((r >> 3) & 1);
-                     *(p + 0) = (*(p + 0) << 1) | ((r >> 4) & 1);
-                     *(p + 1) = (*(p + 1) << 1) | ((r >> 5) & 1);
-                     *(p + 0) = (*(p + 0) << 1) | ((r >> 6) & 1);
-                     *(p + 1) = (*(p + 1) << 1) | ((r >> 7) & 1);
-                  }
-                  p += 2;
-               }
+               int l;
+               for (l = 0; l < 8; l++, q += bytes_per_line, p += 2)
+                  S9xSA1PackedRowToPlanar(p, q, 2);
             }
          }
          break;
@@ -289,23 +407,9 @@ void S9xDoDMA(uint8_t Channel)
                   j++, line += 4)
             {
                uint8_t* q = line;
-               int b, l;
-               for (l = 0; l < 8; l++, q += bytes_per_line)
-               {
-                  for (b = 0; b < 4; b++)
-                  {
-                     uint8_t r = *(q + b);
-                     *(p +  0) = (*(p +  0) << 1) | ((r >> 0) & 1);
-                     *(p +  1) = (*(p +  1) << 1) | ((r >> 1) & 1);
-                     *(p + 16) = (*(p + 16) << 1) | ((r >> 2) & 1);
-                     *(p + 17) = (*(p + 17) << 1) | ((r >> 3) & 1);
-                     *(p +  0) = (*(p +  0) << 1) | ((r >> 4) & 1);
-                     *(p +  1) = (*(p +  1) << 1) | ((r >> 5) & 1);
-                     *(p + 16) = (*(p + 16) << 1) | ((r >> 6) & 1);
-                     *(p + 17) = (*(p + 17) << 1) | ((r >> 7) & 1);
-                  }
-                  p += 2;
-               }
+               int l;
+               for (l = 0; l < 8; l++, q += bytes_per_line, p += 2)
+                  S9xSA1PackedRowToPlanar(p, q, 4);
                p += 32 - 16;
             }
          }
@@ -320,23 +424,9 @@ void S9xDoDMA(uint8_t Channel)
                   j++, line += 8)
             {
                uint8_t* q = line;
-               int b, l;
-               for (l = 0; l < 8; l++, q += bytes_per_line)
-               {
-                  for (b = 0; b < 8; b++)
-                  {
-                     uint8_t r = *(q + b);
-                     *(p +  0) = (*(p +  0) << 1) | ((r >> 0) & 1);
-                     *(p +  1) = (*(p +  1) << 1) | ((r >> 1) & 1);
-                     *(p + 16) = (*(p + 16) << 1) | ((r >> 2) & 1);
-                     *(p + 17) = (*(p + 17) << 1) | ((r >> 3) & 1);
-                     *(p + 32) = (*(p + 32) << 1) | ((r >> 4) & 1);
-                     *(p + 33) = (*(p + 33) << 1) | ((r >> 5) & 1);
-                     *(p + 48) = (*(p + 48) << 1) | ((r >> 6) & 1);
-                     *(p + 49) = (*(p + 49) << 1) | ((r >> 7) & 1);
-                  }
-                  p += 2;
-               }
+               int l;
+               for (l = 0; l < 8; l++, q += bytes_per_line, p += 2)
+                  S9xSA1PackedRowToPlanar(p, q, 8);
                p += 64 - 16;
             }
          }
@@ -393,6 +483,11 @@ void S9xDoDMA(uint8_t Channel)
          switch (d->BAddress)
          {
          case 0x04:
+            if (inc > 0 && p + count <= 0x10000)
+            {
+               S9xOAMBlockWrite(base + p, count);
+               break;
+            }
             do
             {
                Work = *(base + p);
@@ -457,6 +552,11 @@ void S9xDoDMA(uint8_t Channel)
             }
             break;
          case 0x22:
+            if (inc > 0 && p + count <= 0x10000)
+            {
+               S9xCGRAMBlockWrite(base + p, count);
+               break;
+            }
             do
             {
                Work = *(base + p);
@@ -496,7 +596,10 @@ void S9xDoDMA(uint8_t Channel)
 #ifndef CORRECT_VRAM_READS
             IPPU.FirstVRAMRead = true;
 #endif
-            if (!PPU.VMA.FullGraphicCount)
+            if (!PPU.VMA.FullGraphicCount && PPU.VMA.High && PPU.VMA.Increment == 1 &&
+                  inc > 0 && p + count <= 0x10000)
+               S9xVRAMBlockWrite(base + p, count);
+            else if (!PPU.VMA.FullGraphicCount)
             {
                while (count > 1)
                {
@@ -729,12 +832,6 @@ void S9xDoDMA(uint8_t Channel)
       while (CPU.Cycles > CPU.NextEvent)
          S9xDoHBlankProcessing_NoSFX();
 
-   if (Settings.SPC7110 && spc7110_dma)
-   {
-      if (spc7110_dma && s7_wrap)
-         free(spc7110_dma);
-   }
-
 update_address:
    // Super Punch-Out requires that the A-BUS address be updated after the
    // DMA transfer.
@@ -778,6 +875,9 @@ void S9xStartHDMA()
          DMA [i].Address = DMA [i].AAddress;
          if (DMA[i].HDMAIndirectAddressing)
             CPU.Cycles += (SLOW_ONE_CYCLE << 2);
+#ifndef SETA010_HDMA_FROM_CART
+         S9xCompileHDMATable(i);
+#endif
       }
       HDMAMemPointers [i] = NULL;
 #ifdef SETA010_HDMA_FROM_CART
@@ -804,7 +904,12 @@ uint8_t S9xDoHDMA(uint8_t byte)
             //remember, InDMA is set.
             //Get/Set incur no charges!
             CPU.Cycles += SLOW_ONE_CYCLE;
+#ifndef SETA010_HDMA_FROM_CART
+            const SHDMAEntry* e = S9xNextHDMAEntry(d);
+            uint8_t line = e ? e->Line : S9xGetByte((p->ABank << 16) + p->Address);
+#else
             uint8_t line = S9xGetByte((p->ABank << 16) + p->Address);
+#endif
             if (line == 0x80)
             {
                p->Repeat = true;
@@ -840,7 +945,12 @@ uint8_t S9xDoHDMA(uint8_t byte)
                p->IndirectBank = Memory.FillRAM [0x4307 + (d << 4)];
                //again, no cycle charges while InDMA is set!
                CPU.Cycles += SLOW_ONE_CYCLE << 2;
+#ifndef SETA010_HDMA_FROM_CART
+               p->IndirectAddress = e ? e->IndirectAddress :
+                                    S9xGetWord((p->ABank << 16) + p->Address);
+#else
                p->IndirectAddress = S9xGetWord((p->ABank << 16) + p->Address);
+#endif
                p->Address += 2;
             }
             else
@@ -848,10 +958,13 @@ uint8_t S9xDoHDMA(uint8_t byte)
                p->IndirectBank = p->ABank;
                p->IndirectAddress = p->Address;
             }
+#ifdef SETA010_HDMA_FROM_CART
             HDMABasePointers [d] = HDMAMemPointers [d] =
                                       S9xGetMemPointer((p->IndirectBank << 16) + p->IndirectAddress);
-#ifdef SETA010_HDMA_FROM_CART
             HDMARawPointers [d] = (p->IndirectBank << 16) + p->IndirectAddress;
+#else
+            HDMABasePointers [d] = HDMAMemPointers [d] = e ? e->Data :
+                                      S9xGetMemPointer((p->IndirectBank << 16) + p->IndirectAddress);
 #endif
          }
          else
@@ -1016,4 +1129,13 @@ void S9xResetDMA()
 
       Memory.FillRAM [c + 0xf] = 0xff;
    }
+   S9xInvalidateHDMATables();
+}
+
+/* Must be called whenever ROM bytes are patched at run time (cheats). */
+void S9xInvalidateHDMATables()
+{
+#ifndef SETA010_HDMA_FROM_CART
+   memset(HDMATables, 0, sizeof(HDMATables));
+#endif
 }
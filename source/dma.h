@@ -94,6 +94,7 @@ void S9xResetDMA(void);
 uint8_t S9xDoHDMA(uint8_t);
 void S9xStartHDMA();
 void S9xDoDMA(uint8_t);
+void S9xInvalidateHDMATables();
 
 #endif
 
@@ -119,6 +119,7 @@ void S9xResetDSP1()
    DSP1.in_index = 0;
    DSP1.out_index = 0;
    DSP1.first_parameter = true;
+   DSP1_InvalidateRaster();
 }
 
 uint8_t S9xGetDSP(uint16_t address)
@@ -33,9 +33,6 @@
 //#define printinfo
 //#define debug06
 
-#define __OPT__
-#define __OPT06__
-
 #ifdef DebugDSP1
 
 FILE* LogFile = NULL;
@@ -211,25 +208,10 @@ const unsigned short DSP1ROM[1024] =
 *  Math tables                                                              *
 \***************************************************************************/
 
-#define INCR 2048
-#define Angle(x) (((x)/(65536/INCR)) & (INCR-1))
-#define Cos(x) ((double) CosTable2[x])
-#define Sin(x) ((double) SinTable2[x])
 #ifdef PI
 #undef PI
 #endif
 #define PI 3.1415926535897932384626433832795
-double CosTable2[INCR];
-double SinTable2[INCR];
-
-
-double Atan(double x)
-{
-   if ((x >= 1) || (x <= 1))
-      return (x / (1 + 0.28 * x * x));
-   else
-      return (PI / 2 - Atan(1 / x));
-}
 
 #ifdef __ZSNES__
 /***************************************************************************\
@@ -366,14 +348,6 @@ void C4Op0D()
 
 void InitDSP(void)
 {
-#ifdef __OPT__
-   unsigned int i;
-   for (i = 0; i < INCR; i++)
-   {
-      CosTable2[i] = (cos((double)(2 * PI * i / INCR)));
-      SinTable2[i] = (sin((double)(2 * PI * i / INCR)));
-   }
-#endif
 #ifdef DebugDSP1
    Start_Log();
 #endif
@@ -704,6 +678,18 @@ short CosAas;
 short SinAzs;
 short CosAzs;
 
+// Normal vector of the screen and position of the eye
+short Nx;
+short Ny;
+short Nz;
+short Gx;
+short Gy;
+short Gz;
+
+// Normalized eye-to-screen distance
+short C_Les;
+short E_Les;
+
 // Clipped Zenith angle
 short SinAZS;
 short CosAZS;
@@ -732,12 +718,25 @@ void DSP1_Parameter(short Fx, short Fy, short Fz, short Lfe, short Les,
    SinAzs = DSP1_Sin(Azs);
    CosAzs = DSP1_Cos(Azs);
 
+   Nx = SinAzs * -SinAas >> 15;
+   Ny = SinAzs * CosAas >> 15;
+   Nz = CosAzs * 0x7fff >> 15;
+
    // Center of Projection
-   CentreX = Fx + (Lfe * (SinAzs * -SinAas >> 15) >> 15);
-   CentreY = Fy + (Lfe * (SinAzs * CosAas >> 15) >> 15);
+   CentreX = Fx + (Lfe * Nx >> 15);
+   CentreY = Fy + (Lfe * Ny >> 15);
+   short CentreZ = Fz + (Lfe * Nz >> 15);
+
+   // Eye position, Les behind the centre along the normal
+   Gx = CentreX - (Les * Nx >> 15);
+   Gy = CentreY - (Les * Ny >> 15);
+   Gz = CentreZ - (Les * Nz >> 15);
+
+   E_Les = 0;
+   DSP1_Normalize(Les, &C_Les, &E_Les);
 
    E = 0;
-   DSP1_Normalize(Fz + (Lfe * (CosAzs * 0x7fff >> 15) >> 15), &C, &E);
+   DSP1_Normalize(CentreZ, &C, &E);
 
    VPlane_C = C;
    VPlane_E = E;
@@ -846,10 +845,59 @@ short Op02VVA;
 short Op02CX;
 short Op02CY;
 
+// Raster lines depend only on Vs and the Op02 parameters, so Op0A computes
+// them a batch at a time and keeps them until Op02 is given different
+// parameters. A game that streams the whole frame's mode 7 matrices then pays
+// one call per batch, and nothing at all on frames where the camera did not
+// move, even if it reissues the same Op02 every frame.
+#define RASTER_CACHE_SIZE 512
+#define RASTER_BATCH      32
+
+typedef struct
+{
+   unsigned short Gen;
+   short Vs;
+   short A, B, C, D;
+} DSP1RasterLine;
+
+DSP1RasterLine RasterCache[RASTER_CACHE_SIZE];
+unsigned short RasterGen = 1;
+short RasterParams[7];
+bool RasterParamsValid = false;
+
+// Drops every cached raster line. Called by Op02 when its parameters change
+// and on reset, which also covers loading a ROM or a saved state.
+void DSP1_InvalidateRaster()
+{
+   RasterParamsValid = false;
+   if (++RasterGen == 0)
+   {
+      memset(RasterCache, 0, sizeof(RasterCache));
+      RasterGen = 1;
+   }
+}
+
 void DSPOp02()
 {
+   short Params[7];
+
    DSP1_Parameter(Op02FX, Op02FY, Op02FZ, Op02LFE, Op02LES, Op02AAS, Op02AZS,
                   &Op02VOF, &Op02VVA, &Op02CX, &Op02CY);
+
+   Params[0] = Op02FX;
+   Params[1] = Op02FY;
+   Params[2] = Op02FZ;
+   Params[3] = Op02LFE;
+   Params[4] = Op02LES;
+   Params[5] = Op02AAS;
+   Params[6] = Op02AZS;
+
+   if (!RasterParamsValid || memcmp(Params, RasterParams, sizeof(Params)) != 0)
+   {
+      DSP1_InvalidateRaster();
+      memcpy(RasterParams, Params, sizeof(Params));
+      RasterParamsValid = true;
+   }
 }
 
 short Op0AVS;
@@ -860,7 +908,26 @@ short Op0AD;
 
 void DSPOp0A()
 {
-   DSP1_Raster(Op0AVS, &Op0AA, &Op0AB, &Op0AC, &Op0AD);
+   DSP1RasterLine* Line = &RasterCache[Op0AVS & (RASTER_CACHE_SIZE - 1)];
+
+   if (Line->Gen != RasterGen || Line->Vs != Op0AVS)
+   {
+      short Vs = Op0AVS;
+      int i;
+
+      for (i = 0; i < RASTER_BATCH; i++, Vs++)
+      {
+         DSP1RasterLine* Next = &RasterCache[Vs & (RASTER_CACHE_SIZE - 1)];
+         DSP1_Raster(Vs, &Next->A, &Next->B, &Next->C, &Next->D);
+         Next->Vs = Vs;
+         Next->Gen = RasterGen;
+      }
+   }
+
+   Op0AA = Line->A;
+   Op0AB = Line->B;
+   Op0AC = Line->C;
+   Op0AD = Line->D;
    Op0AVS++;
 }
 
@@ -871,136 +938,91 @@ short Op06H;
 short Op06V;
 unsigned short Op06S;
 
-double ObjPX;
-double ObjPY;
-double ObjPZ;
-double ObjPX1;
-double ObjPY1;
-double ObjPZ1;
-double ObjPX2;
-double ObjPY2;
-double ObjPZ2;
-double DivideOp06;
-int Temp;
-int tanval2;
-
-#ifdef __OPT06__
-void DSPOp06()
+short DSP1_ShiftR(short C, short E)
 {
-   ObjPX = Op06X - Op02FX;
-   ObjPY = Op06Y - Op02FY;
-   ObjPZ = Op06Z - Op02FZ;
-
-   // rotate around Z
-   tanval2 = Angle(-Op02AAS + 32768);
-   //   tanval2 = (-Op02AAS+32768)/(65536/INCR);
-   ObjPX1 = (ObjPX * Cos(tanval2) + ObjPY * -Sin(tanval2));
-   ObjPY1 = (ObjPX * Sin(tanval2) + ObjPY * Cos(tanval2));
-   ObjPZ1 = ObjPZ;
-
-   // rotate around X
-   //   tanval2 = (-Op02AZS/(65536/INCR)) & 1023;
-   tanval2 = Angle(-Op02AZS);
-   //   tanval2 = (-Op02AZS)/256;
-   ObjPX2 = ObjPX1;
-   ObjPY2 = (ObjPY1 * Cos(tanval2) + ObjPZ1 * -Sin(tanval2));
-   ObjPZ2 = (ObjPY1 * Sin(tanval2) + ObjPZ1 * Cos(tanval2));
-
-#ifdef debug06
-   Log_Message("ObjPX2: %f ObjPY2: %f ObjPZ2: %f\n", ObjPX2, ObjPY2, ObjPZ2);
-#endif
-
-   ObjPZ2 = ObjPZ2 - Op02LFE;
+   return C * DSP1ROM[0x0031 + E] >> 15;
+}
 
-   if (ObjPZ2 < 0)
-   {
-      double d;
-      Op06H = (short)(-ObjPX2 * Op02LES / -(ObjPZ2)); //-ObjPX2*256/-ObjPZ2;
-      Op06V = (short)(-ObjPY2 * Op02LES / -(ObjPZ2)); //-ObjPY2*256/-ObjPZ2;
-      d = (double)Op02LES;
-      d *= 256.0;
-      d /= (-ObjPZ2);
-      if (d > 65535.0)
-         d = 65535.0;
-      else if (d < 0.0)
-         d = 0.0;
-      Op06S = (unsigned short)d;
-      //Op06S=(unsigned short)(256*(double)Op02LES/-ObjPZ2);
-      //Op06S=(unsigned short)((double)(256.0*((double)Op02LES)/(-ObjPZ2)));
-   }
+void DSP1_Project(short X, short Y, short Z, short* H, short* V,
+                  unsigned short* M)
+{
+   int Aux, Aux4;
+   short E, E2, E3, E4, E6, E7, RefE;
+   short C2, C4, C10, C12, C17, C18, C19, C24, C25, C26;
+   short Px, Py, Pz;
+
+   E = E2 = E3 = E4 = 0;
+
+   // Object position relative to the eye, halved so the dot products below
+   // cannot overflow
+   DSP1_NormalizeDouble((int) X - Gx, &Px, &E4);
+   DSP1_NormalizeDouble((int) Y - Gy, &Py, &E);
+   DSP1_NormalizeDouble((int) Z - Gz, &Pz, &E3);
+   Px >>= 1;
+   E4--;
+   Py >>= 1;
+   E--;
+   Pz >>= 1;
+   E3--;
+
+   // Bring all three components to a common exponent
+   RefE = (E < E3) ? E : E3;
+   RefE = (RefE < E4) ? RefE : E4;
+
+   Px = DSP1_ShiftR(Px, E4 - RefE);
+   Py = DSP1_ShiftR(Py, E - RefE);
+   Pz = DSP1_ShiftR(Pz, E3 - RefE);
+
+   // Distance from the screen plane along its normal
+   C12 = -(Px * Nx >> 15) - (Py * Ny >> 15) - (Pz * Nz >> 15);
+
+   Aux4 = C12;
+   RefE = 16 - RefE;
+   if (RefE >= 0)
+      Aux4 <<= RefE;
    else
-   {
-      Op06H = 0;
-      Op06V = 14 * 16;
-      Op06S = 0xFFFF;
-   }
-
-
-#ifdef DebugDSP1
-   Log_Message("OP06 X:%d Y:%d Z:%d", Op06X, Op06Y, Op06Z);
-   Log_Message("OP06 H:%d V:%d S:%d", Op06H, Op06V, Op06S);
-#endif
+      Aux4 >>= -RefE;
+   if (Aux4 == -1)
+      Aux4 = 0;
+   Aux4 >>= 1;
+
+   Aux = (unsigned short) Op02LES + Aux4;
+   DSP1_NormalizeDouble(Aux, &C10, &E2);
+   E2 = 15 - E2;
+
+   // Scale factor: Les over the distance
+   DSP1_Inverse(C10, 0, &C4, &E4);
+   C2 = C4 * C_Les >> 15;
+
+   // Horizontal screen axis
+   E7 = 0;
+   C17 = (Px * (CosAas * 0x7fff >> 15) >> 15) + (Py * (SinAas * 0x7fff >> 15) >> 15);
+   C18 = C17 * C2 >> 15;
+   DSP1_Normalize(C18, &C19, &E7);
+   *H = DSP1_Truncate(C19, E_Les - E2 + RefE + E7);
+
+   // Vertical screen axis
+   E6 = 0;
+   C24 = (Px * (CosAzs * -SinAas >> 15) >> 15) + (Py * (CosAzs * CosAas >> 15) >> 15)
+         + (Pz * (-SinAzs * 0x7fff >> 15) >> 15);
+   C26 = C24 * C2 >> 15;
+   DSP1_Normalize(C26, &C25, &E6);
+   *V = DSP1_Truncate(C25, E_Les - E2 + RefE + E6);
+
+   // Sprite scale, in units of 1/128
+   DSP1_Normalize(C2, &C19, &E4);
+   *M = DSP1_Truncate(C19, E4 + E_Les - E2 - 7);
 }
-#else
 
 void DSPOp06()
 {
-   ObjPX = Op06X - Op02FX;
-   ObjPY = Op06Y - Op02FY;
-   ObjPZ = Op06Z - Op02FZ;
-
-   // rotate around Z
-   tanval = (-Op02AAS + 32768) / 65536.0 * 6.2832;
-   ObjPX1 = (ObjPX * cos(tanval) + ObjPY * -sin(tanval));
-   ObjPY1 = (ObjPX * sin(tanval) + ObjPY * cos(tanval));
-   ObjPZ1 = ObjPZ;
-
-#ifdef debug06
-   Log_Message("Angle : %f", tanval);
-   Log_Message("ObjPX1: %f ObjPY1: %f ObjPZ1: %f\n", ObjPX1, ObjPY1, ObjPZ1);
-   Log_Message("cos(tanval) : %f  sin(tanval) : %f", cos(tanval), sin(tanval));
-#endif
-
-   // rotate around X
-   tanval = (-Op02AZS) / 65536.0 * 6.2832;
-   ObjPX2 = ObjPX1;
-   ObjPY2 = (ObjPY1 * cos(tanval) + ObjPZ1 * -sin(tanval));
-   ObjPZ2 = (ObjPY1 * sin(tanval) + ObjPZ1 * cos(tanval));
-
-#ifdef debug06
-   Log_Message("ObjPX2: %f ObjPY2: %f ObjPZ2: %f\n", ObjPX2, ObjPY2, ObjPZ2);
-#endif
-
-   ObjPZ2 = ObjPZ2 - Op02LFE;
-
-   if (ObjPZ2 < 0)
-   {
-      Op06H = (short)(-ObjPX2 * Op02LES / -(ObjPZ2)); //-ObjPX2*256/-ObjPZ2;
-      Op06V = (short)(-ObjPY2 * Op02LES / -(ObjPZ2)); //-ObjPY2*256/-ObjPZ2;
-      double d = (double)Op02LES;
-      d *= 256.0;
-      d /= (-ObjPZ2);
-      if (d > 65535.0)
-         d = 65535.0;
-      else if (d < 0.0)
-         d = 0.0;
-      Op06S = (unsigned short)d;
-      //   Op06S=(unsigned short)(256*(double)Op02LES/-ObjPZ2);
-   }
-   else
-   {
-      Op06H = 0;
-      Op06V = 14 * 16;
-      Op06S = 0xFFFF;
-   }
+   DSP1_Project(Op06X, Op06Y, Op06Z, &Op06H, &Op06V, &Op06S);
 
 #ifdef DebugDSP1
    Log_Message("OP06 X:%d Y:%d Z:%d", Op06X, Op06Y, Op06Z);
    Log_Message("OP06 H:%d V:%d S:%d", Op06H, Op06V, Op06S);
 #endif
 }
-#endif
-
 
 short matrixC[3][3];
 short matrixB[3][3];
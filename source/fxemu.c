@@ -91,6 +91,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#ifdef VITA
+#include <psp2/kernel/threadmgr.h>
+#endif
 
 /* The FxChip Emulator's internal variables */
 struct FxRegs_s GSU = FxRegs_s_null;
@@ -239,45 +242,14 @@ void fx_updateRamBank(uint8_t Byte)
 }
 
 
-static void fx_readRegisterSpace()
+/* Recompute the screen geometry and plot handlers from SCBR/SCMR */
+static void fx_updateScreenRegisters()
 {
    int i;
-   uint8_t* p;
+   uint8_t* p = GSU.pvRegisters;
    static uint32_t avHeight[] = { 128, 160, 192, 256 };
    static uint32_t avMult[] = { 16, 32, 32, 64 };
 
-   GSU.vErrorCode = 0;
-
-   /* Update R0-R15 */
-   p = GSU.pvRegisters;
-   for (i = 0; i < 16; i++)
-   {
-      GSU.avReg[i] = *p++;
-      GSU.avReg[i] += ((uint32_t)(*p++)) << 8;
-   }
-
-   /* Update other registers */
-   p = GSU.pvRegisters;
-   GSU.vStatusReg = (uint32_t)p[GSU_SFR];
-   GSU.vStatusReg |= ((uint32_t)p[GSU_SFR + 1]) << 8;
-   GSU.vPrgBankReg = (uint32_t)p[GSU_PBR];
-   GSU.vRomBankReg = (uint32_t)p[GSU_ROMBR];
-   GSU.vRamBankReg = ((uint32_t)p[GSU_RAMBR]) & (FX_RAM_BANKS - 1);
-   GSU.vCacheBaseReg = (uint32_t)p[GSU_CBR];
-   GSU.vCacheBaseReg |= ((uint32_t)p[GSU_CBR + 1]) << 8;
-
-   /* Update status register variables */
-   GSU.vZero = !(GSU.vStatusReg & FLG_Z);
-   GSU.vSign = (GSU.vStatusReg & FLG_S) << 12;
-   GSU.vOverflow = (GSU.vStatusReg & FLG_OV) << 16;
-   GSU.vCarry = (GSU.vStatusReg & FLG_CY) >> 2;
-
-   /* Set bank pointers */
-   GSU.pvRamBank = GSU.apvRamBank[GSU.vRamBankReg & 0x3];
-   GSU.pvRomBank = GSU.apvRomBank[GSU.vRomBankReg];
-   GSU.pvPrgBank = GSU.apvRomBank[GSU.vPrgBankReg];
-
-   /* Set screen pointers */
    GSU.pvScreenBase = &GSU.pvRam[ USEX8(p[GSU_SCBR]) << 10 ];
    i = (int)(!!(p[GSU_SCMR] & 0x04));
    i |= ((int)(!!(p[GSU_SCMR] & 0x20))) << 1;
@@ -303,7 +275,7 @@ static void fx_readRegisterSpace()
    if (GSU.pvScreenBase + GSU.vScreenSize > GSU.pvRam + (GSU.nRamBanks * 65536))
       GSU.pvScreenBase =  GSU.pvRam + (GSU.nRamBanks * 65536) - GSU.vScreenSize;
 #endif
-      GSU.pfPlot = fx_apfPlotTable[GSU.vMode];
+   GSU.pfPlot = fx_apfPlotTable[GSU.vMode];
    GSU.pfRpix = fx_apfPlotTable[GSU.vMode + 5];
 
    fx_ppfOpcodeTable[0x04c] = GSU.pfPlot;
@@ -312,6 +284,70 @@ static void fx_readRegisterSpace()
    fx_ppfOpcodeTable[0x34c] = GSU.pfRpix;
 
    fx_computeScreenPointers();
+   GSU.vScreenRegsDirty = false;
+}
+
+/* Fold the separately kept Z/S/OV/CY flags back into SFR */
+static void fx_updateStatusRegister()
+{
+   if (USEX16(GSU.vZero) == 0) SF(Z);
+   else CF(Z);
+   if (GSU.vSign & 0x8000) SF(S);
+   else CF(S);
+   if (GSU.vOverflow >= 0x8000 || GSU.vOverflow < -0x8000) SF(OV);
+   else CF(OV);
+   if (GSU.vCarry) SF(CY);
+   else CF(CY);
+}
+
+/* Load the Z/S/OV/CY flag variables from SFR */
+static void fx_splitStatusRegister()
+{
+   GSU.vZero = !(GSU.vStatusReg & FLG_Z);
+   GSU.vSign = (GSU.vStatusReg & FLG_S) << 12;
+   GSU.vOverflow = (GSU.vStatusReg & FLG_OV) << 16;
+   GSU.vCarry = (GSU.vStatusReg & FLG_CY) >> 2;
+}
+
+/* Load the whole GSU state from the register space. Only needed at reset
+ * and after a snapshot has replaced Memory.FillRAM; otherwise the GSU
+ * struct stays authoritative and single registers are exchanged with the
+ * CPU through fx_syncRegisterToCPU()/fx_syncRegisterFromCPU(). */
+void fx_readRegisterSpace()
+{
+   int i;
+   uint8_t* p;
+
+   GSU.vErrorCode = 0;
+
+   /* Update R0-R15 */
+   p = GSU.pvRegisters;
+   for (i = 0; i < 16; i++)
+   {
+      GSU.avReg[i] = *p++;
+      GSU.avReg[i] += ((uint32_t)(*p++)) << 8;
+   }
+
+   /* Update other registers */
+   p = GSU.pvRegisters;
+   GSU.vStatusReg = (uint32_t)p[GSU_SFR];
+   GSU.vStatusReg |= ((uint32_t)p[GSU_SFR + 1]) << 8;
+   GSU.vPrgBankReg = (uint32_t)p[GSU_PBR];
+   GSU.vRomBankReg = (uint32_t)p[GSU_ROMBR];
+   GSU.vRamBankReg = ((uint32_t)p[GSU_RAMBR]) & (FX_RAM_BANKS - 1);
+   GSU.vCacheBaseReg = (uint32_t)p[GSU_CBR];
+   GSU.vCacheBaseReg |= ((uint32_t)p[GSU_CBR + 1]) << 8;
+
+   /* Update status register variables */
+   fx_splitStatusRegister();
+
+   /* Set bank pointers */
+   GSU.pvRamBank = GSU.apvRamBank[GSU.vRamBankReg & 0x3];
+   GSU.pvRomBank = GSU.apvRomBank[GSU.vRomBankReg];
+   GSU.pvPrgBank = GSU.apvRomBank[GSU.vPrgBankReg];
+
+   /* Set screen pointers */
+   fx_updateScreenRegisters();
 
    fx_backupCache();
 }
@@ -451,7 +487,8 @@ void fx_computeScreenPointers()
    }
 }
 
-static void fx_writeRegisterSpace()
+/* Store the whole GSU state to the register space (snapshots) */
+void fx_writeRegisterSpace()
 {
    int i;
    uint8_t* p;
@@ -464,14 +501,7 @@ static void fx_writeRegisterSpace()
    }
 
    /* Update status register */
-   if (USEX16(GSU.vZero) == 0) SF(Z);
-   else CF(Z);
-   if (GSU.vSign & 0x8000) SF(S);
-   else CF(S);
-   if (GSU.vOverflow >= 0x8000 || GSU.vOverflow < -0x8000) SF(OV);
-   else CF(OV);
-   if (GSU.vCarry) SF(CY);
-   else CF(CY);
+   fx_updateStatusRegister();
 
    p = GSU.pvRegisters;
    p[GSU_SFR] = (uint8_t)GSU.vStatusReg;
@@ -485,6 +515,92 @@ static void fx_writeRegisterSpace()
    fx_restoreCache();
 }
 
+/* CPU read of a GSU register: refresh its byte in the register space */
+void fx_syncRegisterToCPU(uint16_t vAddress)
+{
+   uint8_t* p = GSU.pvRegisters;
+   uint32_t r = vAddress - 0x3000;
+
+   if (r < 0x20)
+   {
+      p[r] = (uint8_t)(GSU.avReg[r >> 1] >> ((r & 1) << 3));
+      return;
+   }
+
+   switch (r)
+   {
+   case GSU_SFR:
+   case GSU_SFR + 1:
+      fx_updateStatusRegister();
+      p[GSU_SFR] = (uint8_t)GSU.vStatusReg;
+      p[GSU_SFR + 1] = (uint8_t)(GSU.vStatusReg >> 8);
+      break;
+   case GSU_PBR:
+      p[GSU_PBR] = (uint8_t)GSU.vPrgBankReg;
+      break;
+   case GSU_ROMBR:
+      p[GSU_ROMBR] = (uint8_t)GSU.vRomBankReg;
+      break;
+   case GSU_RAMBR:
+      p[GSU_RAMBR] = (uint8_t)GSU.vRamBankReg;
+      break;
+   case GSU_CBR:
+   case GSU_CBR + 1:
+      p[GSU_CBR] = (uint8_t)GSU.vCacheBaseReg;
+      p[GSU_CBR + 1] = (uint8_t)(GSU.vCacheBaseReg >> 8);
+      break;
+   }
+}
+
+/* CPU write of a GSU register: fold the new byte into the live state */
+void fx_syncRegisterFromCPU(uint16_t vAddress)
+{
+   uint8_t* p = GSU.pvRegisters;
+   uint32_t r = vAddress - 0x3000;
+
+   if (r < 0x20)
+   {
+      if (r & 1)
+         GSU.avReg[r >> 1] = (GSU.avReg[r >> 1] & 0xff) | ((uint32_t)p[r] << 8);
+      else
+         GSU.avReg[r >> 1] = (GSU.avReg[r >> 1] & 0xff00) | p[r];
+      return;
+   }
+
+   switch (r)
+   {
+   case GSU_SFR:
+      GSU.vStatusReg = (GSU.vStatusReg & 0xff00) | p[GSU_SFR];
+      fx_splitStatusRegister();
+      break;
+   case GSU_SFR + 1:
+      GSU.vStatusReg = (GSU.vStatusReg & 0xff) | ((uint32_t)p[GSU_SFR + 1] << 8);
+      break;
+   case GSU_PBR:
+      GSU.vPrgBankReg = (uint32_t)p[GSU_PBR];
+      GSU.pvPrgBank = GSU.apvRomBank[GSU.vPrgBankReg];
+      break;
+   case GSU_ROMBR:
+      GSU.vRomBankReg = (uint32_t)p[GSU_ROMBR];
+      GSU.pvRomBank = GSU.apvRomBank[GSU.vRomBankReg];
+      break;
+   case GSU_RAMBR:
+      fx_updateRamBank(p[GSU_RAMBR]);
+      break;
+   case GSU_CBR:
+   case GSU_CBR + 1:
+      GSU.vCacheBaseReg = (uint32_t)p[GSU_CBR] | ((uint32_t)p[GSU_CBR + 1] << 8);
+      break;
+   case GSU_SCBR:
+      GSU.vSCBRDirty = true;
+      GSU.vScreenRegsDirty = true;
+      break;
+   case GSU_SCMR:
+      GSU.vScreenRegsDirty = true;
+      break;
+   }
+}
+
 /* Reset the FxChip */
 void FxReset(struct FxInit_s* psFxInfo)
 {
@@ -613,15 +729,23 @@ static bool fx_checkStartAddress()
 int FxEmulate(uint32_t nInstructions)
 {
    uint32_t vCount;
+   int i;
 
-   /* Read registers and initialize GSU session */
-   fx_readRegisterSpace();
+   /* The GSU struct already holds the live registers. Only bring them back
+    * to 16 bits and canonical flags, as the old round trip through the
+    * register space at every session used to. */
+   for (i = 0; i < 16; i++)
+      GSU.avReg[i] = USEX16(GSU.avReg[i]);
+   fx_updateStatusRegister();
+   fx_splitStatusRegister();
+   if (GSU.vScreenRegsDirty)
+      fx_updateScreenRegisters();
+   GSU.vErrorCode = 0;
 
    /* Check if the start address is valid */
    if (!fx_checkStartAddress())
    {
       CF(G);
-      fx_writeRegisterSpace();
 #if 0
       GSU.vIllegalAddress = (GSU.vPrgBankReg << 24) | R15;
       return FX_ERROR_ILLEGAL_ADDRESS;
@@ -638,9 +762,6 @@ int FxEmulate(uint32_t nInstructions)
    else
       vCount = fx_ppfFunctionTable[FX_FUNCTION_RUN](nInstructions);
 
-   /* Store GSU registers */
-   fx_writeRegisterSpace();
-
    /* Check for error code */
    if (GSU.vErrorCode)
       return GSU.vErrorCode;
@@ -648,6 +769,129 @@ int FxEmulate(uint32_t nInstructions)
       return vCount;
 }
 
+/* Threaded execution. FxEmulateAsync() hands a whole GSU session to a worker
+ * thread and returns at once; the caller must keep its hands off the GSU
+ * registers and RAM until FxThreadWait() has returned. Without a thread
+ * implementation FxEmulateAsync() returns false and the caller runs the
+ * session inline as before. */
+#ifdef VITA
+static SceUID FxThreadHandle = -1;
+static SceUID FxStartSema = -1;
+static SceUID FxDoneSema = -1;
+static uint32_t FxThreadInstructions;
+static volatile bool FxThreadQuit = false;
+static bool FxThreadBusy = false;
+
+static int FxThreadMain(SceSize args, void* argp)
+{
+   while (true)
+   {
+      sceKernelWaitSema(FxStartSema, 1, NULL);
+      if (FxThreadQuit)
+         break;
+      FxEmulate(FxThreadInstructions);
+      sceKernelSignalSema(FxDoneSema, 1);
+   }
+   return 0;
+}
+
+static bool FxThreadInit()
+{
+   if (FxThreadHandle >= 0)
+      return true;
+
+   FxStartSema = sceKernelCreateSema("gsu_start", 0, 0, 1, NULL);
+   FxDoneSema = sceKernelCreateSema("gsu_done", 0, 0, 1, NULL);
+   if (FxStartSema < 0 || FxDoneSema < 0)
+   {
+      FxThreadDeinit();
+      return false;
+   }
+
+   FxThreadQuit = false;
+   FxThreadHandle = sceKernelCreateThread("gsu", FxThreadMain, 0x10000100,
+                                          0x10000, 0, SCE_KERNEL_CPU_MASK_USER_1, NULL);
+   if (FxThreadHandle < 0)
+   {
+      FxThreadDeinit();
+      return false;
+   }
+   if (sceKernelStartThread(FxThreadHandle, 0, NULL) < 0)
+   {
+      sceKernelDeleteThread(FxThreadHandle);
+      FxThreadHandle = -1;
+      FxThreadDeinit();
+      return false;
+   }
+   return true;
+}
+
+void FxThreadDeinit()
+{
+   if (FxThreadHandle >= 0)
+   {
+      FxThreadWait();
+      FxThreadQuit = true;
+      sceKernelSignalSema(FxStartSema, 1);
+      sceKernelWaitThreadEnd(FxThreadHandle, NULL, NULL);
+      sceKernelDeleteThread(FxThreadHandle);
+      FxThreadHandle = -1;
+   }
+   if (FxStartSema >= 0)
+   {
+      sceKernelDeleteSema(FxStartSema);
+      FxStartSema = -1;
+   }
+   if (FxDoneSema >= 0)
+   {
+      sceKernelDeleteSema(FxDoneSema);
+      FxDoneSema = -1;
+   }
+}
+
+bool FxEmulateAsync(uint32_t nInstructions)
+{
+   if (!FxThreadInit())
+      return false;
+
+   FxThreadInstructions = nInstructions;
+   FxThreadBusy = true;
+   sceKernelSignalSema(FxStartSema, 1);
+   return true;
+}
+
+void FxThreadWait()
+{
+   if (!FxThreadBusy)
+      return;
+   sceKernelWaitSema(FxDoneSema, 1, NULL);
+   FxThreadBusy = false;
+}
+
+bool FxThreadRunning()
+{
+   return FxThreadBusy;
+}
+#else
+void FxThreadDeinit()
+{
+}
+
+bool FxEmulateAsync(uint32_t nInstructions)
+{
+   return false;
+}
+
+void FxThreadWait()
+{
+}
+
+bool FxThreadRunning()
+{
+   return false;
+}
+#endif
+
 /* Breakpoints */
 void FxBreakPointSet(uint32_t vAddress)
 {
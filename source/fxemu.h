@@ -108,6 +108,14 @@ extern void FxReset(struct FxInit_s* psFxInfo);
 /* Execute until the next stop instruction */
 extern int FxEmulate(uint32_t nInstructions);
 
+/* Run a session on the GSU thread; false if no thread could be started */
+extern bool FxEmulateAsync(uint32_t nInstructions);
+
+/* Wait for the session started by FxEmulateAsync() to finish */
+extern void FxThreadWait();
+extern bool FxThreadRunning();
+extern void FxThreadDeinit();
+
 /* Write access to the cache */
 extern void FxCacheWriteAccess(uint16_t vAddress);
 extern void
@@ -142,6 +150,15 @@ extern void fx_dirtySCBR(void);
 /* Update RamBankReg and RAM Bank pointer */
 extern void fx_updateRamBank(uint8_t Byte);
 
+/* The GSU struct holds the live register state. These exchange a single
+ * register byte at 0x3000 + n with Memory.FillRAM around CPU accesses... */
+extern void fx_syncRegisterToCPU(uint16_t vAddress);
+extern void fx_syncRegisterFromCPU(uint16_t vAddress);
+
+/* ...and these the whole register file, for reset and snapshots */
+extern void fx_readRegisterSpace();
+extern void fx_writeRegisterSpace();
+
 /* Option flags */
 #define FX_FLAG_ADDRESS_CHECKING 0x01
 #define FX_FLAG_ROM_BUFFER    0x02
@@ -100,6 +100,84 @@ int gsu_bank [512] = {0};
 /* (I don't think it's nessecary) */
 #define CHECK_LIMITS
 
+/* Pixel cache. Like the primary pixel cache of the real chip, plot collects
+ * the colours of one 8x1 row of a character and only converts them to
+ * bitplanes and merges them into GSU RAM when it moves to another row. It's
+ * written back before anything else reads or writes GSU RAM (rpix, the
+ * load/store instructions, the end of a run) so RAM looks just as if every
+ * pixel had been stored right away. */
+static uint8_t* fx_pvPixelCacheAddr;  /* first bitplane byte of the cached row */
+static uint32_t fx_vPixelCacheRow = ~0; /* (y << 5) | (x >> 3) of the cached row, ~0 if empty */
+static uint32_t fx_nPixelCachePlanes;
+static uint8_t  fx_vPixelCacheMask;   /* pixels of the row that have been plotted */
+static uint8_t  fx_avPixelCache[8];   /* colour of each pixel, left to right */
+
+static void fx_flushPixelCache()
+{
+   uint8_t m = fx_vPixelCacheMask;
+   uint8_t* a = fx_pvPixelCacheAddr;
+   uint8_t* c = fx_avPixelCache;
+   uint32_t x, y, t;
+
+   /* 8x8 bit matrix transpose, afterwards byte n of y holds bitplane n
+    * and byte n of t bitplane 4 + n */
+   x = (c[0] << 24) | (c[1] << 16) | (c[2] << 8) | c[3];
+   y = (c[4] << 24) | (c[5] << 16) | (c[6] << 8) | c[7];
+   t = (x ^ (x >> 7)) & 0x00aa00aa;
+   x = x ^ t ^ (t << 7);
+   t = (y ^ (y >> 7)) & 0x00aa00aa;
+   y = y ^ t ^ (t << 7);
+   t = (x ^ (x >> 14)) & 0x0000cccc;
+   x = x ^ t ^ (t << 14);
+   t = (y ^ (y >> 14)) & 0x0000cccc;
+   y = y ^ t ^ (t << 14);
+   t = (x & 0xf0f0f0f0) | ((y >> 4) & 0x0f0f0f0f);
+   y = ((x << 4) & 0xf0f0f0f0) | (y & 0x0f0f0f0f);
+
+   switch (fx_nPixelCachePlanes)
+   {
+   case 8:
+      a[0x20] = (a[0x20] & ~m) | ((uint8_t)t & m);
+      a[0x21] = (a[0x21] & ~m) | ((uint8_t)(t >> 8) & m);
+      a[0x30] = (a[0x30] & ~m) | ((uint8_t)(t >> 16) & m);
+      a[0x31] = (a[0x31] & ~m) | ((uint8_t)(t >> 24) & m);
+      /* fall through */
+   case 4:
+      a[0x10] = (a[0x10] & ~m) | ((uint8_t)(y >> 16) & m);
+      a[0x11] = (a[0x11] & ~m) | ((uint8_t)(y >> 24) & m);
+      /* fall through */
+   case 2:
+      a[0x00] = (a[0x00] & ~m) | ((uint8_t)y & m);
+      a[0x01] = (a[0x01] & ~m) | ((uint8_t)(y >> 8) & m);
+   }
+   fx_vPixelCacheMask = 0;
+   fx_vPixelCacheRow = ~0;
+}
+
+#define FLUSHPIXELS if (fx_vPixelCacheMask) fx_flushPixelCache()
+
+/* Plot into a row that isn't cached: write back the old one and start over */
+static void fx_cachePixelRow(uint32_t x, uint32_t y, uint8_t c, uint32_t nPlanes)
+{
+   FLUSHPIXELS;
+   fx_vPixelCacheRow = (y << 5) | (x >> 3);
+   fx_pvPixelCacheAddr = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
+   fx_nPixelCachePlanes = nPlanes;
+   fx_vPixelCacheMask = 128 >> (x & 7);
+   fx_avPixelCache[x & 7] = c;
+}
+
+static INLINE void fx_cachePixel(uint32_t x, uint32_t y, uint8_t c, uint32_t nPlanes)
+{
+   if (((y << 5) | (x >> 3)) != fx_vPixelCacheRow)
+   {
+      fx_cachePixelRow(x, y, c, nPlanes);
+      return;
+   }
+   fx_vPixelCacheMask |= 128 >> (x & 7);
+   fx_avPixelCache[x & 7] = c;
+}
+
 /* Codes used:
  *
  * rn   = a GSU register (r0-r15)
@@ -417,6 +495,7 @@ static void fx_with_r15()
 
 /* 30-3b - stw (rn) - store word */
 #define FX_STW(reg) \
+FLUSHPIXELS; \
 GSU.vLastRamAdr = GSU.avReg[reg]; \
 RAM(GSU.avReg[reg]) = (uint8_t)SREG; \
 RAM(GSU.avReg[reg]^1) = (uint8_t)(SREG>>8); \
@@ -472,6 +551,7 @@ static void fx_stw_r11()
 
 /* 30-3b(ALT1) - stb (rn) - store byte */
 #define FX_STB(reg) \
+FLUSHPIXELS; \
 GSU.vLastRamAdr = GSU.avReg[reg]; \
 RAM(GSU.avReg[reg]) = (uint8_t)SREG; \
 CLRFLAGS; R15++
@@ -563,6 +643,7 @@ static void fx_alt3()
 
 /* 40-4b - ldw (rn) - load word from RAM */
 #define FX_LDW(reg) uint32_t v; \
+FLUSHPIXELS; \
 GSU.vLastRamAdr = GSU.avReg[reg]; \
 v = (uint32_t)RAM(GSU.avReg[reg]); \
 v |= ((uint32_t)RAM(GSU.avReg[reg]^1))<<8; \
@@ -620,6 +701,7 @@ static void fx_ldw_r11()
 
 /* 40-4b(ALT1) - ldb (rn) - load byte */
 #define FX_LDB(reg) uint32_t v; \
+FLUSHPIXELS; \
 GSU.vLastRamAdr = GSU.avReg[reg]; \
 v = (uint32_t)RAM(GSU.avReg[reg]); \
 R15++; DREG = v; \
@@ -679,8 +761,7 @@ static void fx_plot_2bit()
 {
    uint32_t x = USEX8(R1);
    uint32_t y = USEX8(R2);
-   uint8_t* a;
-   uint8_t v, c;
+   uint8_t c;
 
    R15++;
    CLRFLAGS;
@@ -695,13 +776,7 @@ static void fx_plot_2bit()
       c = (uint8_t)GSU.vColorReg;
 
    if (!(GSU.vPlotOptionReg & 0x01) && !(c & 0xf)) return;
-   a = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
-   v = 128 >> (x & 7);
-
-   if (c & 0x01) a[0] |= v;
-   else a[0] &= ~v;
-   if (c & 0x02) a[1] |= v;
-   else a[1] &= ~v;
+   fx_cachePixel(x, y, c, 2);
 }
 
 /* 2c(ALT1) - rpix - read color of the pixel with R1,R2 as x,y */
@@ -712,6 +787,7 @@ static void fx_rpix_2bit()
    uint8_t* a;
    uint8_t v;
 
+   FLUSHPIXELS;
    R15++;
    CLRFLAGS;
 #ifdef CHECK_LIMITS
@@ -732,8 +808,7 @@ static void fx_plot_4bit()
 {
    uint32_t x = USEX8(R1);
    uint32_t y = USEX8(R2);
-   uint8_t* a;
-   uint8_t v, c;
+   uint8_t c;
 
    R15++;
    CLRFLAGS;
@@ -748,18 +823,7 @@ static void fx_plot_4bit()
       c = (uint8_t)GSU.vColorReg;
 
    if (!(GSU.vPlotOptionReg & 0x01) && !(c & 0xf)) return;
-
-   a = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
-   v = 128 >> (x & 7);
-
-   if (c & 0x01) a[0x00] |= v;
-   else a[0x00] &= ~v;
-   if (c & 0x02) a[0x01] |= v;
-   else a[0x01] &= ~v;
-   if (c & 0x04) a[0x10] |= v;
-   else a[0x10] &= ~v;
-   if (c & 0x08) a[0x11] |= v;
-   else a[0x11] &= ~v;
+   fx_cachePixel(x, y, c, 4);
 }
 
 /* 4c(ALT1) - rpix - read color of the pixel with R1,R2 as x,y */
@@ -770,6 +834,7 @@ static void fx_rpix_4bit()
    uint8_t* a;
    uint8_t v;
 
+   FLUSHPIXELS;
    R15++;
    CLRFLAGS;
 
@@ -793,8 +858,7 @@ static void fx_plot_8bit()
 {
    uint32_t x = USEX8(R1);
    uint32_t y = USEX8(R2);
-   uint8_t* a;
-   uint8_t v, c;
+   uint8_t c;
 
    R15++;
    CLRFLAGS;
@@ -809,26 +873,7 @@ static void fx_plot_8bit()
       if (!(GSU.vPlotOptionReg & 0x01) && !(c & 0xf)) return;
    }
    else if (!(GSU.vPlotOptionReg & 0x01) && !c) return;
-
-   a = GSU.apvScreen[y >> 3] + GSU.x[x >> 3] + ((y & 7) << 1);
-   v = 128 >> (x & 7);
-
-   if (c & 0x01) a[0x00] |= v;
-   else a[0x00] &= ~v;
-   if (c & 0x02) a[0x01] |= v;
-   else a[0x01] &= ~v;
-   if (c & 0x04) a[0x10] |= v;
-   else a[0x10] &= ~v;
-   if (c & 0x08) a[0x11] |= v;
-   else a[0x11] &= ~v;
-   if (c & 0x10) a[0x20] |= v;
-   else a[0x20] &= ~v;
-   if (c & 0x20) a[0x21] |= v;
-   else a[0x21] &= ~v;
-   if (c & 0x40) a[0x30] |= v;
-   else a[0x30] &= ~v;
-   if (c & 0x80) a[0x31] |= v;
-   else a[0x31] &= ~v;
+   fx_cachePixel(x, y, c, 8);
 }
 
 /* 4c(ALT1) - rpix - read color of the pixel with R1,R2 as x,y */
@@ -839,6 +884,7 @@ static void fx_rpix_8bit()
    uint8_t* a;
    uint8_t v;
 
+   FLUSHPIXELS;
    R15++;
    CLRFLAGS;
 
@@ -907,6 +953,7 @@ static void fx_color()
 /* 4e(ALT1) - cmode - set plot option register */
 static void fx_cmode()
 {
+   FLUSHPIXELS;
    GSU.vPlotOptionReg = SREG;
 
    if (GSU.vPlotOptionReg & 0x10)
@@ -2118,6 +2165,7 @@ static void fx_umult_i15()
 /* 90 - sbk - store word to last accessed RAM address */
 static void fx_sbk()
 {
+   FLUSHPIXELS;
    RAM(GSU.vLastRamAdr) = (uint8_t)SREG;
    RAM(GSU.vLastRamAdr ^ 1) = (uint8_t)(SREG >> 8);
    CLRFLAGS;
@@ -2378,6 +2426,7 @@ static void fx_ibt_r15()
 
 /* a0-af(ALT1) - lms rn,(yy) - load word from RAM (short address) */
 #define FX_LMS(reg) \
+FLUSHPIXELS; \
 GSU.vLastRamAdr = ((uint32_t)PIPE) << 1; \
 R15++; FETCHPIPE; R15++; \
 GSU.avReg[reg] = (uint32_t)RAM(GSU.vLastRamAdr); \
@@ -2453,6 +2502,7 @@ static void fx_lms_r15()
 /* If rn == r15, is the value of r15 before or after the extra byte is read? */
 #define FX_SMS(reg) \
 uint32_t v = GSU.avReg[reg]; \
+FLUSHPIXELS; \
 GSU.vLastRamAdr = ((uint32_t)PIPE) << 1; \
 R15++; FETCHPIPE; \
 RAM(GSU.vLastRamAdr) = (uint8_t)v; \
@@ -3194,6 +3244,7 @@ static void fx_iwt_r15()
 
 /* f0-ff(ALT1) - lm rn,(xx) - load word from RAM */
 #define FX_LM(reg) \
+FLUSHPIXELS; \
 GSU.vLastRamAdr = PIPE; R15++; FETCHPIPE; R15++; \
 GSU.vLastRamAdr |= USEX8(PIPE) << 8; FETCHPIPE; R15++; \
 GSU.avReg[reg] = RAM(GSU.vLastRamAdr); \
@@ -3269,6 +3320,7 @@ static void fx_lm_r15()
 /* If rn == r15, is the value of r15 before or after the extra bytes are read? */
 #define FX_SM(reg) \
 uint32_t v = GSU.avReg[reg]; \
+FLUSHPIXELS; \
 GSU.vLastRamAdr = PIPE; R15++; FETCHPIPE; R15++; \
 GSU.vLastRamAdr |= USEX8(PIPE) << 8; FETCHPIPE; \
 RAM(GSU.vLastRamAdr) = (uint8_t)v; \
@@ -3341,12 +3393,31 @@ static void fx_sm_r15()
 
 /*** GSU executions functions ***/
 
+/* fx_run() is the hot loop, so it dispatches by hand instead of through
+ * FX_STEP: the opcode table is kept in a local, and the alt1/alt2/alt3
+ * prefixes (3d-3f) are folded into the loop since all they do is select
+ * which quarter of the table the next opcode is looked up in. The G flag
+ * needn't be tested either, fx_stop() zeroes the counter. */
 static uint32_t fx_run(uint32_t nInstructions)
 {
+   void (**ppfOpcodeTable)() = fx_ppfOpcodeTable;
+
    GSU.vCounter = nInstructions;
    READR14;
-   while (TF(G) && (GSU.vCounter-- > 0))
-      FX_STEP;
+   while (GSU.vCounter-- > 0)
+   {
+      uint32_t vOpcode = (uint32_t)PIPE;
+      FETCHPIPE;
+      if (vOpcode - 0x3d < 3)
+      {
+         /* alt1 = 3d, alt2 = 3e, alt3 = 3f */
+         GSU.vStatusReg = (GSU.vStatusReg & ~FLG_B) | ((vOpcode - 0x3c) << 8);
+         R15++;
+         continue;
+      }
+      (*ppfOpcodeTable[(GSU.vStatusReg & 0x300) | vOpcode])();
+   }
+   FLUSHPIXELS;
    /*
    #ifndef FX_ADDRESS_CHECK
       GSU.vPipeAdr = USEX16(R15-1) | (USEX8(GSU.vPrgBankReg)<<16);
@@ -3368,6 +3439,7 @@ static uint32_t fx_run_to_breakpoint(uint32_t nInstructions)
          break;
       }
    }
+   FLUSHPIXELS;
    /*
    #ifndef FX_ADDRESS_CHECK
    GSU.vPipeAdr = USEX16(R15-1) | (USEX8(GSU.vPrgBankReg)<<16);
@@ -3391,6 +3463,7 @@ static uint32_t fx_step_over(uint32_t nInstructions)
       if (USEX16(R15) == GSU.vStepPoint)
          break;
    }
+   FLUSHPIXELS;
    /*
    #ifndef FX_ADDRESS_CHECK
    GSU.vPipeAdr = USEX16(R15-1) | (USEX8(GSU.vPrgBankReg)<<16);
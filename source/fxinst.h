@@ -281,6 +281,7 @@ struct FxRegs_s
    uint32_t  vCounter;
    uint32_t  vInstCount;
    uint32_t  vSCBRDirty;    /* if SCBR is written, our cached screen pointers need updating */
+   uint32_t  vScreenRegsDirty; /* SCBR or SCMR written since the last session */
 };
 
 #define  FxRegs_s_null { \
@@ -289,6 +290,7 @@ struct FxRegs_s
      0,    0,      0,      0,   NULL,   0, NULL,   0, NULL,    0, \
      0, NULL, {NULL},    {0},      0,   0,    0,   0, NULL, NULL, \
   NULL, NULL,   NULL, {NULL}, {NULL},   0, NULL, {0},    0,    0, \
+     0, \
 }
 
 /* GSU registers */
@@ -145,6 +145,7 @@ INLINE uint8_t S9xGetByte(uint32_t Address)
                                 ((Address & 0xf0000) >> 3)) & Memory.SRAMMask)));
 
    case MAP_BWRAM:
+      S9xSA1Sync();
       return (*(Memory.BWRAM + ((Address & 0x7fff) - 0x6000)));
 
    case MAP_C4:
@@ -165,8 +166,16 @@ INLINE uint8_t S9xGetByte(uint32_t Address)
    case MAP_SETA_RISC:
       return S9xGetST018(Address);
 
+   case MAP_SUPERFX_RAM:
+      S9xSuperFXSync();
+      return (*(Memory.Map [block] + (Address & 0xffff)));
 
 
+
+   case MAP_SA1_SHARED:
+      S9xSA1Sync();
+      return (*S9xSA1SharedMemory(Address));
+
    case MAP_DEBUG:
       return OpenBus;
 
@@ -255,6 +264,7 @@ INLINE uint16_t S9xGetWord(uint32_t Address)
                    (((Address + 1) & 0xf0000) >> 3)) & Memory.SRAMMask)) << 8));
 
    case MAP_BWRAM:
+      S9xSA1Sync();
 #ifdef FAST_LSB_WORD_ACCESS
       return (*(uint16_t*)(Memory.BWRAM + ((Address & 0x7fff) - 0x6000)));
 #else
@@ -281,6 +291,20 @@ INLINE uint16_t S9xGetWord(uint32_t Address)
    case MAP_SETA_RISC:
       return S9xGetST018(Address) | (S9xGetST018((Address + 1)) << 8);
 
+   case MAP_SUPERFX_RAM:
+      S9xSuperFXSync();
+      GetAddress = Memory.Map [block] + (Address & 0xffff);
+      return (*GetAddress | (*(GetAddress + 1) << 8));
+
+   case MAP_SA1_SHARED:
+      S9xSA1Sync();
+      GetAddress = S9xSA1SharedMemory(Address);
+#ifdef FAST_LSB_WORD_ACCESS
+      return (*(uint16_t*) GetAddress);
+#else
+      return (*GetAddress | (*(GetAddress + 1) << 8));
+#endif
+
    case MAP_DEBUG:
       return (OpenBus | (OpenBus << 8));
 
@@ -363,10 +387,30 @@ INLINE void S9xSetByte(uint8_t Byte, uint32_t Address)
       return;
 
    case MAP_BWRAM:
+      S9xSA1Sync();
       *(Memory.BWRAM + ((Address & 0x7fff) - 0x6000)) = Byte;
       CPU.SRAMModified = true;
       return;
 
+   case MAP_SUPERFX_RAM:
+      S9xSuperFXSync();
+      *(Memory.WriteMap [block] + (Address & 0xffff)) = Byte;
+      return;
+
+   case MAP_SA1_SHARED:
+      S9xSA1Sync();
+      SetAddress = S9xSA1SharedMemory(Address);
+#ifdef CPU_SHUTDOWN
+      if (SetAddress == SA1.WaitByteAddress1 ||
+            SetAddress == SA1.WaitByteAddress2)
+      {
+         SA1.Executing = SA1.S9xOpcodes != NULL;
+         SA1.WaitCounter = 0;
+      }
+#endif
+      *SetAddress = Byte;
+      return;
+
    case MAP_DEBUG:
 
    case MAP_SA1RAM:
@@ -378,10 +422,6 @@ INLINE void S9xSetByte(uint8_t Byte, uint32_t Address)
       S9xSetC4(Byte, Address & 0xffff);
       return;
 
-   case MAP_SPC7110_DRAM:
-      s7r.bank50[(Address & 0xffff)] = (uint8_t) Byte;
-      break;
-
    case MAP_OBC_RAM:
       SetOBC1(Byte, Address & 0xFFFF);
       return;
@@ -504,6 +544,7 @@ INLINE void S9xSetWord(uint16_t Word, uint32_t Address)
       return;
 
    case MAP_BWRAM:
+      S9xSA1Sync();
 #ifdef FAST_LSB_WORD_ACCESS
       *(uint16_t*)(Memory.BWRAM + ((Address & 0x7fff) - 0x6000)) = Word;
 #else
@@ -513,12 +554,34 @@ INLINE void S9xSetWord(uint16_t Word, uint32_t Address)
       CPU.SRAMModified = true;
       return;
 
+   case MAP_SUPERFX_RAM:
+      S9xSuperFXSync();
+      SetAddress = Memory.WriteMap [block] + (Address & 0xffff);
+      *SetAddress = (uint8_t) Word;
+      *(SetAddress + 1) = Word >> 8;
+      return;
+
+   case MAP_SA1_SHARED:
+      S9xSA1Sync();
+      SetAddress = S9xSA1SharedMemory(Address);
+#ifdef CPU_SHUTDOWN
+      if (SetAddress == SA1.WaitByteAddress1 ||
+            SetAddress == SA1.WaitByteAddress2)
+      {
+         SA1.Executing = SA1.S9xOpcodes != NULL;
+         SA1.WaitCounter = 0;
+      }
+#endif
+#ifdef FAST_LSB_WORD_ACCESS
+      *(uint16_t*) SetAddress = Word;
+#else
+      *SetAddress = (uint8_t) Word;
+      *(SetAddress + 1) = Word >> 8;
+#endif
+      return;
+
    case MAP_DEBUG:
 
-   case MAP_SPC7110_DRAM:
-      s7r.bank50[(Address & 0xffff)] = (uint8_t) Word;
-      s7r.bank50[((Address + 1) & 0xffff)] = (uint8_t) Word;
-      break;
    case MAP_SA1RAM:
       *(Memory.SRAM + (Address & 0xffff)) = (uint8_t) Word;
       *(Memory.SRAM + ((Address + 1) & 0xffff)) = (uint8_t)(Word >> 8);
@@ -562,14 +625,8 @@ INLINE uint8_t* GetBasePointer(uint32_t Address)
    uint8_t* GetAddress = Memory.Map [(Address >> MEMMAP_SHIFT) & MEMMAP_MASK];
    if (GetAddress >= (uint8_t*) MAP_LAST)
       return (GetAddress);
-   if (Settings.SPC7110 && ((Address & 0x7FFFFF) == 0x4800))
-      return s7r.bank50;
    switch ((intptr_t) GetAddress)
    {
-   case MAP_SPC7110_DRAM:
-   {
-      return s7r.bank50;
-   }
    case MAP_SPC7110_ROM:
       return Get7110BasePtr(Address);
    case MAP_PPU:
@@ -586,6 +643,7 @@ INLINE uint8_t* GetBasePointer(uint32_t Address)
    case MAP_LOROM_SRAM:
       return (Memory.SRAM);
    case MAP_BWRAM:
+      S9xSA1Sync();
       return (Memory.BWRAM - 0x6000);
    case MAP_HIROM_SRAM:
       return (Memory.SRAM - 0x6000);
@@ -595,6 +653,12 @@ INLINE uint8_t* GetBasePointer(uint32_t Address)
       return GetBasePointerOBC1(Address);
    case MAP_SETA_DSP:
       return Memory.SRAM;
+   case MAP_SUPERFX_RAM:
+      S9xSuperFXSync();
+      return GetBasePointer(Address);
+   case MAP_SA1_SHARED:
+      S9xSA1Sync();
+      return (S9xSA1SharedMemory(Address) - (Address & 0xffff));
    case MAP_DEBUG:
 
    default:
@@ -615,13 +679,8 @@ INLINE uint8_t* S9xGetMemPointer(uint32_t Address)
    if (GetAddress >= (uint8_t*) MAP_LAST)
       return (GetAddress + (Address & 0xffff));
 
-   if (Settings.SPC7110 && ((Address & 0x7FFFFF) == 0x4800))
-      return s7r.bank50;
-
    switch ((intptr_t) GetAddress)
    {
-   case MAP_SPC7110_DRAM:
-      return &s7r.bank50[Address & 0x0000FFFF];
    case MAP_PPU:
       return (Memory.FillRAM + (Address & 0xffff));
    case MAP_CPU:
@@ -632,6 +691,7 @@ INLINE uint8_t* S9xGetMemPointer(uint32_t Address)
    case MAP_LOROM_SRAM:
       return (Memory.SRAM + (Address & 0xffff));
    case MAP_BWRAM:
+      S9xSA1Sync();
       return (Memory.BWRAM - 0x6000 + (Address & 0xffff));
    case MAP_HIROM_SRAM:
       return (Memory.SRAM - 0x6000 + (Address & 0xffff));
@@ -641,6 +701,12 @@ INLINE uint8_t* S9xGetMemPointer(uint32_t Address)
       return GetMemPointerOBC1(Address);
    case MAP_SETA_DSP:
       return Memory.SRAM + ((Address & 0xffff) & Memory.SRAMMask);
+   case MAP_SUPERFX_RAM:
+      S9xSuperFXSync();
+      return S9xGetMemPointer(Address);
+   case MAP_SA1_SHARED:
+      S9xSA1Sync();
+      return (S9xSA1SharedMemory(Address));
    case MAP_DEBUG:
    default:
    case MAP_NONE:
@@ -694,6 +760,7 @@ INLINE void S9xSetPCBase(uint32_t Address)
       return;
 
    case MAP_BWRAM:
+      S9xSA1Sync();
       CPU.PCBase = Memory.BWRAM - 0x6000;
       CPU.PC = CPU.PCBase + (Address & 0xffff);
       return;
@@ -707,6 +774,17 @@ INLINE void S9xSetPCBase(uint32_t Address)
       CPU.PC = CPU.PCBase + (Address & 0xffff);
       return;
 
+   case MAP_SUPERFX_RAM:
+      S9xSuperFXSync();
+      S9xSetPCBase(Address);
+      return;
+
+   case MAP_SA1_SHARED:
+      S9xSA1Sync();
+      CPU.PCBase = S9xSA1SharedMemory(Address) - (Address & 0xffff);
+      CPU.PC = CPU.PCBase + (Address & 0xffff);
+      return;
+
    case MAP_DEBUG:
 
    default:
@@ -174,6 +174,7 @@ void DrawTile16(uint32_t Tile, int32_t Offset, uint32_t StartLine,
 void DrawClippedTile16(uint32_t Tile, int32_t Offset,
                        uint32_t StartPixel, uint32_t Width,
                        uint32_t StartLine, uint32_t LineCount);
+uint8_t* GetCachedTileRow(uint32_t Tile, uint32_t StartLine);
 void DrawTile16HalfWidth(uint32_t Tile, int32_t Offset, uint32_t StartLine,
                          uint32_t LineCount);
 void DrawClippedTile16HalfWidth(uint32_t Tile, int32_t Offset,
@@ -568,11 +569,27 @@ void S9xBuildDirectColourMaps()
    IPPU.DirectColourMapsNeedRebuild = false;
 }
 
+// The VRAM data port keeps the Mode 7 cache current one byte at a time;
+// a full rebuild is only needed when VRAM is replaced wholesale (reset,
+// snapshot load).
+void S9xBuildMode7Cache()
+{
+   uint32_t i;
+   for (i = 0; i < 0x4000; i++)
+   {
+      IPPU.Mode7Map [i] = Memory.VRAM [i << 1];
+      IPPU.Mode7Chars [i] = Memory.VRAM [(i << 1) + 1];
+   }
+   IPPU.Mode7CacheNeedsRebuild = false;
+}
+
 void S9xStartScreenRefresh()
 {
    if (GFX.InfoStringTimeout > 0 && --GFX.InfoStringTimeout == 0)
       GFX.InfoString = NULL;
 
+   IPPU.ScreenReused = true;
+
    if (IPPU.RenderThisFrame)
    {
       if (!S9xInitUpdate())
@@ -581,6 +598,9 @@ void S9xStartScreenRefresh()
          return;
       }
 
+      IPPU.PreviousFrameChanged = IPPU.ScreenChanged;
+      IPPU.ScreenChanged = false;
+
       IPPU.RenderedFramesCount++;
       IPPU.PreviousLine = IPPU.CurrentLine = 0;
       IPPU.MaxBrightness = PPU.Brightness;
@@ -655,6 +675,11 @@ void RenderLine(uint8_t C)
 {
    if (IPPU.RenderThisFrame)
    {
+      // Keep last frame's values around so S9xUpdateScreen can tell whether
+      // this line can reuse the pixels already in GFX.Screen.
+      struct SLineData OldLineData = LineData[C];
+      struct SLineMatrixData OldLineMatrixData = LineMatrixData[C];
+
       LineData[C].BG[0].VOffset = PPU.BG[0].VOffset + 1;
       LineData[C].BG[0].HOffset = PPU.BG[0].HOffset;
       LineData[C].BG[1].VOffset = PPU.BG[1].VOffset + 1;
@@ -686,6 +711,9 @@ void RenderLine(uint8_t C)
             LineData[C].BG[3].HOffset = PPU.BG[3].HOffset;
          }
       }
+      IPPU.LineChanged[C] =
+         memcmp(&OldLineData, &LineData[C], sizeof(OldLineData)) != 0 ||
+         memcmp(&OldLineMatrixData, &LineMatrixData[C], sizeof(OldLineMatrixData)) != 0;
       IPPU.CurrentLine = C + 1;
    }
    else
@@ -795,6 +823,31 @@ inline void SelectTileRenderer(bool normal)
    }
 }
 
+// What S9xSetupOBJ last saw of each sprite that decides which lines it is
+// listed on and how many tiles it costs there.
+struct OBJFootprint
+{
+   uint8_t Y;
+   uint8_t Height;
+   uint8_t Width;
+   uint8_t VFlip;
+   uint8_t Tiles;    // 0 when the sprite is off screen horizontally
+};
+
+static struct OBJFootprint OBJFootprints [128];
+static bool OBJFootprintsValid = false;
+static uint8_t OBJFootprintsFirstSprite;
+static uint8_t OBJFootprintsSizeSelect;
+static bool OBJFootprintsInterlace;
+
+static void MarkOBJLines(bool* LineDirty, const struct OBJFootprint* f)
+{
+   uint8_t line, Y;
+   for (line = 0, Y = f->Y; f->Tiles && line < f->Height; Y++, line++)
+      if (Y < SNES_HEIGHT_EXTENDED)
+         LineDirty[Y] = true;
+}
+
 void S9xSetupOBJ()
 {
 #ifdef MK_DEBUG_RTO
@@ -870,18 +923,18 @@ void S9xSetupOBJ()
                                           PPU.FirstSprite);
 #endif
       /* normal case */
-      uint8_t LineOBJ[SNES_HEIGHT_EXTENDED];
-      memset(LineOBJ, 0, sizeof(LineOBJ));
-      int i;
-      for (i = 0; i < SNES_HEIGHT_EXTENDED; i++)
-      {
-         GFX.OBJLines[i].RTOFlags = 0;
-         GFX.OBJLines[i].Tiles = 34;
-      }
-      uint8_t FirstSprite = PPU.FirstSprite;
-      S = FirstSprite;
-      do
+      /* Diff every sprite's footprint against the last setup, and only
+       * rebuild the lines that a changed sprite used to cover or covers now.
+       * A full rebuild is the same thing with every line dirty. */
+      bool LineDirty[SNES_HEIGHT_EXTENDED];
+      bool AnyDirty = !OBJFootprintsValid
+                      || OBJFootprintsFirstSprite != PPU.FirstSprite
+                      || OBJFootprintsSizeSelect != PPU.OBJSizeSelect
+                      || OBJFootprintsInterlace != IPPU.InterlaceSprites;
+      memset(LineDirty, AnyDirty, sizeof(LineDirty));
+      for (S = 0; S < 128; S++)
       {
+         struct OBJFootprint New;
          if (PPU.OBJ[S].Size)
          {
             GFX.OBJWidths[S] = LargeWidth;
@@ -892,6 +945,11 @@ void S9xSetupOBJ()
             GFX.OBJWidths[S] = SmallWidth;
             Height = SmallHeight;
          }
+         New.Y = (uint8_t)(PPU.OBJ[S].VPos & 0xff);
+         New.Height = Height;
+         New.Width = GFX.OBJWidths[S];
+         New.VFlip = PPU.OBJ[S].VFlip;
+         New.Tiles = 0;
          int HPos = PPU.OBJ[S].HPos;
          if (HPos == -256) HPos = 256;
          if (HPos > -GFX.OBJWidths[S] && HPos <= 256)
@@ -902,44 +960,77 @@ void S9xSetupOBJ()
                GFX.OBJVisibleTiles[S] = (257 - HPos + 7) >> 3;
             else
                GFX.OBJVisibleTiles[S] = GFX.OBJWidths[S] >> 3;
+            New.Tiles = GFX.OBJVisibleTiles[S];
+         }
+         if (!AnyDirty && memcmp(&OBJFootprints[S], &New, sizeof(New)) != 0)
+         {
+            MarkOBJLines(LineDirty, &OBJFootprints[S]);
+            MarkOBJLines(LineDirty, &New);
+         }
+         OBJFootprints[S] = New;
+      }
+      OBJFootprintsValid = true;
+      OBJFootprintsFirstSprite = PPU.FirstSprite;
+      OBJFootprintsSizeSelect = PPU.OBJSizeSelect;
+      OBJFootprintsInterlace = IPPU.InterlaceSprites;
+
+      uint8_t LineOBJ[SNES_HEIGHT_EXTENDED];
+      int i;
+      for (i = 0; i < SNES_HEIGHT_EXTENDED; i++)
+      {
+         if (!LineDirty[i])
+            continue;
+         LineOBJ[i] = 0;
+         GFX.OBJLineRTO[i] = 0;
+         GFX.OBJLines[i].Tiles = 34;
+         AnyDirty = true;
+      }
+      if (AnyDirty)
+      {
+         uint8_t FirstSprite = PPU.FirstSprite;
+         S = FirstSprite;
+         do
+         {
+            struct OBJFootprint* f = &OBJFootprints[S];
             uint8_t line, Y;
-            for (line = 0, Y = (uint8_t)(PPU.OBJ[S].VPos & 0xff); line < Height; Y++, line++)
+            for (line = 0, Y = f->Y; f->Tiles && line < f->Height; Y++, line++)
             {
-               if (Y >= SNES_HEIGHT_EXTENDED) continue;
+               if (Y >= SNES_HEIGHT_EXTENDED || !LineDirty[Y]) continue;
                if (LineOBJ[Y] >= 32)
                {
-                  GFX.OBJLines[Y].RTOFlags |= 0x40;
+                  GFX.OBJLineRTO[Y] |= 0x40;
 #ifdef MK_DEBUG_RTO
                   if (Settings.BGLayering) fprintf(stderr, "%d: OBJ %02x ranged over\n", Y, S);
 #endif
                   continue;
                }
-               GFX.OBJLines[Y].Tiles -= GFX.OBJVisibleTiles[S];
-               if (GFX.OBJLines[Y].Tiles < 0) GFX.OBJLines[Y].RTOFlags |= 0x80;
+               GFX.OBJLines[Y].Tiles -= f->Tiles;
+               if (GFX.OBJLines[Y].Tiles < 0) GFX.OBJLineRTO[Y] |= 0x80;
                GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Sprite = S;
-               if (PPU.OBJ[S].VFlip)
+               if (f->VFlip)
                {
                   // Yes, Width not Height. It so happens that the
                   // sprites with H=2*W flip as two WxW sprites.
-                  GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Line = line ^ (GFX.OBJWidths[S] - 1);
+                  GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Line = line ^ (f->Width - 1);
                }
                else
                   GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Line = line;
                LineOBJ[Y]++;
             }
+            S = (S + 1) & 0x7F;
          }
-         S = (S + 1) & 0x7F;
-      }
-      while (S != FirstSprite);
+         while (S != FirstSprite);
 
-      int Y;
-      for (Y = 0; Y < SNES_HEIGHT_EXTENDED; Y++)
-      {
-         if (LineOBJ[Y] < 32) // Add the sentinel
-            GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Sprite = -1;
+         int Y;
+         for (Y = 0; Y < SNES_HEIGHT_EXTENDED; Y++)
+         {
+            if (LineDirty[Y] && LineOBJ[Y] < 32) // Add the sentinel
+               GFX.OBJLines[Y].OBJ[LineOBJ[Y]].Sprite = -1;
+         }
+         GFX.OBJLines[0].RTOFlags = GFX.OBJLineRTO[0];
+         for (Y = 1; Y < SNES_HEIGHT_EXTENDED; Y++)
+            GFX.OBJLines[Y].RTOFlags = GFX.OBJLineRTO[Y] | GFX.OBJLines[Y - 1].RTOFlags;
       }
-      for (Y = 1; Y < SNES_HEIGHT_EXTENDED; Y++)
-         GFX.OBJLines[Y].RTOFlags |= GFX.OBJLines[Y - 1].RTOFlags;
    }
    else
    {
@@ -1036,6 +1127,9 @@ void S9xSetupOBJ()
          }
          if (j < 32) GFX.OBJLines[Y].OBJ[j].Sprite = -1;
       }
+
+      // These lists follow no footprint; rebuild them all next time.
+      OBJFootprintsValid = false;
    }
 
 #ifdef MK_DEBUG_RTO
@@ -1057,6 +1151,7 @@ void S9xSetupOBJ()
 #endif
 
    IPPU.OBJChanged = false;
+   IPPU.ScreenChanged = true;
 }
 
 static void DrawOBJS(bool OnMain, uint8_t D)
@@ -1179,6 +1274,103 @@ static void DrawOBJS(bool OnMain, uint8_t D)
    }
    GFX.Z1 = D + 2;
 
+   if (GFX.PixSize == 1 && !(OnMain && SUB_OR_ADD(4)))
+   {
+      // Every sprite would go through plain DrawTile16 here, and the first
+      // opaque sprite pixel in list order always wins over the later ones
+      // (they all test against Z1). So resolve the sprites of a line into
+      // LinePix first, then write one depth-tested span per line.
+      uint8_t WinMask [256];
+      uint8_t LinePix [8 + 256 + 8]; // 128 + palette * 16 + colour, 0 = none
+      uint8_t LineZ [8 + 256 + 8];
+      bool WinStat = false;
+      int WinIdx = 0, x;
+
+      for (x = 0; x < 256; x++)
+      {
+         for (; WinIdx < 7 && Windows[WinIdx].Pos <= x; WinIdx++)
+            WinStat = Windows[WinIdx].Value;
+         WinMask [x] = WinStat;
+      }
+
+      uint32_t Y, Offset;
+      for (Y = GFX.StartY, Offset = Y * GFX.PPL; Y <= GFX.EndY;
+            Y++, Offset += GFX.PPL)
+      {
+         bool Drawn = false;
+         int I, S;
+#ifdef MK_DISABLE_TIME_OVER
+         int tiles = 0;
+#else
+         int tiles = GFX.OBJLines[Y].Tiles;
+#endif
+         memset(LinePix, 0, sizeof(LinePix));
+         for (I = 0; I < 32 && (S = GFX.OBJLines[Y].OBJ[I].Sprite) >= 0; I++)
+         {
+            tiles += GFX.OBJVisibleTiles[S];
+            if (tiles <= 0)
+               continue;
+
+            int Line = GFX.OBJLines[Y].OBJ[I].Line;
+            int BaseTile = (((Line << 1) + (PPU.OBJ[S].Name & 0xf0)) & 0xf0)
+                           | (PPU.OBJ[S].Name & 0x100);
+            int TileX = PPU.OBJ[S].Name & 0x0f;
+            int TileInc = 1;
+            bool HFlip = PPU.OBJ[S].HFlip;
+            uint8_t Palette = 128 + (PPU.OBJ[S].Palette << 4);
+            uint8_t Z = (PPU.OBJ[S].Priority + 1) * 4 + D;
+
+            if (HFlip)
+            {
+               TileX = (TileX + (GFX.OBJWidths[S] >> 3) - 1) & 0x0f;
+               TileInc = -1;
+            }
+
+            int X = PPU.OBJ[S].HPos;
+            if (X == -256) X = 256;
+            int t;
+            for (t = tiles; X <= 256 && X < PPU.OBJ[S].HPos + GFX.OBJWidths[S];
+                  TileX = (TileX + TileInc) & 0x0f, X += 8)
+            {
+               if (X < -7 || --t < 0 || X == 256) continue;
+
+               uint8_t* bp = GetCachedTileRow(BaseTile | TileX, (Line & 7) << 3);
+               if (!bp) continue;
+
+               uint8_t* pix = LinePix + 8 + X;
+               uint8_t* z = LineZ + 8 + X;
+               int N;
+               for (N = 0; N < 8; N++)
+               {
+                  uint8_t Pixel = bp [HFlip ? 7 - N : N];
+                  if (Pixel && !pix [N])
+                  {
+                     pix [N] = Palette + Pixel;
+                     z [N] = Z;
+                  }
+               }
+               Drawn = true;
+            }
+         }
+
+         if (!Drawn)
+            continue;
+
+         uint16_t* s = (uint16_t*) GFX.S + Offset;
+         uint8_t* d = GFX.DB + Offset;
+         for (x = 0; x < 256; x++)
+         {
+            uint8_t Pixel = LinePix [8 + x];
+            if (Pixel && WinMask [x] && GFX.Z1 > d [x])
+            {
+               s [x] = IPPU.ScreenColors [Pixel];
+               d [x] = LineZ [8 + x];
+            }
+         }
+      }
+      return;
+   }
+
    uint32_t Y, Offset;
    for (Y = GFX.StartY, Offset = Y * GFX.PPL; Y <= GFX.EndY;
          Y++, Offset += GFX.PPL)
@@ -2565,11 +2757,92 @@ static void DrawBackground(uint32_t BGMode, uint32_t bg, uint8_t Z1, uint8_t Z2)
    }
 }
 
+// Mode 7 samples are fetched MODE7_RUN pixels at a time from the
+// de-interleaved copy of VRAM in IPPU.Mode7Map/Mode7Chars.  The affine
+// stepping for a run has no loop-carried dependency, so the compiler can
+// vectorise it; only the tilemap and character lookups stay scalar.
+#define MODE7_RUN 8
+
+#define MODE7_PIXEL(X, Y) \
+   IPPU.Mode7Chars [(IPPU.Mode7Map [(((Y) & ~7) << 4) + ((X) >> 3)] << 6) + (((Y) & 7) << 3) + ((X) & 7)]
+
+// Wrapping playfield (Mode7Repeat == 0).
+static INLINE void FetchMode7Run(uint8_t* b, int AA, int BB, int CC, int DD, int aa, int cc)
+{
+   int X [MODE7_RUN], Y [MODE7_RUN];
+   int i;
+
+   for (i = 0; i < MODE7_RUN; i++)
+   {
+      X [i] = ((AA + aa * i + BB) >> 8) & 0x3ff;
+      Y [i] = ((CC + cc * i + DD) >> 8) & 0x3ff;
+   }
+   for (i = 0; i < MODE7_RUN; i++)
+      b [i] = MODE7_PIXEL(X [i], Y [i]);
+}
+
+// Outside the 1024x1024 playfield pixels are transparent, or come from
+// character 0 when Mode7Repeat is 3.
+static INLINE void FetchMode7RunClipped(uint8_t* b, int AA, int BB, int CC, int DD, int aa, int cc,
+                                        int x, int dir, int HOffset, int FillY)
+{
+   int X [MODE7_RUN], Y [MODE7_RUN];
+   int i;
+
+   for (i = 0; i < MODE7_RUN; i++)
+   {
+      X [i] = (AA + aa * i + BB) >> 8;
+      Y [i] = (CC + cc * i + DD) >> 8;
+   }
+   for (i = 0; i < MODE7_RUN; i++)
+   {
+      if (((X [i] | Y [i]) & ~0x3ff) == 0)
+         b [i] = MODE7_PIXEL(X [i], Y [i]);
+      else if (PPU.Mode7Repeat == 3)
+         b [i] = IPPU.Mode7Chars [(FillY << 3) + ((x + dir * i + HOffset) & 7)];
+      else
+         b [i] = 0;
+   }
+}
+
+// Draws the span [Left, Right) of the current line; PLOT stores the pixel
+// for a visible sample b at p.
+#define MODE7_SPAN(PLOT) \
+       { \
+      int x = startx; \
+      int count = Right - Left; \
+      while (count > 0) \
+      { \
+          uint8_t b8 [MODE7_RUN]; \
+          int n = count < MODE7_RUN ? count : MODE7_RUN; \
+          int i; \
+          if (!PPU.Mode7Repeat) \
+         FetchMode7Run (b8, AA, BB, CC, DD, aa, cc); \
+          else \
+         FetchMode7RunClipped (b8, AA, BB, CC, DD, aa, cc, x, dir, HOffset, (yy + CentreY) & 7); \
+          for (i = 0; i < n; i++, p++, d++) \
+          { \
+         uint32_t b = b8 [i]; \
+         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
+         if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
+         { \
+             PLOT; \
+             *d = GFX.Z1; \
+         } \
+          } \
+          AA += aa * n; \
+          CC += cc * n; \
+          x += dir * n; \
+          count -= n; \
+      } \
+       }
+
 #define RENDER_BACKGROUND_MODE7(TYPE,FUNC) \
     uint16_t *ScreenColors = IPPU.ScreenColors; \
     CHECK_SOUND(); \
 \
-    uint8_t *VRAM1 = Memory.VRAM + 1; \
+    if (IPPU.Mode7CacheNeedsRebuild) \
+   S9xBuildMode7Cache (); \
     if (GFX.r2130 & 1) \
     { \
    if (IPPU.DirectColourMapsNeedRebuild) \
@@ -2646,59 +2919,7 @@ static void DrawBackground(uint32_t BGMode, uint32_t bg, uint8_t Z1, uint8_t Z2)
        int AA = l->MatrixA * xx; \
        int CC = l->MatrixC * xx; \
 \
-       if (!PPU.Mode7Repeat) \
-       { \
-      int x; \
-      for (x = startx; x != endx; x += dir, AA += aa, CC += cc, p++, d++) \
-      { \
-          int X = ((AA + BB) >> 8) & 0x3ff; \
-          int Y = ((CC + DD) >> 8) & 0x3ff; \
-          uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-          uint32_t b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-          GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-          if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-          { \
-         *p = (FUNC); \
-         *d = GFX.Z1; \
-          } \
-      } \
-       } \
-       else \
-       { \
-      int x; \
-      for (x = startx; x != endx; x += dir, AA += aa, CC += cc, p++, d++) \
-      { \
-          int X = ((AA + BB) >> 8); \
-          int Y = ((CC + DD) >> 8); \
-\
-          if (((X | Y) & ~0x3ff) == 0) \
-          { \
-         uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-         uint32_t b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-         if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-         { \
-             *p = (FUNC); \
-             *d = GFX.Z1; \
-         } \
-          } \
-          else \
-          { \
-         if (PPU.Mode7Repeat == 3) \
-         { \
-             X = (x + HOffset) & 7; \
-             Y = (yy + CentreY) & 7; \
-             uint32_t b = *(VRAM1 + ((Y & 7) << 4) + ((X & 7) << 1)); \
-             GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-             if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-             { \
-            *p = (FUNC); \
-            *d = GFX.Z1; \
-             } \
-         } \
-          } \
-      } \
-       } \
+       MODE7_SPAN(*p = (FUNC)) \
    } \
     }
 
@@ -2760,7 +2981,8 @@ static void DrawBGMode7Background16Sub1_2(uint8_t* Screen, int bg)
     uint16_t *ScreenColors; \
     CHECK_SOUND(); \
 \
-    uint8_t *VRAM1 = Memory.VRAM + 1; \
+    if (IPPU.Mode7CacheNeedsRebuild) \
+        S9xBuildMode7Cache (); \
     if (GFX.r2130 & 1) \
     { \
         if (IPPU.DirectColourMapsNeedRebuild) \
@@ -2867,65 +3089,11 @@ static void DrawBGMode7Background16Sub1_2(uint8_t* Screen, int bg)
                 AA = l->MatrixA * xx; \
                 CC = l->MatrixC * xx; \
             } \
+            int count = Right - Left; \
             if (simpleCase) \
             { \
-                if (!PPU.Mode7Repeat) \
-                { \
-                    int x = startx; \
-                    do \
-                    { \
-                        int X = ((AA + BB) >> 8) & 0x3ff; \
-                        int Y = (DD >> 8) & 0x3ff; \
-                        uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-                        uint32_t b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                        if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-                        { \
-                            TYPE theColor = COLORFUNC; \
-                            *p = (FUNC) | ALPHA_BITS_MASK; \
-                            *d = GFX.Z1; \
-                        } \
-                        AA += aa, p++, d++; \
-         x += dir; \
-                    } while (x != endx); \
-                } \
-                else \
-                { \
-                    int x = startx; \
-                    do { \
-                        int X = (AA + BB) >> 8; \
-                        int Y = DD >> 8; \
-\
-                        if (((X | Y) & ~0x3ff) == 0) \
-                        { \
-                            uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-             uint32_t b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-             GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                            if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-                            { \
-                                TYPE theColor = COLORFUNC; \
-                                *p = (FUNC) | ALPHA_BITS_MASK; \
-                                *d = GFX.Z1; \
-                            } \
-                        } \
-                        else if (PPU.Mode7Repeat == 3) \
-                        { \
-                            X = (x + HOffset) & 7; \
-                            Y = (yy + CentreY) & 7; \
-             uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-             uint32_t b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-             GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                            if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
-                            { \
-                                TYPE theColor = COLORFUNC; \
-                                *p = (FUNC) | ALPHA_BITS_MASK; \
-                                *d = GFX.Z1; \
-                            } \
-                        } \
-                        AA += aa; p++; d++; \
-         x += dir; \
-                    } while (x != endx); \
-                } \
+                /* cc is zero here, so the span kernel steps along a single row */ \
+                MODE7_SPAN(TYPE theColor = COLORFUNC; *p = (FUNC) | ALPHA_BITS_MASK) \
             } \
             else if (!PPU.Mode7Repeat) \
             { \
@@ -2941,61 +3109,64 @@ static void DrawBGMode7Background16Sub1_2(uint8_t* Screen, int bg)
                 /* You can think of this as a kind of mipmapping. */ \
                 if ((aa < 460 && aa > -460) && (cc < 460 && cc > -460)) \
                 {\
-                    int x; \
-                    for (x = startx; x != endx; x += dir, AA += aa, CC += cc, p++, d++) \
+                    while (count > 0) \
                     { \
-                        uint32_t xPos = AA + BB; \
-                        uint32_t xPix = xPos >> 8; \
-                        uint32_t yPos = CC + DD; \
-                        uint32_t yPix = yPos >> 8; \
-                        uint32_t X = xPix & 0x3ff; \
-                        uint32_t Y = yPix & 0x3ff; \
-                        uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-         uint32_t b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                        if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
+                        uint8_t b8 [MODE7_RUN]; \
+                        int n = count < MODE7_RUN ? count : MODE7_RUN; \
+                        int i; \
+                        FetchMode7Run (b8, AA, BB, CC, DD, aa, cc); \
+                        for (i = 0; i < n; i++, AA += aa, CC += cc, p++, d++) \
                         { \
-                            /* X10 and Y01 are the X and Y coordinates of the next source point over. */ \
-                            uint32_t X10 = (xPix + dir) & 0x3ff; \
-                            uint32_t Y01 = (yPix + (PPU.Mode7VFlip?-1:1)) & 0x3ff; \
-                            uint8_t *TileData10 = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X10 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData11 = VRAM1 + (Memory.VRAM[((Y01 & ~7) << 5) + ((X10 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData01 = VRAM1 + (Memory.VRAM[((Y01 & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-                            uint32_t p1 = COLORFUNC; \
-                            p1 = (p1 & FIRST_THIRD_COLOR_MASK) | ((p1 & SECOND_COLOR_MASK) << 16); \
-                            b = *(TileData10 + ((Y & 7) << 4) + ((X10 & 7) << 1)); \
-                            uint32_t p2 = COLORFUNC; \
-                            p2 = (p2 & FIRST_THIRD_COLOR_MASK) | ((p2 & SECOND_COLOR_MASK) << 16); \
-                            b = *(TileData11 + ((Y01 & 7) << 4) + ((X10 & 7) << 1)); \
-                            uint32_t p4 = COLORFUNC; \
-                            p4 = (p4 & FIRST_THIRD_COLOR_MASK) | ((p4 & SECOND_COLOR_MASK) << 16); \
-                            b = *(TileData01 + ((Y01 & 7) << 4) + ((X & 7) << 1)); \
-                            uint32_t p3 = COLORFUNC; \
-                            p3 = (p3 & FIRST_THIRD_COLOR_MASK) | ((p3 & SECOND_COLOR_MASK) << 16); \
-                            /* Xdel, Ydel: position (in 1/32nds) between the points */ \
-                            uint32_t Xdel = (xPos >> 3) & 0x1F; \
-                            uint32_t Ydel = (yPos >> 3) & 0x1F; \
-                            uint32_t XY = (Xdel*Ydel) >> 5; \
-                            uint32_t area1 = 0x20 + XY - Xdel - Ydel; \
-                            uint32_t area2 = Xdel - XY; \
-                            uint32_t area3 = Ydel - XY; \
-                            uint32_t area4 = XY; \
-                            if(PPU.Mode7HFlip){ \
-                                uint32_t tmp=area1; area1=area2; area2=tmp; \
-                                tmp=area3; area3=area4; area4=tmp; \
-                            } \
-                            if(PPU.Mode7VFlip){ \
-                                uint32_t tmp=area1; area1=area3; area3=tmp; \
-                                tmp=area2; area2=area4; area4=tmp; \
+                            uint32_t b = b8 [i]; \
+                            GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
+                            if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
+                            { \
+                                uint32_t xPos = AA + BB; \
+                                uint32_t xPix = xPos >> 8; \
+                                uint32_t yPos = CC + DD; \
+                                uint32_t yPix = yPos >> 8; \
+                                uint32_t X = xPix & 0x3ff; \
+                                uint32_t Y = yPix & 0x3ff; \
+                                /* X10 and Y01 are the X and Y coordinates of the next source point over. */ \
+                                uint32_t X10 = (xPix + dir) & 0x3ff; \
+                                uint32_t Y01 = (yPix + (PPU.Mode7VFlip?-1:1)) & 0x3ff; \
+                                uint32_t p1 = COLORFUNC; \
+                                p1 = (p1 & FIRST_THIRD_COLOR_MASK) | ((p1 & SECOND_COLOR_MASK) << 16); \
+                                b = MODE7_PIXEL(X10, Y); \
+                                uint32_t p2 = COLORFUNC; \
+                                p2 = (p2 & FIRST_THIRD_COLOR_MASK) | ((p2 & SECOND_COLOR_MASK) << 16); \
+                                b = MODE7_PIXEL(X10, Y01); \
+                                uint32_t p4 = COLORFUNC; \
+                                p4 = (p4 & FIRST_THIRD_COLOR_MASK) | ((p4 & SECOND_COLOR_MASK) << 16); \
+                                b = MODE7_PIXEL(X, Y01); \
+                                uint32_t p3 = COLORFUNC; \
+                                p3 = (p3 & FIRST_THIRD_COLOR_MASK) | ((p3 & SECOND_COLOR_MASK) << 16); \
+                                /* Xdel, Ydel: position (in 1/32nds) between the points */ \
+                                uint32_t Xdel = (xPos >> 3) & 0x1F; \
+                                uint32_t Ydel = (yPos >> 3) & 0x1F; \
+                                uint32_t XY = (Xdel*Ydel) >> 5; \
+                                uint32_t area1 = 0x20 + XY - Xdel - Ydel; \
+                                uint32_t area2 = Xdel - XY; \
+                                uint32_t area3 = Ydel - XY; \
+                                uint32_t area4 = XY; \
+                                if(PPU.Mode7HFlip){ \
+                                    uint32_t tmp=area1; area1=area2; area2=tmp; \
+                                    tmp=area3; area3=area4; area4=tmp; \
+                                } \
+                                if(PPU.Mode7VFlip){ \
+                                    uint32_t tmp=area1; area1=area3; area3=tmp; \
+                                    tmp=area2; area2=area4; area4=tmp; \
+                                } \
+                                uint32_t tempColor = ((area1 * p1) + \
+                                                    (area2 * p2) + \
+                                                    (area3 * p3) + \
+                                                    (area4 * p4)) >> 5; \
+                                TYPE theColor = (tempColor & FIRST_THIRD_COLOR_MASK) | ((tempColor >> 16) & SECOND_COLOR_MASK); \
+                                *p = (FUNC) | ALPHA_BITS_MASK; \
+                                *d = GFX.Z1; \
                             } \
-                            uint32_t tempColor = ((area1 * p1) + \
-                                                (area2 * p2) + \
-                                                (area3 * p3) + \
-                                                (area4 * p4)) >> 5; \
-                            TYPE theColor = (tempColor & FIRST_THIRD_COLOR_MASK) | ((tempColor >> 16) & SECOND_COLOR_MASK); \
-                            *p = (FUNC) | ALPHA_BITS_MASK; \
-                            *d = GFX.Z1; \
                         } \
+                        count -= n; \
                     } \
                 } \
                 else \
@@ -3020,111 +3191,104 @@ static void DrawBGMode7Background16Sub1_2(uint8_t* Screen, int bg)
                     uint32_t DD10 = DD + ccDelX; \
                     uint32_t DD01 = DD + ddDelY; \
                     uint32_t DD11 = DD + ccDelX + ddDelY; \
-                    int x; \
-                    for (x = startx; x != endx; x += dir, AA += aa, CC += cc, p++, d++) \
+                    while (count > 0) \
                     { \
-                        uint32_t X = ((AA + BB) >> 8) & 0x3ff; \
-                        uint32_t Y = ((CC + DD) >> 8) & 0x3ff; \
-                        uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-         uint32_t b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                        if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
+                        uint8_t b8 [MODE7_RUN]; \
+                        int n = count < MODE7_RUN ? count : MODE7_RUN; \
+                        int i; \
+                        FetchMode7Run (b8, AA, BB, CC, DD, aa, cc); \
+                        for (i = 0; i < n; i++, AA += aa, CC += cc, p++, d++) \
                         { \
-                            /* X, Y, X10, Y10, etc. are the coordinates of the four pixels within the */ \
-                            /* source image that we're going to examine. */ \
-                            uint32_t X10 = ((AA + BB10) >> 8) & 0x3ff; \
-                            uint32_t Y10 = ((CC + DD10) >> 8) & 0x3ff; \
-                            uint32_t X01 = ((AA + BB01) >> 8) & 0x3ff; \
-                            uint32_t Y01 = ((CC + DD01) >> 8) & 0x3ff; \
-                            uint32_t X11 = ((AA + BB11) >> 8) & 0x3ff; \
-                            uint32_t Y11 = ((CC + DD11) >> 8) & 0x3ff; \
-                            uint8_t *TileData10 = VRAM1 + (Memory.VRAM[((Y10 & ~7) << 5) + ((X10 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData01 = VRAM1 + (Memory.VRAM[((Y01 & ~7) << 5) + ((X01 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData11 = VRAM1 + (Memory.VRAM[((Y11 & ~7) << 5) + ((X11 >> 2) & ~1)] << 7); \
-                            TYPE p1 = COLORFUNC; \
-                            b = *(TileData10 + ((Y10 & 7) << 4) + ((X10 & 7) << 1)); \
-                            TYPE p2 = COLORFUNC; \
-                            b = *(TileData01 + ((Y01 & 7) << 4) + ((X01 & 7) << 1)); \
-                            TYPE p3 = COLORFUNC; \
-                            b = *(TileData11 + ((Y11 & 7) << 4) + ((X11 & 7) << 1)); \
-                            TYPE p4 = COLORFUNC; \
-                            TYPE theColor = Q_INTERPOLATE(p1, p2, p3, p4); \
-                            *p = (FUNC) | ALPHA_BITS_MASK; \
-                            *d = GFX.Z1; \
+                            uint32_t b = b8 [i]; \
+                            GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
+                            if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
+                            { \
+                                /* X, Y, X10, Y10, etc. are the coordinates of the four pixels within the */ \
+                                /* source image that we're going to examine. */ \
+                                uint32_t X10 = ((AA + BB10) >> 8) & 0x3ff; \
+                                uint32_t Y10 = ((CC + DD10) >> 8) & 0x3ff; \
+                                uint32_t X01 = ((AA + BB01) >> 8) & 0x3ff; \
+                                uint32_t Y01 = ((CC + DD01) >> 8) & 0x3ff; \
+                                uint32_t X11 = ((AA + BB11) >> 8) & 0x3ff; \
+                                uint32_t Y11 = ((CC + DD11) >> 8) & 0x3ff; \
+                                TYPE p1 = COLORFUNC; \
+                                b = MODE7_PIXEL(X10, Y10); \
+                                TYPE p2 = COLORFUNC; \
+                                b = MODE7_PIXEL(X01, Y01); \
+                                TYPE p3 = COLORFUNC; \
+                                b = MODE7_PIXEL(X11, Y11); \
+                                TYPE p4 = COLORFUNC; \
+                                TYPE theColor = Q_INTERPOLATE(p1, p2, p3, p4); \
+                                *p = (FUNC) | ALPHA_BITS_MASK; \
+                                *d = GFX.Z1; \
+                            } \
                         } \
+                        count -= n; \
                     } \
                 } \
             } \
             else \
             { \
-                int x; \
-                for (x = startx; x != endx; x += dir, AA += aa, CC += cc, p++, d++) \
+                int x = startx; \
+                while (count > 0) \
                 { \
-                    uint32_t xPos = AA + BB; \
-                    uint32_t xPix = xPos >> 8; \
-                    uint32_t yPos = CC + DD; \
-                    uint32_t yPix = yPos >> 8; \
-                    uint32_t X = xPix; \
-                    uint32_t Y = yPix; \
-                    \
-\
-                    if (((X | Y) & ~0x3ff) == 0) \
+                    uint8_t b8 [MODE7_RUN]; \
+                    int n = count < MODE7_RUN ? count : MODE7_RUN; \
+                    int i; \
+                    FetchMode7RunClipped (b8, AA, BB, CC, DD, aa, cc, x, dir, HOffset, (yy + CentreY) & 7); \
+                    for (i = 0; i < n; i++, AA += aa, CC += cc, p++, d++) \
                     { \
-                        uint8_t *TileData = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-         uint32_t b = *(TileData + ((Y & 7) << 4) + ((X & 7) << 1)); \
-         GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
+                        uint32_t xPos = AA + BB; \
+                        uint32_t xPix = xPos >> 8; \
+                        uint32_t yPos = CC + DD; \
+                        uint32_t yPix = yPos >> 8; \
+                        uint32_t b = b8 [i]; \
+                        GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
                         if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
                         { \
-                            /* X10 and Y01 are the X and Y coordinates of the next source point over. */ \
-                            uint32_t X10 = (xPix + dir) & 0x3ff; \
-                            uint32_t Y01 = (yPix + dir) & 0x3ff; \
-                            uint8_t *TileData10 = VRAM1 + (Memory.VRAM[((Y & ~7) << 5) + ((X10 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData11 = VRAM1 + (Memory.VRAM[((Y01 & ~7) << 5) + ((X10 >> 2) & ~1)] << 7); \
-                            uint8_t *TileData01 = VRAM1 + (Memory.VRAM[((Y01 & ~7) << 5) + ((X >> 2) & ~1)] << 7); \
-                            uint32_t p1 = COLORFUNC; \
-                            p1 = (p1 & FIRST_THIRD_COLOR_MASK) | ((p1 & SECOND_COLOR_MASK) << 16); \
-                            b = *(TileData10 + ((Y & 7) << 4) + ((X10 & 7) << 1)); \
-                            uint32_t p2 = COLORFUNC; \
-                            p2 = (p2 & FIRST_THIRD_COLOR_MASK) | ((p2 & SECOND_COLOR_MASK) << 16); \
-                            b = *(TileData11 + ((Y01 & 7) << 4) + ((X10 & 7) << 1)); \
-                            uint32_t p4 = COLORFUNC; \
-                            p4 = (p4 & FIRST_THIRD_COLOR_MASK) | ((p4 & SECOND_COLOR_MASK) << 16); \
-                            b = *(TileData01 + ((Y01 & 7) << 4) + ((X & 7) << 1)); \
-                            uint32_t p3 = COLORFUNC; \
-                            p3 = (p3 & FIRST_THIRD_COLOR_MASK) | ((p3 & SECOND_COLOR_MASK) << 16); \
-                            /* Xdel, Ydel: position (in 1/32nds) between the points */ \
-                            uint32_t Xdel = (xPos >> 3) & 0x1F; \
-                            uint32_t Ydel = (yPos >> 3) & 0x1F; \
-                            uint32_t XY = (Xdel*Ydel) >> 5; \
-                            uint32_t area1 = 0x20 + XY - Xdel - Ydel; \
-                            uint32_t area2 = Xdel - XY; \
-                            uint32_t area3 = Ydel - XY; \
-                            uint32_t area4 = XY; \
-                            uint32_t tempColor = ((area1 * p1) + \
-                                                (area2 * p2) + \
-                                                (area3 * p3) + \
-                                                (area4 * p4)) >> 5; \
-                            TYPE theColor = (tempColor & FIRST_THIRD_COLOR_MASK) | ((tempColor >> 16) & SECOND_COLOR_MASK); \
-                            *p = (FUNC) | ALPHA_BITS_MASK; \
-                            *d = GFX.Z1; \
-                        } \
-                    } \
-                    else \
-                    { \
-                        if (PPU.Mode7Repeat == 3) \
-                        { \
-                            X = (x + HOffset) & 7; \
-                            Y = (yy + CentreY) & 7; \
-             uint32_t b = *(VRAM1 + ((Y & 7) << 4) + ((X & 7) << 1)); \
-             GFX.Z1 = Mode7Depths [(b & GFX.Mode7PriorityMask) >> 7]; \
-                            if (GFX.Z1 > *d && (b & GFX.Mode7Mask) ) \
+                            if (((xPix | yPix) & ~0x3ff) == 0) \
+                            { \
+                                uint32_t X = xPix; \
+                                uint32_t Y = yPix; \
+                                /* X10 and Y01 are the X and Y coordinates of the next source point over. */ \
+                                uint32_t X10 = (xPix + dir) & 0x3ff; \
+                                uint32_t Y01 = (yPix + dir) & 0x3ff; \
+                                uint32_t p1 = COLORFUNC; \
+                                p1 = (p1 & FIRST_THIRD_COLOR_MASK) | ((p1 & SECOND_COLOR_MASK) << 16); \
+                                b = MODE7_PIXEL(X10, Y); \
+                                uint32_t p2 = COLORFUNC; \
+                                p2 = (p2 & FIRST_THIRD_COLOR_MASK) | ((p2 & SECOND_COLOR_MASK) << 16); \
+                                b = MODE7_PIXEL(X10, Y01); \
+                                uint32_t p4 = COLORFUNC; \
+                                p4 = (p4 & FIRST_THIRD_COLOR_MASK) | ((p4 & SECOND_COLOR_MASK) << 16); \
+                                b = MODE7_PIXEL(X, Y01); \
+                                uint32_t p3 = COLORFUNC; \
+                                p3 = (p3 & FIRST_THIRD_COLOR_MASK) | ((p3 & SECOND_COLOR_MASK) << 16); \
+                                /* Xdel, Ydel: position (in 1/32nds) between the points */ \
+                                uint32_t Xdel = (xPos >> 3) & 0x1F; \
+                                uint32_t Ydel = (yPos >> 3) & 0x1F; \
+                                uint32_t XY = (Xdel*Ydel) >> 5; \
+                                uint32_t area1 = 0x20 + XY - Xdel - Ydel; \
+                                uint32_t area2 = Xdel - XY; \
+                                uint32_t area3 = Ydel - XY; \
+                                uint32_t area4 = XY; \
+                                uint32_t tempColor = ((area1 * p1) + \
+                                                    (area2 * p2) + \
+                                                    (area3 * p3) + \
+                                                    (area4 * p4)) >> 5; \
+                                TYPE theColor = (tempColor & FIRST_THIRD_COLOR_MASK) | ((tempColor >> 16) & SECOND_COLOR_MASK); \
+                                *p = (FUNC) | ALPHA_BITS_MASK; \
+                            } \
+                            else \
                             { \
                                 TYPE theColor = COLORFUNC; \
                                 *p = (FUNC) | ALPHA_BITS_MASK; \
-                                *d = GFX.Z1; \
                             } \
+                            *d = GFX.Z1; \
                         } \
                     } \
+                    x += dir * n; \
+                    count -= n; \
                 } \
             } \
         } \
@@ -3507,6 +3671,23 @@ void S9xUpdateScreen()
    // XXX: Check ForceBlank? Or anything else?
    PPU.RangeTimeOver |= GFX.OBJLines[GFX.EndY].RTOFlags;
 
+   // If nothing that feeds the renderer has changed since the frame now in
+   // GFX.Screen began, and these lines were latched with the same scroll and
+   // matrix values, the pixels from that frame are still correct.
+   if (!IPPU.ScreenChanged && !IPPU.PreviousFrameChanged)
+   {
+      uint32_t y;
+      for (y = GFX.StartY; y <= GFX.EndY; y++)
+         if (IPPU.LineChanged [y])
+            break;
+      if (y > GFX.EndY)
+      {
+         IPPU.PreviousLine = IPPU.CurrentLine;
+         return;
+      }
+   }
+   IPPU.ScreenReused = false;
+
    uint32_t starty = GFX.StartY;
    uint32_t endy = GFX.EndY;
 
@@ -100,6 +100,7 @@ void S9xSetupOBJ();
 void S9xUpdateScreen();
 void RenderLine(uint8_t line);
 void S9xBuildDirectColourMaps();
+void S9xBuildMode7Cache();
 
 // External port interface which must be implemented or initialised for each
 // port.
@@ -130,7 +131,7 @@ struct SGFX
    uint32_t Pitch;
 
    // Setup in call to S9xInitGFX()
-   int   Delta;
+   ptrdiff_t Delta;
    uint16_t* X2;
    uint16_t* ZERO_OR_X2;
    uint16_t* ZERO;
@@ -168,6 +169,7 @@ struct SGFX
          uint8_t Line;
       } OBJ[32];
    } OBJLines [SNES_HEIGHT_EXTENDED];
+   uint8_t  OBJLineRTO [SNES_HEIGHT_EXTENDED];   // RTOFlags of each line before they are accumulated
 
    uint8_t  r212c;
    uint8_t  r212d;
@@ -87,6 +87,7 @@
   Nintendo Co., Limited and its subsidiary companies.
 *******************************************************************************/
 
+#include <stdlib.h>
 #include <string.h>
 #ifdef HAVE_STRINGS_H
 #include <strings.h>
@@ -446,11 +447,15 @@ bool S9xInitMemory()
     IPPU.TileCached[TILE_4BIT] = (uint8_t*)malloc(MAX_4BIT_TILES);
     IPPU.TileCached[TILE_8BIT] = (uint8_t*)malloc(MAX_8BIT_TILES);
 
+    IPPU.Mode7Map = (uint8_t*)malloc(0x4000);
+    IPPU.Mode7Chars = (uint8_t*)malloc(0x4000);
+
     if (!Memory.RAM || !Memory.SRAM || !Memory.VRAM || !Memory.ROM || !Memory.BSRAM
         ||
         !IPPU.TileCache[TILE_2BIT] || !IPPU.TileCache[TILE_4BIT] ||
         !IPPU.TileCache[TILE_8BIT] || !IPPU.TileCached[TILE_2BIT] ||
-        !IPPU.TileCached[TILE_4BIT] || !IPPU.TileCached[TILE_8BIT])
+        !IPPU.TileCached[TILE_4BIT] || !IPPU.TileCached[TILE_8BIT] ||
+        !IPPU.Mode7Map || !IPPU.Mode7Chars)
     {
         S9xDeinitMemory();
         return (false);
@@ -483,6 +488,10 @@ bool S9xInitMemory()
     memset(IPPU.TileCached[TILE_4BIT], 0, MAX_4BIT_TILES);
     memset(IPPU.TileCached[TILE_8BIT], 0, MAX_8BIT_TILES);
 
+    memset(IPPU.Mode7Map, 0, 0x4000);
+    memset(IPPU.Mode7Chars, 0, 0x4000);
+    IPPU.Mode7CacheNeedsRebuild = false;
+
     Memory.SDD1Data = NULL;
     Memory.SDD1Index = NULL;
 
@@ -559,6 +568,17 @@ void S9xDeinitMemory()
         free((char*)IPPU.TileCached[TILE_8BIT]);
         IPPU.TileCached[TILE_8BIT] = NULL;
     }
+
+    if (IPPU.Mode7Map)
+    {
+        free((char*)IPPU.Mode7Map);
+        IPPU.Mode7Map = NULL;
+    }
+    if (IPPU.Mode7Chars)
+    {
+        free((char*)IPPU.Mode7Chars);
+        IPPU.Mode7Chars = NULL;
+    }
     FreeSDD1Data();
     Safe(NULL);
 }
@@ -575,6 +595,9 @@ void FreeSDD1Data()
         free((char*)Memory.SDD1Data);
         Memory.SDD1Data = NULL;
     }
+#ifdef SDD1_DECOMP
+    S9xSDD1FreeCache();
+#endif
 }
 
 /**********************************************************************************************/
@@ -597,8 +620,7 @@ bool LoadROM(const char* filename)
     Memory.ExtendedFormat = NOPE;
 
 
-    if (CleanUp7110 != NULL)
-        (*CleanUp7110)();
+    S9xSpc7110Deinit();
 
     memset(&SNESGameFixes, 0, sizeof(SNESGameFixes));
     SNESGameFixes.SRAMInitialValue = 0x60;
@@ -640,6 +662,8 @@ again:
 
     memcpy(Memory.ROM, src, TotalFileSize);
 
+    if (!Settings.NoPatch && game->path)
+        CheckForIPSPatch(game->path, Memory.HeaderCount != 0, &TotalFileSize);
 #else
     TotalFileSize = FileLoader(Memory.ROM, filename, MAX_ROM_SIZE);
 
@@ -1140,12 +1164,63 @@ void S9xDeinterleaveType2(bool reset)
     }
 }
 
+#ifndef MSB_FIRST
+// crc32Slice[k][b] is the CRC of byte b followed by k zero bytes, which lets
+// caCRC32 fold eight bytes per step instead of one.
+static uint32_t crc32Slice[8][256];
+static bool crc32SliceReady = false;
+
+static void InitCRC32Slices()
+{
+    int i, k;
+    for (i = 0; i < 256; i++)
+    {
+        crc32Slice[0][i] = crc32Table[i];
+        for (k = 1; k < 8; k++)
+            crc32Slice[k][i] = (crc32Slice[k - 1][i] >> 8) ^
+                crc32Table[crc32Slice[k - 1][i] & 0xFF];
+    }
+    crc32SliceReady = true;
+}
+#endif
+
 //CRC32 for char arrays
 uint32_t caCRC32(uint8_t* array, uint32_t size, register uint32_t crc32)
 {
-    register uint32_t i;
-    for (i = 0; i < size; i++)
-        crc32 = ((crc32 >> 8) & 0x00FFFFFF) ^ crc32Table[(crc32 ^ array[i]) & 0xFF];
+#ifndef MSB_FIRST
+    if (!crc32SliceReady)
+        InitCRC32Slices();
+
+    while (size > 0 && ((uintptr_t)array & 3))
+    {
+        crc32 = (crc32 >> 8) ^ crc32Table[(crc32 ^ *array++) & 0xFF];
+        size--;
+    }
+
+    while (size >= 8)
+    {
+        uint32_t one, two;
+        memcpy(&one, array, 4);
+        memcpy(&two, array + 4, 4);
+        one ^= crc32;
+        crc32 = crc32Slice[7][one & 0xFF] ^
+            crc32Slice[6][(one >> 8) & 0xFF] ^
+            crc32Slice[5][(one >> 16) & 0xFF] ^
+            crc32Slice[4][one >> 24] ^
+            crc32Slice[3][two & 0xFF] ^
+            crc32Slice[2][(two >> 8) & 0xFF] ^
+            crc32Slice[1][(two >> 16) & 0xFF] ^
+            crc32Slice[0][two >> 24];
+        array += 8;
+        size -= 8;
+    }
+#endif
+
+    while (size > 0)
+    {
+        crc32 = (crc32 >> 8) ^ crc32Table[(crc32 ^ *array++) & 0xFF];
+        size--;
+    }
     return ~crc32;
 }
 
@@ -1544,6 +1619,7 @@ bool SaveSRAM(const char* filename)
 {
     if (Settings.SuperFX && Memory.ROMType < 0x15)
         return true;
+    S9xSuperFXSync();
     if (Settings.SA1 && Memory.ROMType == 0x34)
         return true;
 
@@ -2486,6 +2562,29 @@ void SuperFXROMMap()
     WriteProtectROM();
 }
 
+// While a GSU session runs on its own thread the GSU owns its RAM, so the
+// CPU's view of it is swapped for MAP_SUPERFX_RAM; the accessors wait for
+// the session to finish before touching it. Mirrors SuperFXROMMap above.
+void SuperFXLockRAM(bool lock)
+{
+    int c;
+
+    for (c = 0; c < 0x400; c += 16)
+    {
+        uint8_t* ptr = lock ? (uint8_t*) MAP_SUPERFX_RAM : Memory.SRAM - 0x6000;
+        Memory.Map[0x006 + c] = Memory.Map[0x806 + c] = ptr;
+        Memory.Map[0x007 + c] = Memory.Map[0x807 + c] = ptr;
+        Memory.WriteMap[0x006 + c] = Memory.WriteMap[0x806 + c] = ptr;
+        Memory.WriteMap[0x007 + c] = Memory.WriteMap[0x807 + c] = ptr;
+    }
+
+    for (c = 0; c < 32; c++)
+    {
+        Memory.Map[c + 0x700] = Memory.WriteMap[c + 0x700] = lock ?
+            (uint8_t*) MAP_SUPERFX_RAM : Memory.SRAM + (((c >> 4) & 1) << 16);
+    }
+}
+
 void SA1ROMMap()
 {
     int c;
@@ -2563,6 +2662,16 @@ void SA1ROMMap()
     for (c = 0; c < 0x100; c++)
         SA1.Map[c + 0x600] = SA1.WriteMap[c + 0x600] = (uint8_t*)MAP_BWRAM_BITMAP;
 
+    // The main CPU reaches I-RAM and BW-RAM through MAP_SA1_SHARED so the
+    // SA-1 is caught up before either side of the shared memory is seen.
+    for (c = 0; c < 0x400; c += 16)
+    {
+        Memory.Map[c + 3] = Memory.Map[c + 0x803] = (uint8_t*)MAP_SA1_SHARED;
+        Memory.WriteMap[c + 3] = Memory.WriteMap[c + 0x803] = (uint8_t*)MAP_SA1_SHARED;
+    }
+    for (c = 0x400; c < 0x7e0; c++)
+        Memory.Map[c] = Memory.WriteMap[c] = (uint8_t*)MAP_SA1_SHARED;
+
     Memory.BWRAM = Memory.SRAM;
 }
 
@@ -3544,8 +3653,432 @@ const char* ROMID()
     return (Memory.ROMId);
 }
 
+/* Game specific fixes that only need a value poked somewhere are kept as data
+ * rather than as strcmp chains, and the rest of the per-game code is left for
+ * fixes that really are code. Rows matching the whole ROM name or the CRC are
+ * kept sorted and looked up with bsearch; only the few prefix, case-insensitive
+ * and ROMId rows are tried one by one. No game matches two rows that set the
+ * same thing to different values, so the order between tables doesn't matter. */
+enum
+{
+    ROMFIX_NAME,        // Memory.ROMName
+    ROMFIX_NAME_NOCASE, // Memory.ROMName, ignoring case
+    ROMFIX_ID,          // Memory.ROMId
+    ROMFIX_CRC          // Memory.ROMCRC32
+};
+
+enum
+{
+    FIX_BAD_DUMP,          // known hack or bad dump, tint the display red
+    FIX_DSP,               // Value is the DSP-n the cartridge really has
+    FIX_NMI_TRIGGER,       // CPU.NMITriggerPoint
+    FIX_NO_SHUTDOWN,       // spools samples over H-DMA, keep the CPU running
+    FIX_APU_CYCLE,         // IAPU.OneCycle
+    FIX_STARFOX,
+    FIX_WINTER_GOLD,
+    FIX_DAFFY_DUCK,
+    FIX_ECHO_ONLY_OUTPUT,
+    FIX_UNIRACERS,
+    FIX_ALIEN_VS_PREDATOR,
+    FIX_APU_OUTPORTS,
+    FIX_ENVELOPE_READING2,
+    FIX_H_MAX,             // Value is a percentage of SNES_CYCLES_PER_SCANLINE
+    FIX_H_MAX_FULL_SPEED,  // the same, only when running at 100% cycles
+    FIX_INTERLEAVE_MODE2,
+    FIX_SRAM_INITIAL_VALUE
+};
+
+typedef struct
+{
+    uint8_t     Match;
+    uint8_t     Length;  // 0 compares the whole string, otherwise a prefix
+    uint8_t     Fix;
+    int32_t     Value;
+    const char* Key;
+    uint32_t    CRC32;
+} SROMFix;
+
+#define FIX_NAME(k, f, v)               { ROMFIX_NAME, 0, f, v, k, 0 }
+#define FIX_NAME_PREFIX(k, f, v)        { ROMFIX_NAME, sizeof(k) - 1, f, v, k, 0 }
+#define FIX_NAME_NOCASE_PREFIX(k, f, v) { ROMFIX_NAME_NOCASE, sizeof(k) - 1, f, v, k, 0 }
+#define FIX_ID(k, f, v)                 { ROMFIX_ID, 0, f, v, k, 0 }
+#define FIX_ID_PREFIX(k, f, v)          { ROMFIX_ID, sizeof(k) - 1, f, v, k, 0 }
+#define FIX_CRC(c, f, v)                { ROMFIX_CRC, 0, f, v, NULL, c }
+
+// Prefix, case-insensitive and ROMId rows, tried one by one
+static const SROMFix ROMFixes[] =
+{
+    FIX_NAME_PREFIX("HIGHWAY BATTLE 2", FIX_BAD_DUMP, 0),
+
+    //DSP switching
+    FIX_NAME_PREFIX("DUNGEON MASTER", FIX_DSP, 2),
+    FIX_NAME_PREFIX("TOP GEAR 3000", FIX_DSP, 4),
+    FIX_NAME_PREFIX("PLANETS CHAMP TG3000", FIX_DSP, 4),
+
+    //Disabling a speed-up
+    FIX_NAME_NOCASE_PREFIX("MADDEN", FIX_NO_SHUTDOWN, 0),
+    FIX_NAME_PREFIX("NHL", FIX_NO_SHUTDOWN, 0),
+    FIX_NAME_PREFIX("WAR 2410", FIX_NO_SHUTDOWN, 0),
+
+    //APU timing hacks
+#ifndef USE_BLARGG_APU
+    FIX_ID("CQ  ", FIX_APU_CYCLE, 13),                 // Stunt Racer FX
+    FIX_ID_PREFIX("JG", FIX_APU_CYCLE, 13),            // Illusion of Gaia
+    FIX_ID("AVCJ", FIX_APU_CYCLE, 15),                 // RENDERING RANGER R2
+    //needs >= actual APU timing. (21 is .002 Mhz slower)
+    FIX_NAME_PREFIX("THE FISHING MASTER", FIX_APU_CYCLE, 15), //Mark Davis
+    FIX_ID_PREFIX("ARF", FIX_APU_CYCLE, 15),           // Star Ocean
+    FIX_ID_PREFIX("ATV", FIX_APU_CYCLE, 15),           // Tales of Phantasia
+    FIX_NAME_NOCASE_PREFIX("ActRaiser", FIX_APU_CYCLE, 15), // Act Raiser 1 & 2
+    FIX_ID_PREFIX("AQT", FIX_APU_CYCLE, 15),           // Terranigma
+    FIX_ID_PREFIX("E9 ", FIX_APU_CYCLE, 15),           // Robotrek
+    FIX_ID_PREFIX("APR", FIX_APU_CYCLE, 15),           // ZENNIHON PURORESU2
+    FIX_ID_PREFIX("A4B", FIX_APU_CYCLE, 15),           // Bomberman 4
+    FIX_ID_PREFIX("Y7 ", FIX_APU_CYCLE, 15),           // UFO KAMEN YAKISOBAN
+    FIX_ID_PREFIX("Y9 ", FIX_APU_CYCLE, 15),
+    FIX_ID_PREFIX("APB", FIX_APU_CYCLE, 15),           // Panic Bomber World
+    FIX_NAME_PREFIX("TokyoDome '95Battle 7", FIX_APU_CYCLE, 15),
+    FIX_NAME_PREFIX("SWORD WORLD SFC", FIX_APU_CYCLE, 15),
+    FIX_NAME_PREFIX("LETs PACHINKO(", FIX_APU_CYCLE, 15), //A set of BS games
+#endif
+
+    //Totally wacky display...
+    //seems to need a disproven behavior, so
+    //we're definitely overlooking some other bug?
+    FIX_NAME_PREFIX("UNIRACERS", FIX_UNIRACERS, 0),
+
+    // A Couple of HDMA related hacks - Lantus
+    FIX_ID("ASRJ", FIX_H_MAX_FULL_SPEED, 95),          // Street Racer
+    FIX_ID_PREFIX("A3R", FIX_H_MAX, 103),              // Power Rangers Fight
+    FIX_ID_PREFIX("AJE", FIX_H_MAX, 103),              // Clock Tower
+    // Mortal Kombat 3. Fixes cut off speech sample
+    FIX_ID_PREFIX("A3M", FIX_H_MAX_FULL_SPEED, 110),
+    // Start Trek: Deep Sleep 9
+    FIX_ID_PREFIX("A9D", FIX_H_MAX_FULL_SPEED, 110)
+};
+
+// Rows keyed on the whole of Memory.ROMName, sorted by strcmp for bsearch
+static const SROMFix ROMNameFixes[] =
+{
+    FIX_NAME("ALIEN vs. PREDATOR", FIX_H_MAX, 130),
+    FIX_NAME("ALIENS vs. PREDATOR", FIX_ALIEN_VS_PREDATOR, 0),
+    FIX_NAME("CACOMA KNIGHT", FIX_NMI_TRIGGER, 25),
+    FIX_NAME("CLAY FIGHTER", FIX_NO_SHUTDOWN, 0),
+    FIX_NAME("ClayFighter 2", FIX_NO_SHUTDOWN, 0),
+    FIX_NAME("DAFFY DUCK: MARV MISS", FIX_DAFFY_DUCK, 0),
+#ifndef USE_BLARGG_APU
+    FIX_NAME("DARK KINGDOM", FIX_APU_CYCLE, 15),
+#endif
+    FIX_NAME("DIRT RACER", FIX_WINTER_GOLD, 0),
+    FIX_NAME("EARTHWORM JIM 2", FIX_NO_SHUTDOWN, 0),
+#ifndef USE_BLARGG_APU
+    FIX_NAME("FISHING TO BASSING", FIX_APU_CYCLE, 15),
+    FIX_NAME("FORTUNE QUEST", FIX_APU_CYCLE, 15),
+#endif
+    FIX_NAME("FURAI NO SIREN", FIX_ENVELOPE_READING2, 0),
+    FIX_NAME("FX SKIING NINTENDO 96", FIX_WINTER_GOLD, 0),
+#ifndef USE_BLARGG_APU
+    FIX_NAME("GAIA GENSOUKI 1 JPN", FIX_APU_CYCLE, 13),
+#endif
+    FIX_NAME("GANBA LEAGUE", FIX_APU_OUTPORTS, 0),
+#ifndef USE_BLARGG_APU
+    FIX_NAME("HIOUDEN", FIX_APU_CYCLE, 15),
+#endif
+    FIX_NAME("HOME IMPROVEMENT", FIX_H_MAX, 200),
+    FIX_NAME("King Arthurs World", FIX_ECHO_ONLY_OUTPUT, 0),
+#ifndef USE_BLARGG_APU
+    FIX_NAME("MASTERS", FIX_APU_CYCLE, 15),             //Augusta 2 J
+    FIX_NAME("OHMONO BLACKBASS", FIX_APU_CYCLE, 15),
+#endif
+    FIX_NAME("PRIMAL RAGE", FIX_NO_SHUTDOWN, 0),
+    FIX_NAME("ROBOCOP VS TERMINATOR", FIX_DAFFY_DUCK, 0),
+    FIX_NAME("ROBOCOP VS THE TERMIN", FIX_DAFFY_DUCK, 0),
+    FIX_NAME("SATAN IS OUR FATHER!", FIX_SRAM_INITIAL_VALUE, 0x00),
+#ifndef USE_BLARGG_APU
+    FIX_NAME("SFC \xb6\xd2\xdd\xd7\xb2\xc0\xde\xb0", FIX_APU_CYCLE, 15), //Kamen Rider
+#endif
+    FIX_NAME("SFX SUPERBUTOUDEN2", FIX_H_MAX, 130),
+#ifndef USE_BLARGG_APU
+    FIX_NAME("SLAP STICK 1 JPN", FIX_APU_CYCLE, 15),
+    FIX_NAME("SOULBLADER - 1", FIX_APU_CYCLE, 15),
+    FIX_NAME("SOULBLAZER - 1 USA", FIX_APU_CYCLE, 15),  // Soulblazer
+#endif
+    FIX_NAME("STAR FOX", FIX_STARFOX, 0),
+#ifdef DETECT_NASTY_FX_INTERLEAVE
+    FIX_NAME("STAR FOX 2", FIX_INTERLEAVE_MODE2, 0),
+#endif
+    FIX_NAME("STAR WING", FIX_STARFOX, 0),
+    FIX_NAME("STONE PROTECTORS", FIX_H_MAX, 130),
+    FIX_NAME("SUPER BATTLETANK 2", FIX_H_MAX, 130),
+    FIX_NAME("SUPER DRIFT OUT", FIX_SRAM_INITIAL_VALUE, 0x00),
+#ifdef DETECT_NASTY_FX_INTERLEAVE
+    FIX_NAME("WILD TRAX", FIX_INTERLEAVE_MODE2, 0),
+#endif
+    FIX_NAME("WeaponLord", FIX_NO_SHUTDOWN, 0),
+#ifdef DETECT_NASTY_FX_INTERLEAVE
+    FIX_NAME("YOSHI'S ISLAND", FIX_INTERLEAVE_MODE2, 0),
+    FIX_NAME("YOSSY'S ISLAND", FIX_INTERLEAVE_MODE2, 0),
+#endif
+#ifndef USE_BLARGG_APU
+    FIX_NAME("ZAN3 SFC", FIX_APU_CYCLE, 15),
+#endif
+    FIX_NAME("ZENKI TENCHIMEIDOU", FIX_APU_OUTPORTS, 0),
+    FIX_NAME("goemon 4", FIX_SRAM_INITIAL_VALUE, 0x00),
+    FIX_NAME("\xbd\xb0\xca\xdf\xb0\xcc\xa7\xd0\xbd\xc0", FIX_APU_OUTPORTS, 0), //Super Famista
+    FIX_NAME("\xbd\xb0\xca\xdf\xb0\xcc\xa7\xd0\xbd\xc0 2", FIX_APU_OUTPORTS, 0), //Super Famista 2
+    FIX_NAME("\xbd\xda\xb2\xd4\xb0\xbd\xde", FIX_H_MAX_FULL_SPEED, 101), //Darkness Beyond Twilight
+#ifndef USE_BLARGG_APU
+    FIX_NAME("\xc3\xdd\xbc\xc9\xb3\xc0", FIX_APU_CYCLE, 15), //Tenshi no Uta
+#endif
+};
+
+/*
+HACKS NSRT can fix that we hadn't detected before.
+[14:25:13] <@Nach>     case 0x0c572ef0: //So called Hook (US)(2648)
+[14:25:13] <@Nach>     case 0x6810aa95: //Bazooka Blitzkreig swapped sizes hack -handled
+[14:25:17] <@Nach>     case 0x61E29C06: //The Tick region hack
+[14:25:19] <@Nach>     case 0x1EF90F74: //Jikkyou Keiba Simulation Stable Star PAL hack
+[14:25:23] <@Nach>     case 0x4ab225b5: //So called Krusty's Super Fun House (E)
+[14:25:25] <@Nach>     case 0x77fd806a: //Donkey Kong Country 2 (E) v1.1 bad dump -handled
+[14:25:27] <@Nach>     case 0x340f23e5: //Donkey Kong Country 3 (U) copier hack - handled
+*/
+// Rows keyed on Memory.ROMCRC32, sorted by CRC for bsearch
+static const SROMFix ROMCRCFixes[] =
+{
+    FIX_CRC(0x340f23e5, FIX_BAD_DUMP, 0),
+    FIX_CRC(0x6810aa95, FIX_BAD_DUMP, 0),
+    FIX_CRC(0x77fd806a, FIX_BAD_DUMP, 0)
+};
+
+#undef FIX_NAME
+#undef FIX_NAME_PREFIX
+#undef FIX_NAME_NOCASE_PREFIX
+#undef FIX_ID
+#undef FIX_ID_PREFIX
+#undef FIX_CRC
+
+//SA-1 Speedup settings, sorted by ROMId for bsearch
+enum
+{
+    SA1_WAIT_NONE,
+    SA1_WAIT_FILLRAM,
+    SA1_WAIT_SRAM
+};
+
+typedef struct
+{
+    const char* ROMId;
+    uint32_t    Address;
+    uint8_t     Byte1Base;
+    uint16_t    Byte1Offset;
+    uint8_t     Byte2Base;
+    uint16_t    Byte2Offset;
+} SSA1WaitFix;
+
+static const SSA1WaitFix SA1WaitFixes[] =
+{
+    { "A23J", 0xc25037, SA1_WAIT_SRAM, 0x0c06, SA1_WAIT_SRAM, 0x0c08 }, /* KATO HIFUMI9DAN SYOGI */
+    { "A2DJ", 0x008b62, SA1_WAIT_NONE, 0, SA1_WAIT_NONE, 0 }, /* debjk2 */
+    { "A3GE", 0x003700, SA1_WAIT_FILLRAM, 0x3102, SA1_WAIT_NONE, 0 }, /* PGA TOUR 96 */
+    { "A4RE", 0x009899, SA1_WAIT_FILLRAM, 0x3000, SA1_WAIT_NONE, 0 }, /* POWER RANGERS 4 */
+    { "A4WJ", 0xc048be, SA1_WAIT_NONE, 0, SA1_WAIT_NONE, 0 }, /* SHINING SCORPION */
+    { "AARJ", 0xc1f85a, SA1_WAIT_SRAM, 0x0c64, SA1_WAIT_SRAM, 0x0c66 }, /* ShougiNoHanamichi */
+    { "AEPE", 0x003700, SA1_WAIT_FILLRAM, 0x3102, SA1_WAIT_NONE, 0 }, /* PGA EUROPEAN TOUR */
+    { "AEVJ", 0x0ed18d, SA1_WAIT_FILLRAM, 0x3000, SA1_WAIT_NONE, 0 }, /* DAISENRYAKU EXPERTWW2 */
+    { "AFJE", 0x0082d4, SA1_WAIT_SRAM, 0x72a4, SA1_WAIT_NONE, 0 }, /* KIRBY'S DREAM LAND 3 */
+    { "AFJJ", 0x0082d4, SA1_WAIT_SRAM, 0x72a4, SA1_WAIT_NONE, 0 }, /* HOSHI NO KIRBY 3 */
+    { "AGFJ", 0x0181bc, SA1_WAIT_NONE, 0, SA1_WAIT_NONE, 0 }, /* SD F1 GRAND PRIX */
+    { "AHJJ", 0xc1002a, SA1_WAIT_SRAM, 0x0806, SA1_WAIT_SRAM, 0x0808 }, /* SHIN SHOUGI CLUB */
+    { "AIIJ", 0xc100be, SA1_WAIT_SRAM, 0x1002, SA1_WAIT_SRAM, 0x1004 }, /* idaten */
+    { "AITJ", 0x0080b7, SA1_WAIT_NONE, 0, SA1_WAIT_NONE, 0 }, /* igotais */
+    { "AJ6J", 0xc0f74a, SA1_WAIT_NONE, 0, SA1_WAIT_NONE, 0 }, /* J96 DREAM STADIUM */
+    { "AJOJ", 0x8084e5, SA1_WAIT_NONE, 0, SA1_WAIT_NONE, 0 }, /* OSHABERI PARODIUS */
+    { "AJUJ", 0x00d926, SA1_WAIT_NONE, 0, SA1_WAIT_NONE, 0 }, /* JumpinDerby */
+    { "AKAJ", 0x00f070, SA1_WAIT_NONE, 0, SA1_WAIT_NONE, 0 }, /* JKAKINOKI SHOUGI */
+    { "AKFE", 0x008cb8, SA1_WAIT_FILLRAM, 0x300a, SA1_WAIT_FILLRAM, 0x300e }, /* KIRBY SUPER DELUXE US */
+    { "AKFJ", 0x008c93, SA1_WAIT_FILLRAM, 0x300a, SA1_WAIT_FILLRAM, 0x300e }, /* KIRBY SUPER DELUXE JAP */
+    { "AO3J", 0x00dddb, SA1_WAIT_FILLRAM, 0x37b4, SA1_WAIT_NONE, 0 }, /* AUGUSTA3 MASTERS NEW */
+    { "AONJ", 0x00df33, SA1_WAIT_FILLRAM, 0x37b4, SA1_WAIT_NONE, 0 }, /* PEBBLE BEACH NEW */
+    { "APBJ", 0x00857a, SA1_WAIT_NONE, 0, SA1_WAIT_NONE, 0 }, /* PANIC BOMBER WORLD */
+    { "ARWE", 0xc0816f, SA1_WAIT_FILLRAM, 0x3000, SA1_WAIT_NONE, 0 }, /* SUPER MARIO RPG US */
+    { "ARWJ", 0xc0816f, SA1_WAIT_FILLRAM, 0x3000, SA1_WAIT_NONE, 0 }, /* SUPER MARIO RPG JAP */
+    { "ASYJ", 0x00f2cc, SA1_WAIT_SRAM, 0x7ffe, SA1_WAIT_SRAM, 0x7ffc }, /* SHOUGI MARJONG */
+    { "AVRJ", 0x0085f2, SA1_WAIT_FILLRAM, 0x3024, SA1_WAIT_NONE, 0 }, /* marvelous.zip */
+    { "AX2J", 0x00d675, SA1_WAIT_NONE, 0, SA1_WAIT_NONE, 0 }, /* shogisai2 */
+    { "AZIJ", 0x008083, SA1_WAIT_FILLRAM, 0x3020, SA1_WAIT_NONE, 0 }, /* Dragon Ballz HD */
+    { "ZBPJ", 0x0093f1, SA1_WAIT_FILLRAM, 0x304a, SA1_WAIT_NONE, 0 }, /* Bass Fishing */
+    { "ZX3J", 0x0087f2, SA1_WAIT_FILLRAM, 0x30c4, SA1_WAIT_NONE, 0 } /* SFC SDGUNDAMGNEXT */
+};
+
+typedef struct
+{
+    const char* ROMName;
+    uint32_t    Address;
+    uint8_t     OldValue;
+    uint8_t     NewValue;
+} SROMPatch;
+
+static const SROMPatch ROMPatches[] =
+{
+    // Love Quest
+    //BNE D0 into nops
+    { "LOVE QUEST", 0x1385ec, 0xd0, 0xea },
+    { "LOVE QUEST", 0x1385ed, 0xb2, 0xea },
+
+    //seems like the next instruction is a BRA
+    //otherwise, this one's too complex for MKendora
+    // Nangoku Syonen Papuwa Kun
+    //turns an LDY into an RTL?
+    { "NANGOKUSYONEN PAPUWA", 0x1f0d1, 0xa0, 0x6b },
+
+    //this is a cmp on $00:2140
+    // Super Batter Up
+    //BNE
+    { "Super Batter Up", 0x27ae0, 0xd0, 0xea },
+    { "Super Batter Up", 0x27ae1, 0xfa, 0xea }
+};
+
+static bool MatchROMFix(const SROMFix* fix)
+{
+    switch (fix->Match)
+    {
+    case ROMFIX_NAME:
+        return fix->Length ? strncmp(Memory.ROMName, fix->Key, fix->Length) == 0 :
+            strcmp(Memory.ROMName, fix->Key) == 0;
+    case ROMFIX_NAME_NOCASE:
+        return strncasecmp(Memory.ROMName, fix->Key, fix->Length) == 0;
+    case ROMFIX_ID:
+        return fix->Length ? strncmp(Memory.ROMId, fix->Key, fix->Length) == 0 :
+            strcmp(Memory.ROMId, fix->Key) == 0;
+    case ROMFIX_CRC:
+        return Memory.ROMCRC32 == fix->CRC32;
+    }
+    return false;
+}
+
+static void ApplyROMFix(const SROMFix* fix)
+{
+    switch (fix->Fix)
+    {
+    case FIX_BAD_DUMP:
+        Settings.DisplayColor = BUILD_PIXEL(31, 0, 0);
+        SET_UI_COLOR(255, 0, 0);
+        break;
+    case FIX_DSP:
+        if (fix->Value == 2)
+        {
+            SetDSP = &DSP2SetByte;
+            GetDSP = &DSP2GetByte;
+        }
+        else if (fix->Value == 4)
+        {
+            SetDSP = &DSP4SetByte;
+            GetDSP = &DSP4GetByte;
+        }
+        break;
+    case FIX_NMI_TRIGGER:
+        CPU.NMITriggerPoint = fix->Value;
+        break;
+    case FIX_NO_SHUTDOWN:
+        Settings.Shutdown = false;
+        break;
+#ifndef USE_BLARGG_APU
+    case FIX_APU_CYCLE:
+        IAPU.OneCycle = fix->Value;
+        break;
+#endif
+    case FIX_STARFOX:
+        Settings.StarfoxHack = true;
+        break;
+    case FIX_WINTER_GOLD:
+        Settings.WinterGold = true;
+        break;
+    case FIX_DAFFY_DUCK:
+        Settings.DaffyDuck = true;
+        break;
+    case FIX_ECHO_ONLY_OUTPUT:
+        SNESGameFixes.EchoOnlyOutput = true;
+        break;
+    case FIX_UNIRACERS:
+        SNESGameFixes.Uniracers = true;
+        break;
+    case FIX_ALIEN_VS_PREDATOR:
+        SNESGameFixes.alienVSpredetorFix = true;
+        break;
+    case FIX_APU_OUTPORTS:
+        SNESGameFixes.APU_OutPorts_ReturnValueFix = true;
+        break;
+    case FIX_ENVELOPE_READING2:
+        SNESGameFixes.SoundEnvelopeHeightReading2 = true;
+        break;
+    case FIX_H_MAX_FULL_SPEED:
+        if (Settings.CyclesPercentage != 100)
+            break;
+        /* fall through */
+    case FIX_H_MAX:
+        Settings.H_Max = (SNES_CYCLES_PER_SCANLINE * fix->Value) / 100;
+        break;
+#ifdef DETECT_NASTY_FX_INTERLEAVE
+    case FIX_INTERLEAVE_MODE2:
+        CPU.TriedInterleavedMode2 = true;
+        break;
+#endif
+    case FIX_SRAM_INITIAL_VALUE:
+        SNESGameFixes.SRAMInitialValue = fix->Value;
+        break;
+    }
+}
+
+static int CompareROMNameFix(const void* key, const void* entry)
+{
+    return strcmp((const char*)key, ((const SROMFix*)entry)->Key);
+}
+
+static int CompareROMCRCFix(const void* key, const void* entry)
+{
+    uint32_t crc = *(const uint32_t*)key;
+    uint32_t fix = ((const SROMFix*)entry)->CRC32;
+    return crc < fix ? -1 : crc > fix;
+}
+
+// Applies every row of a sorted table whose key compares equal to key
+static void ApplySortedROMFixes(const void* key, const SROMFix* fixes,
+    size_t count, int (*compare)(const void*, const void*))
+{
+    const SROMFix* fix = (const SROMFix*)bsearch(key, fixes, count,
+        sizeof(SROMFix), compare);
+    const SROMFix* end = fixes + count;
+
+    if (!fix)
+        return;
+    while (fix > fixes && compare(key, fix - 1) == 0)
+        fix--;
+    for (; fix < end && compare(key, fix) == 0; fix++)
+        ApplyROMFix(fix);
+}
+
+static int CompareSA1WaitFix(const void* key, const void* entry)
+{
+    return strcmp((const char*)key, ((const SSA1WaitFix*)entry)->ROMId);
+}
+
+static uint8_t* SA1WaitByte(uint8_t base, uint16_t offset)
+{
+    switch (base)
+    {
+    case SA1_WAIT_FILLRAM:
+        return Memory.FillRAM + offset;
+    case SA1_WAIT_SRAM:
+        return Memory.SRAM + offset;
+    }
+    return NULL;
+}
+
 void ApplyROMFixes()
 {
+    uint32_t i;
+    const SSA1WaitFix* wait;
+
 #ifdef __W32_HEAP
     if (_HEAPOK != _heapchk())
         MessageBox(GUI.hWnd, "ApplyROMFixes", "Heap Corrupt", MB_OK);
@@ -3560,37 +4093,13 @@ void ApplyROMFixes()
         SET_UI_COLOR(255, 0, 0);
     }
 
-    /*
-    HACKS NSRT can fix that we hadn't detected before.
-    [14:25:13] <@Nach>     case 0x0c572ef0: //So called Hook (US)(2648)
-    [14:25:13] <@Nach>     case 0x6810aa95: //Bazooka Blitzkreig swapped sizes hack -handled
-    [14:25:17] <@Nach>     case 0x61E29C06: //The Tick region hack
-    [14:25:19] <@Nach>     case 0x1EF90F74: //Jikkyou Keiba Simulation Stable Star PAL hack
-    [14:25:23] <@Nach>     case 0x4ab225b5: //So called Krusty's Super Fun House (E)
-    [14:25:25] <@Nach>     case 0x77fd806a: //Donkey Kong Country 2 (E) v1.1 bad dump -handled
-    [14:25:27] <@Nach>     case 0x340f23e5: //Donkey Kong Country 3 (U) copier hack - handled
-    */
-
-    if (Memory.ROMCRC32 == 0x6810aa95 || Memory.ROMCRC32 == 0x340f23e5
-        || Memory.ROMCRC32 == 0x77fd806a ||
-        strncmp(Memory.ROMName, "HIGHWAY BATTLE 2", 16) == 0 ||
-        (strcmp(Memory.ROMName, "FX SKIING NINTENDO 96") == 0
-            && Memory.ROM[0x7FDA] == 0))
+    if (strcmp(Memory.ROMName, "FX SKIING NINTENDO 96") == 0
+        && Memory.ROM[0x7FDA] == 0)
     {
         Settings.DisplayColor = BUILD_PIXEL(31, 0, 0);
         SET_UI_COLOR(255, 0, 0);
     }
 
-    //Ambiguous chip function pointer assignments
-
-    //DSP switching:
-    if (strncmp(Memory.ROMName, "DUNGEON MASTER", 14) == 0)
-    {
-        //Set DSP-2
-        SetDSP = &DSP2SetByte;
-        GetDSP = &DSP2GetByte;
-    }
-
 #ifdef DSP_DUMMY_LOOPS
     if (strncmp(ROMName, "SD\x0b6\x0de\x0dd\x0c0\x0de\x0d1GX", 10) == 0)
     {
@@ -3600,14 +4109,6 @@ void ApplyROMFixes()
     }
 #endif
 
-    if (strncmp(Memory.ROMName, "TOP GEAR 3000", 13) == 0
-        || strncmp(Memory.ROMName, "PLANETS CHAMP TG3000", 20) == 0)
-    {
-        //Set DSP-4
-        SetDSP = &DSP4SetByte;
-        GetDSP = &DSP4GetByte;
-    }
-
     //memory map corrections
     if (strncmp(Memory.ROMName, "XBAND", 5) == 0)
     {
@@ -3685,354 +4186,50 @@ void ApplyROMFixes()
     }
 
 
-    //NMI hacks
     CPU.NMITriggerPoint = 4;
-    if (strcmp(Memory.ROMName, "CACOMA KNIGHT") == 0)
-        CPU.NMITriggerPoint = 25;
-
-    //Disabling a speed-up
-    // Games which spool sound samples between the SNES and sound CPU using
-    // H-DMA as the sample is playing.
-    if (strcmp(Memory.ROMName, "EARTHWORM JIM 2") == 0 ||
-        strcmp(Memory.ROMName, "PRIMAL RAGE") == 0 ||
-        strcmp(Memory.ROMName, "CLAY FIGHTER") == 0 ||
-        strcmp(Memory.ROMName, "ClayFighter 2") == 0 ||
-        strncasecmp(Memory.ROMName, "MADDEN", 6) == 0 ||
-        strncmp(Memory.ROMName, "NHL", 3) == 0 ||
-        strcmp(Memory.ROMName, "WeaponLord") == 0 ||
-        strncmp(Memory.ROMName, "WAR 2410", 8) == 0)
-        Settings.Shutdown = false;
-
-
-    //APU timing hacks
-
-#ifndef USE_BLARGG_APU
-   // Stunt Racer FX
-    if (strcmp(Memory.ROMId, "CQ  ") == 0 ||
-        // Illusion of Gaia
-        strncmp(Memory.ROMId, "JG", 2) == 0 ||
-        strcmp(Memory.ROMName, "GAIA GENSOUKI 1 JPN") == 0)
-        IAPU.OneCycle = 13;
-
-
-    // RENDERING RANGER R2
-    if (strcmp(Memory.ROMId, "AVCJ") == 0 ||
-        //Mark Davis
-        strncmp(Memory.ROMName, "THE FISHING MASTER", 18) == 0
-        || //needs >= actual APU timing. (21 is .002 Mhz slower)
-        // Star Ocean
-        strncmp(Memory.ROMId, "ARF", 3) == 0 ||
-        // Tales of Phantasia
-        strncmp(Memory.ROMId, "ATV", 3) == 0 ||
-        // Act Raiser 1 & 2
-        strncasecmp(Memory.ROMName, "ActRaiser", 9) == 0 ||
-        // Soulblazer
-        strcmp(Memory.ROMName, "SOULBLAZER - 1 USA") == 0 ||
-        strcmp(Memory.ROMName, "SOULBLADER - 1") == 0 ||
-
-        // Terranigma
-        strncmp(Memory.ROMId, "AQT", 3) == 0 ||
-        // Robotrek
-        strncmp(Memory.ROMId, "E9 ", 3) == 0 ||
-        strcmp(Memory.ROMName, "SLAP STICK 1 JPN") == 0 ||
-        // ZENNIHON PURORESU2
-        strncmp(Memory.ROMId, "APR", 3) == 0 ||
-        // Bomberman 4
-        strncmp(Memory.ROMId, "A4B", 3) == 0 ||
-        // UFO KAMEN YAKISOBAN
-        strncmp(Memory.ROMId, "Y7 ", 3) == 0 ||
-        strncmp(Memory.ROMId, "Y9 ", 3) == 0 ||
-        // Panic Bomber World
-        strncmp(Memory.ROMId, "APB", 3) == 0 ||
-        ((strncmp(Memory.ROMName, "Parlor", 6) == 0 ||
-            strcmp(Memory.ROMName, "HEIWA Parlor!Mini8") == 0 ||
-            strncmp(Memory.ROMName, "SANKYO Fever! ̨��ް!", 21) == 0) &&
-            strcmp(Memory.CompanyId, "A0") == 0) ||
-        strcmp(Memory.ROMName, "DARK KINGDOM") == 0 ||
-        strcmp(Memory.ROMName, "ZAN3 SFC") == 0 ||
-        strcmp(Memory.ROMName, "HIOUDEN") == 0 ||
-        strcmp(Memory.ROMName, "�ݼɳ�") == 0 ||   //Tenshi no Uta
-        strcmp(Memory.ROMName, "FORTUNE QUEST") == 0 ||
-        strcmp(Memory.ROMName, "FISHING TO BASSING") == 0 ||
-        strncmp(Memory.ROMName, "TokyoDome '95Battle 7", 21) == 0 ||
-        strcmp(Memory.ROMName, "OHMONO BLACKBASS") == 0 ||
-        strncmp(Memory.ROMName, "SWORD WORLD SFC", 15) == 0 ||
-        strcmp(Memory.ROMName, "MASTERS") == 0 || //Augusta 2 J
-        strcmp(Memory.ROMName, "SFC ���ײ�ް") == 0
-        ||  //Kamen Rider
-        strncmp(Memory.ROMName, "LETs PACHINKO(", 14) == 0)  //A set of BS games
-        IAPU.OneCycle = 15;
-#endif
-
-    //Specific game fixes
-
-    Settings.StarfoxHack = strcmp(Memory.ROMName, "STAR FOX") == 0 ||
-        strcmp(Memory.ROMName, "STAR WING") == 0;
-    Settings.WinterGold = strcmp(Memory.ROMName, "FX SKIING NINTENDO 96") == 0 ||
-        strcmp(Memory.ROMName, "DIRT RACER") == 0 ||
-        Settings.StarfoxHack;
-
-
-    if ((strcmp(Memory.ROMName, "LEGEND") == 0 && !Settings.PAL) ||
-        strcmp(Memory.ROMName, "King Arthurs World") == 0)
-        SNESGameFixes.EchoOnlyOutput = true;
-
-
-    Settings.DaffyDuck = (strcmp(Memory.ROMName, "DAFFY DUCK: MARV MISS") == 0) ||
-        (strcmp(Memory.ROMName, "ROBOCOP VS THE TERMIN") == 0) ||
-        (strcmp(Memory.ROMName, "ROBOCOP VS TERMINATOR") == 0);  //ROBOCOP VS THE TERMIN
+    Settings.StarfoxHack = false;
+    Settings.WinterGold = false;
+    Settings.DaffyDuck = false;
     Settings.HBlankStart = (256 * Settings.H_Max) / SNES_HCOUNTER_MAX;
 
-    //OAM hacks because we don't fully understand the
-    //behavior of the SNES.
-
-    //Totally wacky display...
-    //seems to need a disproven behavior, so
-    //we're definitely overlooking some other bug?
-    if (strncmp(Memory.ROMName, "UNIRACERS", 9) == 0)
-        SNESGameFixes.Uniracers = true;
-
-
-    //is this even useful now?
-    if (strcmp(Memory.ROMName, "ALIENS vs. PREDATOR") == 0)
-        SNESGameFixes.alienVSpredetorFix = true;
-
-    if (strcmp(Memory.ROMName, "���̧߰н�") == 0
-        ||   //Super Famista
-        strcmp(Memory.ROMName, "���̧߰н� 2") == 0
-        ||  //Super Famista 2
-        strcmp(Memory.ROMName, "ZENKI TENCHIMEIDOU") == 0 ||
-        strcmp(Memory.ROMName, "GANBA LEAGUE") == 0)
-        SNESGameFixes.APU_OutPorts_ReturnValueFix = true;
-
-    if (strcmp(Memory.ROMName, "FURAI NO SIREN") == 0)
-        SNESGameFixes.SoundEnvelopeHeightReading2 = true;
-
     //CPU timing hacks
     Settings.H_Max = (SNES_CYCLES_PER_SCANLINE *
         Settings.CyclesPercentage) / 100;
 
-    //no need to ifdef for right now...
-    //#ifdef HDMA_HACKS
-
-    // A Couple of HDMA related hacks - Lantus
-    if ((strcmp(Memory.ROMName, "SFX SUPERBUTOUDEN2") == 0) ||
-        (strcmp(Memory.ROMName, "ALIEN vs. PREDATOR") == 0) ||
-        (strcmp(Memory.ROMName, "STONE PROTECTORS") == 0) ||
-        (strcmp(Memory.ROMName, "SUPER BATTLETANK 2") == 0))
-        Settings.H_Max = (SNES_CYCLES_PER_SCANLINE * 130) / 100;
-
-    if (strcmp(Memory.ROMName, "HOME IMPROVEMENT") == 0)
-        Settings.H_Max = (SNES_CYCLES_PER_SCANLINE * 200) / 100;
-
-    // End HDMA hacks
-    //#endif
-
+    for (i = 0; i < sizeof(ROMFixes) / sizeof(ROMFixes[0]); i++)
+        if (MatchROMFix(&ROMFixes[i]))
+            ApplyROMFix(&ROMFixes[i]);
+    ApplySortedROMFixes(Memory.ROMName, ROMNameFixes,
+        sizeof(ROMNameFixes) / sizeof(ROMNameFixes[0]), CompareROMNameFix);
+    ApplySortedROMFixes(&Memory.ROMCRC32, ROMCRCFixes,
+        sizeof(ROMCRCFixes) / sizeof(ROMCRCFixes[0]), CompareROMCRCFix);
 
-    if (strcmp(Memory.ROMId, "ASRJ") == 0 && Settings.CyclesPercentage == 100)
-        // Street Racer
-        Settings.H_Max = (SNES_CYCLES_PER_SCANLINE * 95) / 100;
-
-    // Power Rangers Fight
-    if (strncmp(Memory.ROMId, "A3R", 3) == 0 ||
-        // Clock Tower
-        strncmp(Memory.ROMId, "AJE", 3) == 0)
-        Settings.H_Max = (SNES_CYCLES_PER_SCANLINE * 103) / 100;
-
-
-    if (strncmp(Memory.ROMId, "A3M", 3) == 0 && Settings.CyclesPercentage == 100)
-        // Mortal Kombat 3. Fixes cut off speech sample
-        Settings.H_Max = (SNES_CYCLES_PER_SCANLINE * 110) / 100;
-
-    //Darkness Beyond Twilight
-    //Crimson beyond blood that flows
-    //buried in the stream of time
-    //is where your power grows
-    //I pledge myself to conquer
-    //all the foes who stand
-    //before the might gift betsowed
-    //in my unworthy hand
-    if (strcmp(Memory.ROMName, "\x0bd\x0da\x0b2\x0d4\x0b0\x0bd\x0de") == 0 &&
-        Settings.CyclesPercentage == 100)
-        Settings.H_Max = (SNES_CYCLES_PER_SCANLINE * 101) / 100;
+    Settings.WinterGold |= Settings.StarfoxHack;
 
+    if (strcmp(Memory.ROMName, "LEGEND") == 0 && !Settings.PAL)
+        SNESGameFixes.EchoOnlyOutput = true;
 
-#ifdef DETECT_NASTY_FX_INTERLEAVE
-    //XXX: Test without these. Win32 port indicates they aren't needed?
-    //Apparently are needed!
-    if (strcmp(Memory.ROMName, "WILD TRAX") == 0 ||
-        strcmp(Memory.ROMName, "STAR FOX 2") == 0 ||
-        strcmp(Memory.ROMName, "YOSSY'S ISLAND") == 0 ||
-        strcmp(Memory.ROMName, "YOSHI'S ISLAND") == 0)
-        CPU.TriedInterleavedMode2 = true;
+#ifndef USE_BLARGG_APU
+    if ((strncmp(Memory.ROMName, "Parlor", 6) == 0 ||
+            strcmp(Memory.ROMName, "HEIWA Parlor!Mini8") == 0 ||
+            strncmp(Memory.ROMName, "SANKYO Fever! \xcc\xa8\xb0\xca\xde\xb0!", 21) == 0) &&
+        strcmp(Memory.CompanyId, "A0") == 0)
+        IAPU.OneCycle = 15;
 #endif
 
-    // Start Trek: Deep Sleep 9
-    if (strncmp(Memory.ROMId, "A9D", 3) == 0 && Settings.CyclesPercentage == 100)
-        Settings.H_Max = (SNES_CYCLES_PER_SCANLINE * 110) / 100;
-
-
     //SA-1 Speedup settings
     SA1.WaitAddress = NULL;
     SA1.WaitByteAddress1 = NULL;
     SA1.WaitByteAddress2 = NULL;
 
-    /* Bass Fishing */
-    if (strcmp(Memory.ROMId, "ZBPJ") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x0093f1 >> MEMMAP_SHIFT] + 0x93f1;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x304a;
-    }
-    /* DAISENRYAKU EXPERTWW2 */
-    if (strcmp(Memory.ROMId, "AEVJ") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x0ed18d >> MEMMAP_SHIFT] + 0xd18d;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x3000;
-    }
-    /* debjk2 */
-    if (strcmp(Memory.ROMId, "A2DJ") == 0)
-        SA1.WaitAddress = SA1.Map[0x008b62 >> MEMMAP_SHIFT] + 0x8b62;
-    /* Dragon Ballz HD */
-    if (strcmp(Memory.ROMId, "AZIJ") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x008083 >> MEMMAP_SHIFT] + 0x8083;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x3020;
-    }
-    /* SFC SDGUNDAMGNEXT */
-    if (strcmp(Memory.ROMId, "ZX3J") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x0087f2 >> MEMMAP_SHIFT] + 0x87f2;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x30c4;
-    }
-    /* ShougiNoHanamichi */
-    if (strcmp(Memory.ROMId, "AARJ") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0xc1f85a >> MEMMAP_SHIFT] + 0xf85a;
-        SA1.WaitByteAddress1 = Memory.SRAM + 0x0c64;
-        SA1.WaitByteAddress2 = Memory.SRAM + 0x0c66;
-    }
-    /* KATO HIFUMI9DAN SYOGI */
-    if (strcmp(Memory.ROMId, "A23J") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0xc25037 >> MEMMAP_SHIFT] + 0x5037;
-        SA1.WaitByteAddress1 = Memory.SRAM + 0x0c06;
-        SA1.WaitByteAddress2 = Memory.SRAM + 0x0c08;
-    }
-    /* idaten */
-    if (strcmp(Memory.ROMId, "AIIJ") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0xc100be >> MEMMAP_SHIFT] + 0x00be;
-        SA1.WaitByteAddress1 = Memory.SRAM + 0x1002;
-        SA1.WaitByteAddress2 = Memory.SRAM + 0x1004;
-    }
-    /* igotais */
-    if (strcmp(Memory.ROMId, "AITJ") == 0)
-        SA1.WaitAddress = SA1.Map[0x0080b7 >> MEMMAP_SHIFT] + 0x80b7;
-    /* J96 DREAM STADIUM */
-    if (strcmp(Memory.ROMId, "AJ6J") == 0)
-        SA1.WaitAddress = SA1.Map[0xc0f74a >> MEMMAP_SHIFT] + 0xf74a;
-    /* JumpinDerby */
-    if (strcmp(Memory.ROMId, "AJUJ") == 0)
-        SA1.WaitAddress = SA1.Map[0x00d926 >> MEMMAP_SHIFT] + 0xd926;
-    /* JKAKINOKI SHOUGI */
-    if (strcmp(Memory.ROMId, "AKAJ") == 0)
-        SA1.WaitAddress = SA1.Map[0x00f070 >> MEMMAP_SHIFT] + 0xf070;
-    /* HOSHI NO KIRBY 3 & KIRBY'S DREAM LAND 3 JAP & US */
-    if (strcmp(Memory.ROMId, "AFJJ") == 0 || strcmp(Memory.ROMId, "AFJE") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x0082d4 >> MEMMAP_SHIFT] + 0x82d4;
-        SA1.WaitByteAddress1 = Memory.SRAM + 0x72a4;
-    }
-    /* KIRBY SUPER DELUXE JAP */
-    if (strcmp(Memory.ROMId, "AKFJ") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x008c93 >> MEMMAP_SHIFT] + 0x8c93;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x300a;
-        SA1.WaitByteAddress2 = Memory.FillRAM + 0x300e;
-    }
-    /* KIRBY SUPER DELUXE US */
-    if (strcmp(Memory.ROMId, "AKFE") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x008cb8 >> MEMMAP_SHIFT] + 0x8cb8;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x300a;
-        SA1.WaitByteAddress2 = Memory.FillRAM + 0x300e;
-    }
-    /* SUPER MARIO RPG JAP & US */
-    if (strcmp(Memory.ROMId, "ARWJ") == 0 || strcmp(Memory.ROMId, "ARWE") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0xc0816f >> MEMMAP_SHIFT] + 0x816f;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x3000;
-    }
-    /* marvelous.zip */
-    if (strcmp(Memory.ROMId, "AVRJ") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x0085f2 >> MEMMAP_SHIFT] + 0x85f2;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x3024;
-    }
-    /* AUGUSTA3 MASTERS NEW */
-    if (strcmp(Memory.ROMId, "AO3J") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x00dddb >> MEMMAP_SHIFT] + 0xdddb;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x37b4;
-    }
-    /* OSHABERI PARODIUS */
-    if (strcmp(Memory.ROMId, "AJOJ") == 0)
-        SA1.WaitAddress = SA1.Map[0x8084e5 >> MEMMAP_SHIFT] + 0x84e5;
-    /* PANIC BOMBER WORLD */
-    if (strcmp(Memory.ROMId, "APBJ") == 0)
-        SA1.WaitAddress = SA1.Map[0x00857a >> MEMMAP_SHIFT] + 0x857a;
-    /* PEBBLE BEACH NEW */
-    if (strcmp(Memory.ROMId, "AONJ") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x00df33 >> MEMMAP_SHIFT] + 0xdf33;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x37b4;
-    }
-    /* PGA EUROPEAN TOUR */
-    if (strcmp(Memory.ROMId, "AEPE") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x003700 >> MEMMAP_SHIFT] + 0x3700;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x3102;
-    }
-    /* PGA TOUR 96 */
-    if (strcmp(Memory.ROMId, "A3GE") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x003700 >> MEMMAP_SHIFT] + 0x3700;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x3102;
-    }
-    /* POWER RANGERS 4 */
-    if (strcmp(Memory.ROMId, "A4RE") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x009899 >> MEMMAP_SHIFT] + 0x9899;
-        SA1.WaitByteAddress1 = Memory.FillRAM + 0x3000;
-    }
-    /* PACHISURO PALUSUPE */
-    if (strcmp(Memory.ROMId, "AGFJ") == 0)
-    {
-        // Never seems to turn on the SA-1!
-    }
-    /* SD F1 GRAND PRIX */
-    if (strcmp(Memory.ROMId, "AGFJ") == 0)
-        SA1.WaitAddress = SA1.Map[0x0181bc >> MEMMAP_SHIFT] + 0x81bc;
-    /* SHOUGI MARJONG */
-    if (strcmp(Memory.ROMId, "ASYJ") == 0)
-    {
-        SA1.WaitAddress = SA1.Map[0x00f2cc >> MEMMAP_SHIFT] + 0xf2cc;
-        SA1.WaitByteAddress1 = Memory.SRAM + 0x7ffe;
-        SA1.WaitByteAddress2 = Memory.SRAM + 0x7ffc;
-    }
-    /* shogisai2 */
-    if (strcmp(Memory.ROMId, "AX2J") == 0)
-        SA1.WaitAddress = SA1.Map[0x00d675 >> MEMMAP_SHIFT] + 0xd675;
-
-    /* SHINING SCORPION */
-    if (strcmp(Memory.ROMId, "A4WJ") == 0)
-        SA1.WaitAddress = SA1.Map[0xc048be >> MEMMAP_SHIFT] + 0x48be;
-    /* SHIN SHOUGI CLUB */
-    if (strcmp(Memory.ROMId, "AHJJ") == 0)
+    wait = (const SSA1WaitFix*)bsearch(Memory.ROMId, SA1WaitFixes,
+        sizeof(SA1WaitFixes) / sizeof(SA1WaitFixes[0]), sizeof(SA1WaitFixes[0]),
+        CompareSA1WaitFix);
+    if (wait)
     {
-        SA1.WaitAddress = SA1.Map[0xc1002a >> MEMMAP_SHIFT] + 0x002a;
-        SA1.WaitByteAddress1 = Memory.SRAM + 0x0806;
-        SA1.WaitByteAddress2 = Memory.SRAM + 0x0808;
+        SA1.WaitAddress = SA1.Map[wait->Address >> MEMMAP_SHIFT] + (wait->Address & 0xffff);
+        SA1.WaitByteAddress1 = SA1WaitByte(wait->Byte1Base, wait->Byte1Offset);
+        SA1.WaitByteAddress2 = SA1WaitByte(wait->Byte2Base, wait->Byte2Offset);
     }
 
 
@@ -4040,7 +4237,7 @@ void ApplyROMFixes()
 
     // Additional game fixes by sanmaiwashi ...
     if (strcmp(Memory.ROMName,
-        "SFX ŲĶ������ɶ��� 1") ==
+        "SFX \xc5\xb2\xc4\xb6\xde\xdd\xc0\xde\xd1\xd3\xc9\xb6\xde\xc0\xd8 1") ==
         0) //Gundam Knight Story
     {
         bytes0x2000[0xb18] = 0x4c;
@@ -4058,12 +4255,6 @@ void ApplyROMFixes()
             ((1 << (Memory.SRAMSize + 3)) * 128) - 1 : 0;
     }
 
-    //sram value fixes
-    if (strcmp(Memory.ROMName, "SUPER DRIFT OUT") == 0 ||
-        strcmp(Memory.ROMName, "SATAN IS OUR FATHER!") == 0 ||
-        strcmp(Memory.ROMName, "goemon 4") == 0)
-        SNESGameFixes.SRAMInitialValue = 0x00;
-
 #if 0
     if (strcmp(Memory.ROMName, "XBAND JAPANESE MODEM") == 0)
     {
@@ -4080,150 +4271,365 @@ void ApplyROMFixes()
     }
 #endif
 
-#define RomPatch(adr,ov,nv) \
-   if (Memory.ROM [adr] == ov) \
-    Memory.ROM [adr] = nv
-
 
-    // Love Quest
-    if (strcmp(Memory.ROMName, "LOVE QUEST") == 0)
+    for (i = 0; i < sizeof(ROMPatches) / sizeof(ROMPatches[0]); i++)
     {
-        RomPatch(0x1385ec, 0xd0, 0xea);
-        RomPatch(0x1385ed, 0xb2, 0xea);
+        const SROMPatch* patch = &ROMPatches[i];
+        if (strcmp(Memory.ROMName, patch->ROMName) == 0 &&
+            patch->Address < Memory.CalculatedSize &&
+            Memory.ROM[patch->Address] == patch->OldValue)
+            Memory.ROM[patch->Address] = patch->NewValue;
     }
-    //BNE D0 into nops
+}
 
-    //seems like the next instruction is a BRA
-    //otherwise, this one's too complex for MKendora
-    // Nangoku Syonen Papuwa Kun
-    if (strcmp(Memory.ROMName, "NANGOKUSYONEN PAPUWA") == 0)
-        RomPatch(0x1f0d1, 0xa0, 0x6b);
-    //turns an LDY into an RTL?
+// Reads a whole patch file into memory, so the appliers below can walk it
+// with a pointer instead of a stdio call per field.
+static uint8_t* LoadPatchFile(const char* rom_filename, const char* ext,
+    uint32_t* size)
+{
+    char  dir[_MAX_DIR + 1];
+    char  drive[_MAX_DRIVE + 1];
+    char  name[_MAX_FNAME + 1];
+    char  rom_ext[_MAX_EXT + 1];
+    char  fname[_MAX_PATH + 1];
+    FILE*  patch_file;
+    uint8_t* data;
+    long  length;
 
-    //this is a cmp on $00:2140
-    // Super Batter Up
-    if (strcmp(Memory.ROMName, "Super Batter Up") == 0)
+    _splitpath(rom_filename, drive, dir, name, rom_ext);
+    _makepath(fname, drive, dir, name, ext);
+
+    if (!(patch_file = fopen(fname, "rb")))
     {
-        RomPatch(0x27ae0, 0xd0, 0xea);
-        RomPatch(0x27ae1, 0xfa, 0xea);
+        if (!(patch_file = fopen(S9xGetFilename(ext), "rb")))
+            return NULL;
     }
-    //BNE
+
+    data = NULL;
+    if (fseek(patch_file, 0, SEEK_END) == 0 && (length = ftell(patch_file)) > 0 &&
+        fseek(patch_file, 0, SEEK_SET) == 0 && (data = (uint8_t*)malloc(length)))
+    {
+        if (fread(data, 1, length, patch_file) == (size_t)length)
+            *size = length;
+        else
+        {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(patch_file);
+    return data;
 }
 
-// Read variable size MSB int from a file
-static long ReadInt(FILE* f, unsigned nbytes)
+// Read variable size MSB int from a patch
+static int32_t ReadInt(const uint8_t** p, const uint8_t* end, unsigned nbytes)
 {
-    long v = 0;
+    int32_t v = 0;
+    if ((uint32_t)(end - *p) < nbytes)
+        return -1;
     while (nbytes--)
-    {
-        int c = fgetc(f);
-        if (c == EOF)
-            return -1;
-        v = (v << 8) | (c & 0xFF);
-    }
+        v = (v << 8) | *(*p)++;
     return (v);
 }
 
 #define IPS_EOF 0x00454F46l
 
-void CheckForIPSPatch(const char* rom_filename, bool header,
+static bool ApplyIPSPatch(const uint8_t* data, uint32_t size, bool header,
     int32_t* rom_size)
 {
-    char  dir[_MAX_DIR + 1];
-    char  drive[_MAX_DRIVE + 1];
-    char  name[_MAX_FNAME + 1];
-    char  ext[_MAX_EXT + 1];
-    char  fname[_MAX_PATH + 1];
-    FILE*  patch_file = NULL;
-    long  offset = header ? 512 : 0;
-
-    _splitpath(rom_filename, drive, dir, name, ext);
-    _makepath(fname, drive, dir, name, "ips");
-
-    if (!(patch_file = fopen(fname, "rb")))
-    {
-        if (!(patch_file = fopen(S9xGetFilename("ips"), "rb")))
-            return;
-    }
+    const uint8_t* p = data + 5;
+    const uint8_t* end = data + size;
+    int32_t offset = header ? 512 : 0;
+    int32_t new_size = *rom_size;
+    int32_t ofs;
+    uint8_t* backup;
 
-    if (fread((unsigned char*)fname, 1, 5, patch_file) != 5 ||
-        strncmp(fname, "PATCH", 5) != 0)
+    if (size < 5 || strncmp((const char*)data, "PATCH", 5) != 0)
     {
-        fclose(patch_file);
-        return;
+        S9xMessage(S9X_ERROR, S9X_ROM_CONFUSING_FORMAT_INFO,
+            "IPS patch is damaged, not applied.");
+        return false;
     }
 
-    int32_t ofs;
+    // Only the image as loaded needs keeping; anything written past its end
+    // is ignored unless the whole patch applies.
+    if (!(backup = (uint8_t*)malloc(*rom_size ? *rom_size : 1)))
+        return false;
+    memcpy(backup, Memory.ROM, *rom_size);
 
     for (;;)
     {
-        long len;
-        long rlen;
-        int  rchar;
+        int32_t len, skip;
+        int fill = -1;
 
-        ofs = ReadInt(patch_file, 3);
+        ofs = ReadInt(&p, end, 3);
         if (ofs == -1)
-            goto err_eof;
+            goto fail;
 
         if (ofs == IPS_EOF)
             break;
 
         ofs -= offset;
 
-        len = ReadInt(patch_file, 2);
+        len = ReadInt(&p, end, 2);
         if (len == -1)
-            goto err_eof;
+            goto fail;
 
-        /* Apply patch block */
-        if (len)
+        if (len == 0)
         {
-            if (ofs + len > MAX_ROM_SIZE)
-                goto err_eof;
-
-            while (len--)
-            {
-                rchar = fgetc(patch_file);
-                if (rchar == EOF)
-                    goto err_eof;
-                Memory.ROM[ofs++] = (uint8_t)rchar;
-            }
-            if (ofs > *rom_size)
-                *rom_size = ofs;
+            // Run-length block
+            len = ReadInt(&p, end, 2);
+            if (len == -1 || p == end)
+                goto fail;
+            fill = *p++;
         }
-        else
-        {
-            rlen = ReadInt(patch_file, 2);
-            if (rlen == -1)
-                goto err_eof;
-
-            rchar = fgetc(patch_file);
-            if (rchar == EOF)
-                goto err_eof;
+        else if (end - p < len)
+            goto fail;
 
-            if (ofs + rlen > MAX_ROM_SIZE)
-                goto err_eof;
+        // Bytes meant for the copier header we stripped are dropped.
+        skip = ofs < 0 ? (-ofs < len ? -ofs : len) : 0;
+        if (fill < 0)
+            p += skip;
+        ofs += skip;
+        len -= skip;
 
-            while (rlen--)
-                Memory.ROM[ofs++] = (uint8_t)rchar;
+        if (len == 0)
+            continue;
+        if (ofs + len > MAX_ROM_SIZE)
+            goto fail;
 
-            if (ofs > *rom_size)
-                *rom_size = ofs;
+        if (fill < 0)
+        {
+            memcpy(Memory.ROM + ofs, p, len);
+            p += len;
         }
+        else
+            memset(Memory.ROM + ofs, fill, len);
+        ofs += len;
+
+        if (ofs > new_size)
+            new_size = ofs;
     }
 
+    free(backup);
+    *rom_size = new_size;
+
     // Check if ROM image needs to be truncated
-    ofs = ReadInt(patch_file, 3);
+    ofs = ReadInt(&p, end, 3);
     if (ofs != -1 && ofs - offset < *rom_size)
     {
         // Need to truncate ROM image
         *rom_size = ofs - offset;
     }
-    fclose(patch_file);
-    return;
+    return true;
+
+fail:
+    memcpy(Memory.ROM, backup, *rom_size);
+    free(backup);
+    S9xMessage(S9X_ERROR, S9X_ROM_CONFUSING_FORMAT_INFO,
+        "IPS patch is damaged, not applied.");
+    return false;
+}
+
+// UPS and BPS share this variable length number encoding.
+static bool ReadPatchNumber(const uint8_t** p, const uint8_t* end, uint32_t* value)
+{
+    uint32_t data = 0, shift = 1;
+    for (;;)
+    {
+        uint8_t x;
+        if (*p == end)
+            return false;
+        x = *(*p)++;
+        data += (x & 0x7f) * shift;
+        if (x & 0x80)
+            break;
+        shift <<= 7;
+        data += shift;
+    }
+    *value = data;
+    return true;
+}
+
+static uint32_t ReadPatchCRC(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Both UPS and BPS end with the source, target and patch CRC32s, and are made
+// against the ROM without its copier header. Returns the target size, or -1
+// if this patch is not for the loaded image.
+static int32_t CheckPatchChecksums(const uint8_t* data, uint32_t size,
+    uint32_t source_size, uint32_t target_size, int32_t rom_size)
+{
+    const uint8_t* footer = data + size - 12;
+
+    if (caCRC32((uint8_t*)data, size - 4, 0xFFFFFFFF) != ReadPatchCRC(footer + 8))
+    {
+        S9xMessage(S9X_ERROR, S9X_ROM_CONFUSING_FORMAT_INFO, "Patch file is corrupt.");
+        return -1;
+    }
+    if (source_size != (uint32_t)rom_size || target_size > MAX_ROM_SIZE ||
+        caCRC32(Memory.ROM, rom_size, 0xFFFFFFFF) != ReadPatchCRC(footer))
+    {
+        S9xMessage(S9X_ERROR, S9X_ROM_CONFUSING_FORMAT_INFO,
+            "Patch was made for a different ROM, not applied.");
+        return -1;
+    }
+    return target_size;
+}
+
+static bool ApplyUPSPatch(const uint8_t* data, uint32_t size, int32_t* rom_size)
+{
+    const uint8_t* p = data + 4;
+    const uint8_t* end = data + size - 12;
+    uint32_t source_size, target_size, ofs = 0;
+    uint8_t* backup;
+
+    if (size < 18 || strncmp((const char*)data, "UPS1", 4) != 0 ||
+        !ReadPatchNumber(&p, end, &source_size) ||
+        !ReadPatchNumber(&p, end, &target_size) ||
+        CheckPatchChecksums(data, size, source_size, target_size, *rom_size) < 0)
+        return false;
+
+    if (!(backup = (uint8_t*)malloc(source_size)))
+        return false;
+    memcpy(backup, Memory.ROM, source_size);
+
+    // The patch XORs the target over the source, which reads as zeros past
+    // its end.
+    if (target_size > source_size)
+        memset(Memory.ROM + source_size, 0, target_size - source_size);
+
+    while (p < end)
+    {
+        uint32_t skip;
+        if (!ReadPatchNumber(&p, end, &skip))
+            break;
+        ofs += skip;
+        while (p < end && *p && ofs < target_size)
+            Memory.ROM[ofs++] ^= *p++;
+        if (p == end || *p)
+            break;
+        p++;
+        ofs++;
+    }
+
+    if (p != end || caCRC32(Memory.ROM, target_size, 0xFFFFFFFF) != ReadPatchCRC(end + 4))
+    {
+        memcpy(Memory.ROM, backup, source_size);
+        free(backup);
+        return false;
+    }
+    free(backup);
+    *rom_size = target_size;
+    return true;
+}
+
+static bool ApplyBPSPatch(const uint8_t* data, uint32_t size, int32_t* rom_size)
+{
+    const uint8_t* p = data + 4;
+    const uint8_t* end = data + size - 12;
+    uint32_t source_size, target_size, metadata_size;
+    uint32_t out = 0, source_rel = 0, target_rel = 0;
+    uint8_t* source;
+
+    if (size < 19 || strncmp((const char*)data, "BPS1", 4) != 0 ||
+        !ReadPatchNumber(&p, end, &source_size) ||
+        !ReadPatchNumber(&p, end, &target_size) ||
+        !ReadPatchNumber(&p, end, &metadata_size) ||
+        metadata_size > (uint32_t)(end - p) ||
+        CheckPatchChecksums(data, size, source_size, target_size, *rom_size) < 0)
+        return false;
+    p += metadata_size;
+
+    // SourceCopy may read anywhere in the original, so keep a copy of it and
+    // build the target straight into Memory.ROM.
+    if (!(source = (uint8_t*)malloc(source_size)))
+        return false;
+    memcpy(source, Memory.ROM, source_size);
+
+    while (p < end)
+    {
+        uint32_t action, length, disp;
+
+        if (!ReadPatchNumber(&p, end, &action))
+            break;
+        length = (action >> 2) + 1;
+        if (length > target_size - out)
+            break;
+
+        switch (action & 3)
+        {
+        case 0: // SourceRead
+            if (out + length > source_size)
+                goto fail;
+            memcpy(Memory.ROM + out, source + out, length);
+            break;
+        case 1: // TargetRead
+            if (length > (uint32_t)(end - p))
+                goto fail;
+            memcpy(Memory.ROM + out, p, length);
+            p += length;
+            break;
+        case 2: // SourceCopy
+            if (!ReadPatchNumber(&p, end, &disp))
+                goto fail;
+            source_rel += (disp & 1) ? -(int32_t)(disp >> 1) : (int32_t)(disp >> 1);
+            if (source_rel > source_size || length > source_size - source_rel)
+                goto fail;
+            memcpy(Memory.ROM + out, source + source_rel, length);
+            source_rel += length;
+            break;
+        case 3: // TargetCopy, which may overlap what it is writing
+            if (!ReadPatchNumber(&p, end, &disp))
+                goto fail;
+            target_rel += (disp & 1) ? -(int32_t)(disp >> 1) : (int32_t)(disp >> 1);
+            if (target_rel >= out)
+                goto fail;
+            while (length--)
+                Memory.ROM[out++] = Memory.ROM[target_rel++];
+            continue;
+        }
+        out += length;
+    }
+
+    if (p == end && out == target_size &&
+        caCRC32(Memory.ROM, target_size, 0xFFFFFFFF) == ReadPatchCRC(end + 4))
+    {
+        free(source);
+        *rom_size = target_size;
+        return true;
+    }
+
+fail:
+    memcpy(Memory.ROM, source, source_size);
+    free(source);
+    return false;
+}
+
+// Looks for a BPS, UPS or IPS patch next to the ROM, in that order, and
+// applies the first one found to the freshly loaded image, before it is
+// scored and mapped.
+void CheckForIPSPatch(const char* rom_filename, bool header,
+    int32_t* rom_size)
+{
+    uint8_t* data;
+    uint32_t size;
+    bool applied;
+
+    if ((data = LoadPatchFile(rom_filename, "bps", &size)))
+        applied = ApplyBPSPatch(data, size, rom_size);
+    else if ((data = LoadPatchFile(rom_filename, "ups", &size)))
+        applied = ApplyUPSPatch(data, size, rom_size);
+    else if ((data = LoadPatchFile(rom_filename, "ips", &size)))
+        applied = ApplyIPSPatch(data, size, header, rom_size);
+    else
+        return;
 
-err_eof:
-    if (patch_file)
-        fclose(patch_file);
+    free(data);
+    if (applied)
+        S9xMessage(S9X_INFO, S9X_ROM_INFO, "Applied patch.");
 }
 
 int is_bsx(unsigned char* p)
@@ -165,6 +165,7 @@ void SRAM512KLoROMMap();
 void SufamiTurboLoROMMap();
 void HiROMMap();
 void SuperFXROMMap();
+void SuperFXLockRAM(bool);
 void TalesROMMap(bool);
 void AlphaROMMap();
 void SA1ROMMap();
@@ -198,7 +199,8 @@ enum
    MAP_PPU, MAP_CPU, MAP_DSP, MAP_LOROM_SRAM, MAP_HIROM_SRAM,
    MAP_NONE, MAP_DEBUG, MAP_C4, MAP_BWRAM, MAP_BWRAM_BITMAP,
    MAP_BWRAM_BITMAP2, MAP_SA1RAM, MAP_SPC7110_ROM, MAP_SPC7110_DRAM,
-   MAP_RONLY_SRAM, MAP_OBC_RAM, MAP_SETA_DSP, MAP_SETA_RISC, MAP_LAST
+   MAP_RONLY_SRAM, MAP_OBC_RAM, MAP_SETA_DSP, MAP_SETA_RISC, MAP_SUPERFX_RAM,
+   MAP_SA1_SHARED, MAP_LAST
 };
 enum { MAX_ROM_SIZE = 0x800000 };
 
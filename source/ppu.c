@@ -104,6 +104,7 @@
 #include "fxemu.h"
 #include "fxinst.h"
 extern struct FxInit_s SuperFX;
+extern struct FxRegs_s GSU;
 
 uint32_t justifiers = 0xFFFF00AA;
 uint8_t in_bit = 0;
@@ -206,15 +207,19 @@ static void S9xSetSuperFX(uint8_t Byte, uint16_t Address)
    if (!Settings.SuperFX)
       return;
 
+   S9xSuperFXSync();
+   fx_syncRegisterToCPU(Address);
    old_fill_ram = Memory.FillRAM[Address];
+   if (Address == 0x3034 || Address == 0x3036)
+      Byte &= 0x7f;
    Memory.FillRAM[Address] = Byte; 
+   fx_syncRegisterFromCPU(Address);
 
    switch (Address)
    {
       case 0x3030:
          if ((old_fill_ram ^ Byte) & FLG_G)
          {
-            Memory.FillRAM [Address] = Byte;
             // Go flag has been changed
             if (Byte & FLG_G)
                S9xSuperFXExec();
@@ -225,25 +230,19 @@ static void S9xSetSuperFX(uint8_t Byte, uint16_t Address)
 
       case 0x3031:
       case 0x3033:
-      case 0x3037:
-      case 0x3039:
-      case 0x303a:
-      case 0x303f:
-         break;
       case 0x3034:
       case 0x3036:
-         Memory.FillRAM [Address] &= 0x7f;
-         break;
+      case 0x3037:
       case 0x3038:
-         fx_dirtySCBR();
-         break;
+      case 0x3039:
+      case 0x303a:
       case 0x303b:
-         break;
       case 0x303c:
-         fx_updateRamBank(Byte);
+      case 0x303f:
+         // Already folded into the GSU state by fx_syncRegisterFromCPU
          break;
       case 0x301f:
-         Memory.FillRAM [0x3000 + GSU_SFR] |= FLG_G;
+         SF(G);
          S9xSuperFXExec();
          break;
 
@@ -263,6 +262,13 @@ void S9xSetPPU(uint8_t Byte, uint16_t Address)
    //    fprintf(stderr, "%03d: %02x to %04x\n", CPU.V_Counter, Byte, Address);
    if (Address <= 0x2183)
    {
+      // Scroll and Mode 7 matrix values are compared per line by RenderLine,
+      // and the VRAM, CG-RAM and OAM data ports flag their own changes.
+      if (Address <= 0x2133 && Byte != Memory.FillRAM [Address] &&
+            (Address <= 0x2101 || (Address >= 0x2105 && Address <= 0x210c) ||
+             Address == 0x211a || Address >= 0x2123))
+         IPPU.ScreenChanged = true;
+
       switch (Address)
       {
       case 0x2100:
@@ -925,7 +931,10 @@ void S9xSetPPU(uint8_t Byte, uint16_t Address)
       if (Settings.SA1)
       {
          if (Address >= 0x2200 && Address < 0x23ff)
+         {
+            S9xSA1Sync();
             S9xSetSA1(Byte, Address);
+         }
          else
             Memory.FillRAM [Address] = Byte;
 
@@ -1345,7 +1354,10 @@ uint8_t S9xGetPPU(uint16_t Address)
    else
    {
       if (Settings.SA1)
+      {
+         S9xSA1Sync();
          return (S9xGetSA1(Address));
+      }
 
       if (Address <= 0x2fff || Address >= 0x3300)
       {
@@ -1376,6 +1388,8 @@ uint8_t S9xGetPPU(uint16_t Address)
       if (!Settings.SuperFX)
          return OpenBus;
 
+      S9xSuperFXSync();
+      fx_syncRegisterToCPU(Address);
       byte = Memory.FillRAM [Address];
 
       //if (Address != 0x3030 && Address != 0x3031)
@@ -1389,6 +1403,7 @@ uint8_t S9xGetPPU(uint16_t Address)
          {
             CLEAR_IRQ_SOURCE(GSU_IRQ_SOURCE);
             Memory.FillRAM [0x3031] = byte & 0x7f;
+            fx_syncRegisterFromCPU(0x3031);
          }
       return (byte);
    }
@@ -2335,6 +2350,10 @@ static void CommonPPUReset()
    IPPU.OBJChanged = true;
    IPPU.RenderThisFrame = true;
    IPPU.DirectColourMapsNeedRebuild = true;
+   IPPU.Mode7CacheNeedsRebuild = true;
+   IPPU.ScreenChanged = true;
+   IPPU.PreviousFrameChanged = true;
+   IPPU.ScreenReused = false;
    IPPU.FrameCount = 0;
    IPPU.RenderedFramesCount = 0;
    IPPU.DisplayedRenderedFrameCount = 0;
@@ -2369,6 +2388,7 @@ static void CommonPPUReset()
 
    for (c = 0; c < 2; c++)
       memset(&IPPU.Clip [c], 0, sizeof(struct ClipData));
+   S9xResetClipCache();
 
    if (Settings.MouseMaster)
    {
@@ -2781,28 +2801,63 @@ void S9xUpdateJoypads()
 }
 
 
+static bool SuperFXSyncAtHBlank = false;
+
+static void S9xSuperFXCheckIRQ()
+{
+   if ((GSU.vStatusReg & (FLG_G | FLG_IRQ)) == FLG_IRQ)
+   {
+      // Trigger a GSU IRQ.
+      S9xSetIRQ(GSU_IRQ_SOURCE);
+   }
+}
+
 void S9xSuperFXExec()
 {
    if (Settings.SuperFX)
    {
-      if ((Memory.FillRAM [0x3000 + GSU_SFR] & FLG_G) &&
+      if (FxThreadRunning())
+      {
+         // A session is still running on the GSU thread. Unless its STOP
+         // can raise an IRQ, nothing on the CPU side can tell it is still
+         // going until the game touches $3000-$32ff or the GSU RAM.
+         if (SuperFXSyncAtHBlank)
+            S9xSuperFXSync();
+         return;
+      }
+
+      if (TF(G) &&
             (Memory.FillRAM [0x3000 + GSU_SCMR] & 0x18) == 0x18)
       {
          if (!Settings.WinterGold || Settings.StarfoxHack)
+         {
+            if (Settings.ThreadSuperFX && FxEmulateAsync(~0))
+            {
+               SuperFXSyncAtHBlank = !(Memory.FillRAM [0x3000 + GSU_CFGR] & 0x80);
+               SuperFXLockRAM(true);
+               return;
+            }
             FxEmulate(~0);
+         }
          else
             FxEmulate((Memory.FillRAM [0x3000 + GSU_CLSR] & 1) ? 700 : 350);
-         int GSUStatus = Memory.FillRAM [0x3000 + GSU_SFR] |
-                         (Memory.FillRAM [0x3000 + GSU_SFR + 1] << 8);
-         if ((GSUStatus & (FLG_G | FLG_IRQ)) == FLG_IRQ)
-         {
-            // Trigger a GSU IRQ.
-            S9xSetIRQ(GSU_IRQ_SOURCE);
-         }
+         S9xSuperFXCheckIRQ();
       }
    }
 }
 
+// Waits for a threaded GSU session to finish and hands its RAM back to the
+// CPU. Called before the CPU side looks at any GSU-owned state.
+void S9xSuperFXSync()
+{
+   if (!FxThreadRunning())
+      return;
+
+   FxThreadWait();
+   SuperFXLockRAM(false);
+   S9xSuperFXCheckIRQ();
+}
+
 // Register reads and writes...
 
 uint8_t REGISTER_4212()
@@ -2929,13 +2984,19 @@ void REGISTER_2118(uint8_t Byte)
       address = (((PPU.VMA.Address & ~PPU.VMA.Mask1) +
                   (rem >> PPU.VMA.Shift) +
                   ((rem & (PPU.VMA.FullGraphicCount - 1)) << 3)) << 1) & 0xffff;
-      Memory.VRAM [address] = Byte;
    }
    else
-      Memory.VRAM[address = (PPU.VMA.Address << 1) & 0xFFFF] = Byte;
-   IPPU.TileCached [TILE_2BIT][address >> 4] = false;
-   IPPU.TileCached [TILE_4BIT][address >> 5] = false;
-   IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+      address = (PPU.VMA.Address << 1) & 0xFFFF;
+   if (Memory.VRAM [address] != Byte)
+   {
+      Memory.VRAM [address] = Byte;
+      IPPU.TileCached [TILE_2BIT][address >> 4] = false;
+      IPPU.TileCached [TILE_4BIT][address >> 5] = false;
+      IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+      if (address < 0x8000)
+         IPPU.Mode7Map [address >> 1] = Byte;
+      IPPU.ScreenChanged = true;
+   }
    if (!PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
    //    Memory.FillRAM [0x2118] = Byte;
@@ -2948,10 +3009,16 @@ void REGISTER_2118_tile(uint8_t Byte)
    address = (((PPU.VMA.Address & ~PPU.VMA.Mask1) +
                (rem >> PPU.VMA.Shift) +
                ((rem & (PPU.VMA.FullGraphicCount - 1)) << 3)) << 1) & 0xffff;
-   Memory.VRAM [address] = Byte;
-   IPPU.TileCached [TILE_2BIT][address >> 4] = false;
-   IPPU.TileCached [TILE_4BIT][address >> 5] = false;
-   IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+   if (Memory.VRAM [address] != Byte)
+   {
+      Memory.VRAM [address] = Byte;
+      IPPU.TileCached [TILE_2BIT][address >> 4] = false;
+      IPPU.TileCached [TILE_4BIT][address >> 5] = false;
+      IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+      if (address < 0x8000)
+         IPPU.Mode7Map [address >> 1] = Byte;
+      IPPU.ScreenChanged = true;
+   }
    if (!PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
    //    Memory.FillRAM [0x2118] = Byte;
@@ -2959,11 +3026,17 @@ void REGISTER_2118_tile(uint8_t Byte)
 
 void REGISTER_2118_linear(uint8_t Byte)
 {
-   uint32_t address;
-   Memory.VRAM[address = (PPU.VMA.Address << 1) & 0xFFFF] = Byte;
-   IPPU.TileCached [TILE_2BIT][address >> 4] = false;
-   IPPU.TileCached [TILE_4BIT][address >> 5] = false;
-   IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+   uint32_t address = (PPU.VMA.Address << 1) & 0xFFFF;
+   if (Memory.VRAM [address] != Byte)
+   {
+      Memory.VRAM [address] = Byte;
+      IPPU.TileCached [TILE_2BIT][address >> 4] = false;
+      IPPU.TileCached [TILE_4BIT][address >> 5] = false;
+      IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+      if (address < 0x8000)
+         IPPU.Mode7Map [address >> 1] = Byte;
+      IPPU.ScreenChanged = true;
+   }
    if (!PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
    //    Memory.FillRAM [0x2118] = Byte;
@@ -2978,13 +3051,19 @@ void REGISTER_2119(uint8_t Byte)
       address = ((((PPU.VMA.Address & ~PPU.VMA.Mask1) +
                    (rem >> PPU.VMA.Shift) +
                    ((rem & (PPU.VMA.FullGraphicCount - 1)) << 3)) << 1) + 1) & 0xFFFF;
-      Memory.VRAM [address] = Byte;
    }
    else
-      Memory.VRAM[address = ((PPU.VMA.Address << 1) + 1) & 0xFFFF] = Byte;
-   IPPU.TileCached [TILE_2BIT][address >> 4] = false;
-   IPPU.TileCached [TILE_4BIT][address >> 5] = false;
-   IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+      address = ((PPU.VMA.Address << 1) + 1) & 0xFFFF;
+   if (Memory.VRAM [address] != Byte)
+   {
+      Memory.VRAM [address] = Byte;
+      IPPU.TileCached [TILE_2BIT][address >> 4] = false;
+      IPPU.TileCached [TILE_4BIT][address >> 5] = false;
+      IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+      if (address < 0x8000)
+         IPPU.Mode7Chars [address >> 1] = Byte;
+      IPPU.ScreenChanged = true;
+   }
    if (PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
    //    Memory.FillRAM [0x2119] = Byte;
@@ -2996,10 +3075,16 @@ void REGISTER_2119_tile(uint8_t Byte)
    uint32_t address = ((((PPU.VMA.Address & ~PPU.VMA.Mask1) +
                        (rem >> PPU.VMA.Shift) +
                        ((rem & (PPU.VMA.FullGraphicCount - 1)) << 3)) << 1) + 1) & 0xFFFF;
-   Memory.VRAM [address] = Byte;
-   IPPU.TileCached [TILE_2BIT][address >> 4] = false;
-   IPPU.TileCached [TILE_4BIT][address >> 5] = false;
-   IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+   if (Memory.VRAM [address] != Byte)
+   {
+      Memory.VRAM [address] = Byte;
+      IPPU.TileCached [TILE_2BIT][address >> 4] = false;
+      IPPU.TileCached [TILE_4BIT][address >> 5] = false;
+      IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+      if (address < 0x8000)
+         IPPU.Mode7Chars [address >> 1] = Byte;
+      IPPU.ScreenChanged = true;
+   }
    if (PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
    //    Memory.FillRAM [0x2119] = Byte;
@@ -3007,11 +3092,17 @@ void REGISTER_2119_tile(uint8_t Byte)
 
 void REGISTER_2119_linear(uint8_t Byte)
 {
-   uint32_t address;
-   Memory.VRAM[address = ((PPU.VMA.Address << 1) + 1) & 0xFFFF] = Byte;
-   IPPU.TileCached [TILE_2BIT][address >> 4] = false;
-   IPPU.TileCached [TILE_4BIT][address >> 5] = false;
-   IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+   uint32_t address = ((PPU.VMA.Address << 1) + 1) & 0xFFFF;
+   if (Memory.VRAM [address] != Byte)
+   {
+      Memory.VRAM [address] = Byte;
+      IPPU.TileCached [TILE_2BIT][address >> 4] = false;
+      IPPU.TileCached [TILE_4BIT][address >> 5] = false;
+      IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+      if (address < 0x8000)
+         IPPU.Mode7Chars [address >> 1] = Byte;
+      IPPU.ScreenChanged = true;
+   }
    if (PPU.VMA.High)
       PPU.VMA.Address += PPU.VMA.Increment;
    //    Memory.FillRAM [0x2119] = Byte;
@@ -3029,6 +3120,7 @@ void REGISTER_2122(uint8_t Byte)
          PPU.CGDATA[PPU.CGADD] &= 0x00FF;
          PPU.CGDATA[PPU.CGADD] |= (Byte & 0x7f) << 8;
          IPPU.ColorsChanged = true;
+         IPPU.ScreenChanged = true;
          IPPU.Blue [PPU.CGADD] = IPPU.XB [(Byte >> 2) & 0x1f];
          IPPU.Green [PPU.CGADD] = IPPU.XB [(PPU.CGDATA[PPU.CGADD] >> 5) & 0x1f];
          IPPU.ScreenColors [PPU.CGADD] = (uint16_t) BUILD_PIXEL(IPPU.Red [PPU.CGADD],
@@ -3045,6 +3137,7 @@ void REGISTER_2122(uint8_t Byte)
          PPU.CGDATA[PPU.CGADD] &= 0x7F00;
          PPU.CGDATA[PPU.CGADD] |= Byte;
          IPPU.ColorsChanged = true;
+         IPPU.ScreenChanged = true;
          IPPU.Red [PPU.CGADD] = IPPU.XB [Byte & 0x1f];
          IPPU.Green [PPU.CGADD] = IPPU.XB [(PPU.CGDATA[PPU.CGADD] >> 5) & 0x1f];
          IPPU.ScreenColors [PPU.CGADD] = (uint16_t) BUILD_PIXEL(IPPU.Red [PPU.CGADD],
@@ -3056,6 +3149,127 @@ void REGISTER_2122(uint8_t Byte)
    //    Memory.FillRAM [0x2122] = Byte;
 }
 
+// Block forms of the register writes above, for DMA. Each one leaves the
+// PPU exactly as the equivalent run of single-byte writes would, including
+// the change checks, but compares and copies whole runs at a time.
+
+// Mode 1 DMA to $2118/9 with linear addressing and a one word increment
+// after the high byte: the bytes land contiguously in VRAM. Tile cache
+// entries are dropped once per 16-byte 2bpp tile that actually changed.
+void S9xVRAMBlockWrite(const uint8_t* src, uint32_t count)
+{
+   uint32_t address = (PPU.VMA.Address << 1) & 0xffff;
+
+   PPU.VMA.Address += count >> 1;
+   while (count > 0)
+   {
+      uint32_t run = 16 - (address & 15);
+      if (run > count)
+         run = count;
+      if (memcmp(Memory.VRAM + address, src, run) != 0)
+      {
+         memcpy(Memory.VRAM + address, src, run);
+         IPPU.TileCached [TILE_2BIT][address >> 4] = false;
+         IPPU.TileCached [TILE_4BIT][address >> 5] = false;
+         IPPU.TileCached [TILE_8BIT][address >> 6] = false;
+         if (address < 0x8000)
+         {
+            uint32_t i;
+            for (i = 0; i < run; i++)
+            {
+               if ((address + i) & 1)
+                  IPPU.Mode7Chars [(address + i) >> 1] = src[i];
+               else
+                  IPPU.Mode7Map [(address + i) >> 1] = src[i];
+            }
+         }
+         IPPU.ScreenChanged = true;
+      }
+      address = (address + run) & 0xffff;
+      src += run;
+      count -= run;
+   }
+}
+
+// Palette uploads through $2122, a colour (two bytes) at a time.
+void S9xCGRAMBlockWrite(const uint8_t* src, uint32_t count)
+{
+   if (PPU.CGFLIP && count > 0)
+   {
+      REGISTER_2122(*src++);
+      count--;
+   }
+   for (; count >= 2; count -= 2, src += 2)
+   {
+      uint16_t colour = src[0] | ((src[1] & 0x7f) << 8);
+      if (colour != PPU.CGDATA[PPU.CGADD])
+      {
+         FLUSH_REDRAW();
+         PPU.CGDATA[PPU.CGADD] = colour;
+         IPPU.ColorsChanged = true;
+         IPPU.ScreenChanged = true;
+         IPPU.Red [PPU.CGADD] = IPPU.XB [colour & 0x1f];
+         IPPU.Green [PPU.CGADD] = IPPU.XB [(colour >> 5) & 0x1f];
+         IPPU.Blue [PPU.CGADD] = IPPU.XB [(colour >> 10) & 0x1f];
+         IPPU.ScreenColors [PPU.CGADD] = (uint16_t) BUILD_PIXEL(IPPU.Red [PPU.CGADD],
+                                         IPPU.Green [PPU.CGADD],
+                                         IPPU.Blue [PPU.CGADD]);
+      }
+      PPU.CGADD++;
+   }
+   if (count)
+      REGISTER_2122(*src);
+}
+
+// OAM uploads through $2104: the low table a word at a time, then the
+// 32-byte high table (and anything unaligned) through REGISTER_2104.
+void S9xOAMBlockWrite(const uint8_t* src, uint32_t count)
+{
+   while (count >= 2 && !(PPU.OAMAddr & 0x100) && !(PPU.OAMFlip & 1))
+   {
+      int addr = PPU.OAMAddr << 1;
+      int obj = PPU.OAMAddr >> 1;
+      uint8_t lowbyte = src[0];
+      uint8_t highbyte = src[1];
+
+      if (PPU.OAMPriorityRotation && (PPU.OAMAddr & 1))
+         IPPU.OBJChanged = true;
+      PPU.OAMWriteRegister = lowbyte | (highbyte << 8);
+
+      if (lowbyte != PPU.OAMData [addr] || highbyte != PPU.OAMData [addr + 1])
+      {
+         FLUSH_REDRAW();
+         PPU.OAMData [addr] = lowbyte;
+         PPU.OAMData [addr + 1] = highbyte;
+         IPPU.OBJChanged = true;
+         if (addr & 2)
+         {
+            PPU.OBJ[obj].Name = PPU.OAMWriteRegister & 0x1ff;
+            PPU.OBJ[obj].Palette = (highbyte >> 1) & 7;
+            PPU.OBJ[obj].Priority = (highbyte >> 4) & 3;
+            PPU.OBJ[obj].HFlip = (highbyte >> 6) & 1;
+            PPU.OBJ[obj].VFlip = (highbyte >> 7) & 1;
+         }
+         else
+         {
+            PPU.OBJ[obj].HPos = (PPU.OBJ[obj].HPos & 0xFF00) | lowbyte;
+            PPU.OBJ[obj].VPos = highbyte;
+         }
+      }
+      ++PPU.OAMAddr;
+      if (PPU.OAMPriorityRotation && PPU.FirstSprite != (PPU.OAMAddr >> 1))
+      {
+         PPU.FirstSprite = (PPU.OAMAddr & 0xFE) >> 1;
+         IPPU.OBJChanged = true;
+      }
+      Memory.FillRAM [0x2104] = highbyte;
+      src += 2;
+      count -= 2;
+   }
+   while (count-- > 0)
+      REGISTER_2104(*src++);
+}
+
 void REGISTER_2180(uint8_t Byte)
 {
    Memory.RAM[PPU.WRAM++] = Byte;
@@ -126,6 +126,11 @@ typedef struct
    bool  OBJChanged;
    bool  RenderThisFrame;
    bool  DirectColourMapsNeedRebuild;
+   bool  Mode7CacheNeedsRebuild;
+   bool  ScreenChanged;          // VRAM/CGRAM/OAM/PPU registers changed since the last rendered frame began
+   bool  PreviousFrameChanged;   // ScreenChanged as it stood when the current frame began
+   bool  ScreenReused;           // No line of the last frame had to be redrawn
+   bool  LineChanged [SNES_HEIGHT_EXTENDED];
    uint32_t FrameCount;
    uint32_t RenderedFramesCount;
    uint32_t DisplayedRenderedFrameCount;
@@ -134,6 +139,8 @@ typedef struct
    uint32_t	TotalEmulatedFrames;
    uint8_t*  TileCache [3];
    uint8_t*  TileCached [3];
+   uint8_t*  Mode7Map;           // Low VRAM bytes of the first 32K: 128x128 Mode 7 tilemap
+   uint8_t*  Mode7Chars;         // High VRAM bytes of the first 32K: 256 8x8 Mode 7 characters
 #ifdef CORRECT_VRAM_READS
    uint16_t VRAMReadBuffer;
 #else
@@ -310,9 +317,11 @@ void S9xUpdateScreen();
 void S9xResetPPU();
 void S9xSoftResetPPU();
 void S9xFixColourBrightness();
+void S9xResetClipCache();
 void S9xUpdateJoypads();
 void S9xProcessMouse(int which1);
 void S9xSuperFXExec();
+void S9xSuperFXSync();
 
 void S9xSetPPU(uint8_t Byte, uint16_t Address);
 uint8_t S9xGetPPU(uint16_t Address);
@@ -358,6 +367,9 @@ extern void REGISTER_2119_tile(uint8_t Byte);
 extern void REGISTER_2119_linear(uint8_t Byte);
 extern void REGISTER_2122(uint8_t Byte);
 extern void REGISTER_2180(uint8_t Byte);
+void S9xVRAMBlockWrite(const uint8_t* src, uint32_t count);
+void S9xCGRAMBlockWrite(const uint8_t* src, uint32_t count);
+void S9xOAMBlockWrite(const uint8_t* src, uint32_t count);
 
 //Platform specific input functions used by PPU.CPP
 void JustifierButtons(uint32_t*);
@@ -118,6 +118,7 @@ void S9xSA1Init()
    SA1.sum = 0;
    SA1.overflow = false;
    SA1.S9xOpcodes = NULL;
+   SA1Cycles = CPU.Cycles;
 }
 
 void S9xSA1Reset()
@@ -193,6 +194,7 @@ void S9xFixSA1AfterSnapshotLoad()
 
    SA1.Waiting = (Memory.FillRAM [0x2200] & 0x60) != 0;
    SA1.Executing = !SA1.Waiting;
+   SA1Cycles = CPU.Cycles;
 }
 
 uint8_t S9xSA1GetByte(uint32_t address)
@@ -349,18 +351,11 @@ void S9xSA1SetPCBase(uint32_t address)
    }
 }
 
+/* The main CPU is about to skip ahead to its next event, so hand the SA-1
+ * that time now; it stops early if it reaches its own idle loop. */
 void S9xSA1ExecuteDuringSleep()
 {
-#if 0
-   if (SA1.Executing)
-   {
-      while (CPU.Cycles < CPU.NextEvent)
-      {
-         S9xSA1MainLoop();
-         CPU.Cycles += TWO_CYCLES * 2;
-      }
-   }
-#endif
+   S9xSA1ExecuteUntil(CPU.NextEvent);
 }
 
 void S9xSetSA1MemMap(uint32_t which1, uint8_t map)
@@ -802,7 +797,7 @@ void S9xSetSA1(uint8_t byte, uint32_t address)
 
 static void S9xSA1CharConv2()
 {
-   int l, b;
+   int l;
    uint32_t dest = Memory.FillRAM [0x2235] | (Memory.FillRAM [0x2236] << 8);
    uint32_t offset = (SA1.in_char_dma & 7) ? 0 : 1;
    int depth = (Memory.FillRAM [0x2231] & 3) == 0 ? 8 :
@@ -811,31 +806,13 @@ static void S9xSA1CharConv2()
    uint8_t* p = &Memory.FillRAM [0x3000] + dest + offset * bytes_per_char;
    uint8_t* q = &Memory.ROM [MAX_ROM_SIZE - 0x10000] + offset * 64;
 
-   switch (depth)
-   {
-   case 2:
-      break;
-   case 4:
-      break;
-   case 8:
-      for (l = 0; l < 8; l++, q += 8)
-      {
-         for (b = 0; b < 8; b++)
-         {
-            uint8_t r = *(q + b);
-            *(p +  0) = (*(p +  0) << 1) | ((r >> 0) & 1);
-            *(p +  1) = (*(p +  1) << 1) | ((r >> 1) & 1);
-            *(p + 16) = (*(p + 16) << 1) | ((r >> 2) & 1);
-            *(p + 17) = (*(p + 17) << 1) | ((r >> 3) & 1);
-            *(p + 32) = (*(p + 32) << 1) | ((r >> 4) & 1);
-            *(p + 33) = (*(p + 33) << 1) | ((r >> 5) & 1);
-            *(p + 48) = (*(p + 48) << 1) | ((r >> 6) & 1);
-            *(p + 49) = (*(p + 49) << 1) | ((r >> 7) & 1);
-         }
-         p += 2;
-      }
-      break;
-   }
+   // The bitmap register file holds one pixel per byte whatever the depth;
+   // only the low depth bits of each pixel reach the character.
+   for (l = 0; l < 8; l++, q += 8, p += 2)
+      S9xSA1PlanarRow(p,
+                      ((uint32_t) q[0] << 24) | (q[1] << 16) | (q[2] << 8) | q[3],
+                      ((uint32_t) q[4] << 24) | (q[5] << 16) | (q[6] << 8) | q[7],
+                      depth);
 }
 
 static void S9xSA1DMA()
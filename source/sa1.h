@@ -176,7 +176,13 @@ extern SOpcodes S9xSA1OpcodesM0X1 [256];
 extern SOpcodes S9xSA1OpcodesM0X0 [256];
 extern SSA1 SA1;
 
-void S9xSA1MainLoop();
+/* Average SA-1 instruction cost in master cycles: about four 10.74MHz SA-1
+ * cycles, which keeps the old three SA-1 opcodes per main CPU opcode. */
+#define SA1_CYCLES_PER_OPCODE 8
+
+extern int32_t SA1Cycles;
+
+void S9xSA1ExecuteUntil(int32_t);
 void S9xSA1Init();
 void S9xFixSA1AfterSnapshotLoad();
 void S9xSA1ExecuteDuringSleep();
@@ -185,6 +191,87 @@ void S9xSA1ExecuteDuringSleep();
 #define TIMER_IRQ_SOURCE    (1 << 6)
 #define DMA_IRQ_SOURCE      (1 << 5)
 
+/* Run the SA-1 up to the main CPU's current cycle. */
+STATIC inline void S9xSA1Sync()
+{
+   if (SA1Cycles < CPU.Cycles)
+      S9xSA1ExecuteUntil(CPU.Cycles);
+}
+
+/* Main CPU view of the memory shared with the SA-1 (MAP_SA1_SHARED): I-RAM
+ * at 3000-37ff in banks 00-3f/80-bf and BW-RAM in banks 40-7d. */
+STATIC inline uint8_t* S9xSA1SharedMemory(uint32_t address)
+{
+   if ((address & 0x400000) && !(address & 0x800000))
+      return Memory.SRAM + (address & 0x1ffff);
+   return Memory.FillRAM + (address & 0xffff);
+}
+
+/* Character conversion: write one 8-pixel row as SNES bitplanes. x holds
+ * chunky pixels 0-3 and y pixels 4-7, one per byte with the leftmost pixel
+ * in the top byte; plane pairs land 16 bytes apart as in a character. The
+ * planes come out of an 8x8 bit matrix transpose instead of bit by bit. */
+STATIC inline void S9xSA1PlanarRow(uint8_t* p, uint32_t x, uint32_t y, int depth)
+{
+   uint32_t t;
+
+   t = (x ^ (x >> 7)) & 0x00aa00aa;
+   x = x ^ t ^ (t << 7);
+   t = (y ^ (y >> 7)) & 0x00aa00aa;
+   y = y ^ t ^ (t << 7);
+   t = (x ^ (x >> 14)) & 0x0000cccc;
+   x = x ^ t ^ (t << 14);
+   t = (y ^ (y >> 14)) & 0x0000cccc;
+   y = y ^ t ^ (t << 14);
+   t = (x & 0xf0f0f0f0) | ((y >> 4) & 0x0f0f0f0f);
+   y = ((x << 4) & 0xf0f0f0f0) | (y & 0x0f0f0f0f);
+
+   /* byte n of y is now bitplane n, byte n of t bitplane 4 + n */
+   switch (depth)
+   {
+   case 8:
+      p[32] = (uint8_t) t;
+      p[33] = (uint8_t)(t >> 8);
+      p[48] = (uint8_t)(t >> 16);
+      p[49] = (uint8_t)(t >> 24);
+      /* fall through */
+   case 4:
+      p[16] = (uint8_t)(y >> 16);
+      p[17] = (uint8_t)(y >> 24);
+      /* fall through */
+   case 2:
+      p[0] = (uint8_t) y;
+      p[1] = (uint8_t)(y >> 8);
+   }
+}
+
+/* Unpack one row of packed bitmap data, leftmost pixel in the low bits */
+STATIC inline void S9xSA1PackedRowToPlanar(uint8_t* p, const uint8_t* q, int depth)
+{
+   switch (depth)
+   {
+   case 2:
+      S9xSA1PlanarRow(p,
+                      ((q[0] & 0x03) << 24) | ((q[0] & 0x0c) << 14) |
+                      ((q[0] & 0x30) << 4) | (q[0] >> 6),
+                      ((q[1] & 0x03) << 24) | ((q[1] & 0x0c) << 14) |
+                      ((q[1] & 0x30) << 4) | (q[1] >> 6), 2);
+      break;
+   case 4:
+      S9xSA1PlanarRow(p,
+                      ((q[0] & 0x0f) << 24) | ((q[0] & 0xf0) << 12) |
+                      ((q[1] & 0x0f) << 8) | (q[1] >> 4),
+                      ((q[2] & 0x0f) << 24) | ((q[2] & 0xf0) << 12) |
+                      ((q[3] & 0x0f) << 8) | (q[3] >> 4), 4);
+      break;
+   case 8:
+      S9xSA1PlanarRow(p,
+                      ((uint32_t) q[0] << 24) | (q[1] << 16) | (q[2] << 8) | q[3],
+                      ((uint32_t) q[4] << 24) | (q[5] << 16) | (q[6] << 8) | q[7], 8);
+      break;
+   }
+}
+
 STATIC inline void S9xSA1UnpackStatus()
 {
    SA1._Zero = (SA1.Registers.PL & Zero) == 0;
@@ -202,44 +202,66 @@
 
 #include "cpuops.c"
 
-void S9xSA1MainLoop()
+/* The SA-1 keeps its own clock in the main CPU's master-cycle time base and
+ * is only brought up to date when the two processors can actually observe
+ * each other: at HBlank, before the main CPU touches I-RAM, BW-RAM or the
+ * SA-1 registers, and while the main CPU is sleeping. The opcodes are built
+ * without VAR_CYCLES, so every SA-1 instruction is charged an average cost. */
+int32_t SA1Cycles;
+
+void S9xSA1ExecuteUntil(int32_t cycles)
 {
-   int i;
+   if (!SA1.Executing)
+   {
+      SA1Cycles = cycles;
+      return;
+   }
 
-#if 0
-   if (SA1.Flags & NMI_FLAG)
+   /* Never owe the SA-1 more than a scanline, e.g. after the main CPU's
+    * clock was reset. */
+   if (cycles - SA1Cycles > (int32_t) Settings.H_Max)
+      SA1Cycles = cycles - Settings.H_Max;
+
+   while (SA1Cycles < cycles)
    {
-      SA1.Flags &= ~NMI_FLAG;
-      if (SA1.WaitingForInterrupt)
+      if (!SA1.Executing)
       {
-         SA1.WaitingForInterrupt = false;
-         SA1.PC++;
+         SA1Cycles = cycles;
+         return;
       }
-      S9xSA1Opcode_NMI();
-   }
-#endif
-   if (SA1.Flags & IRQ_PENDING_FLAG)
-   {
-      if (SA1.IRQActive)
+
+#if 0
+      if (SA1.Flags & NMI_FLAG)
       {
+         SA1.Flags &= ~NMI_FLAG;
          if (SA1.WaitingForInterrupt)
          {
             SA1.WaitingForInterrupt = false;
             SA1.PC++;
          }
-         if (!SA1CheckFlag(IRQ))
-            S9xSA1Opcode_IRQ();
+         S9xSA1Opcode_NMI();
+      }
+#endif
+      if (SA1.Flags & IRQ_PENDING_FLAG)
+      {
+         if (SA1.IRQActive)
+         {
+            if (SA1.WaitingForInterrupt)
+            {
+               SA1.WaitingForInterrupt = false;
+               SA1.PC++;
+            }
+            if (!SA1CheckFlag(IRQ))
+               S9xSA1Opcode_IRQ();
+         }
+         else
+            SA1.Flags &= ~IRQ_PENDING_FLAG;
       }
-      else
-         SA1.Flags &= ~IRQ_PENDING_FLAG;
-   }
 
-   for (i = 0; i < 3 && SA1.Executing; i++)
-   {
 #ifdef CPU_SHUTDOWN
       SA1.PCAtOpcodeStart = SA1.PC;
 #endif
       (*SA1.S9xOpcodes [*SA1.PC++].S9xOpcode)();
+      SA1Cycles += SA1_CYCLES_PER_OPCODE;
    }
 }
-
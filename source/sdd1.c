@@ -92,6 +92,143 @@
 #include "sdd1.h"
 #include "display.h"
 
+#ifdef SDD1_DECOMP
+#include "sdd1emu.h"
+
+/* Decompressed S-DD1 DMA sources, keyed by the compressed block in ROM so
+ * graphics that are streamed again and again are only decoded once. Least
+ * recently used blocks go once Settings.SDD1CacheSize bytes are in use. */
+#define SDD1_CACHE_ENTRIES 64
+
+typedef struct
+{
+   uint8_t* src;
+   uint8_t* data;
+   uint32_t len;
+   uint32_t stamp;
+   uint8_t  header;
+} SSDD1CacheEntry;
+
+static SSDD1CacheEntry sdd1_cache [SDD1_CACHE_ENTRIES];
+static uint32_t sdd1_cache_bytes = 0;
+static uint32_t sdd1_cache_clock = 0;
+
+static void S9xSDD1DropCacheEntry(SSDD1CacheEntry* e)
+{
+   sdd1_cache_bytes -= e->len;
+   free(e->data);
+   e->data = NULL;
+   e->src = NULL;
+   e->len = 0;
+}
+
+static SSDD1CacheEntry* S9xSDD1OldestCacheEntry()
+{
+   SSDD1CacheEntry* oldest = NULL;
+   int i;
+
+   for (i = 0; i < SDD1_CACHE_ENTRIES; i++)
+   {
+      if (sdd1_cache [i].data &&
+            (!oldest || sdd1_cache [i].stamp < oldest->stamp))
+         oldest = &sdd1_cache [i];
+   }
+   return oldest;
+}
+
+void S9xSDD1FreeCache()
+{
+   int i;
+
+   for (i = 0; i < SDD1_CACHE_ENTRIES; i++)
+   {
+      if (sdd1_cache [i].data)
+         S9xSDD1DropCacheEntry(&sdd1_cache [i]);
+   }
+   sdd1_cache_clock = 0;
+}
+
+/* Returns the decompressed data for the block at in, either from the cache
+ * or freshly decoded into it; buffer is used when the block can't be kept. */
+uint8_t* S9xSDD1Decompress(uint8_t* buffer, uint8_t* in, uint32_t len)
+{
+   SSDD1CacheEntry* e;
+   SSDD1CacheEntry* slot = NULL;
+   int i;
+
+   if (len == 0)
+      len = 0x10000;
+
+   if (len > Settings.SDD1CacheSize)
+   {
+      SDD1_decompress(buffer, in, len);
+      return buffer;
+   }
+
+   for (i = 0; i < SDD1_CACHE_ENTRIES; i++)
+   {
+      e = &sdd1_cache [i];
+      if (!e->data)
+      {
+         if (!slot)
+            slot = e;
+         continue;
+      }
+      if (e->src != in || e->header != in [0])
+         continue;
+      if (e->len >= len)
+      {
+         e->stamp = ++sdd1_cache_clock;
+         return e->data;
+      }
+      // The same block is wanted for longer; its short copy is no use now.
+      S9xSDD1DropCacheEntry(e);
+      if (!slot)
+         slot = e;
+   }
+
+   while (sdd1_cache_bytes + len > Settings.SDD1CacheSize)
+   {
+      e = S9xSDD1OldestCacheEntry();
+      if (!e)
+         break;
+      S9xSDD1DropCacheEntry(e);
+   }
+
+   // Making room above may have freed a slot; only push out the oldest
+   // block when every slot is still taken.
+   for (i = 0; !slot && i < SDD1_CACHE_ENTRIES; i++)
+   {
+      if (!sdd1_cache [i].data)
+         slot = &sdd1_cache [i];
+   }
+   if (!slot)
+   {
+      slot = S9xSDD1OldestCacheEntry();
+      if (!slot)
+      {
+         SDD1_decompress(buffer, in, len);
+         return buffer;
+      }
+      S9xSDD1DropCacheEntry(slot);
+   }
+
+   slot->data = (uint8_t*) malloc(len);
+   if (!slot->data)
+   {
+      SDD1_decompress(buffer, in, len);
+      return buffer;
+   }
+   SDD1_decompress(slot->data, in, len);
+   slot->src = in;
+   slot->header = in [0];
+   slot->len = len;
+   slot->stamp = ++sdd1_cache_clock;
+   sdd1_cache_bytes += len;
+   return slot->data;
+}
+#endif
+
 void S9xSetSDD1MemoryMap(uint32_t bank, uint32_t value)
 {
    bank = 0xc00 + bank * 0x100;
@@ -93,6 +93,10 @@
 void S9xSetSDD1MemoryMap(uint32_t bank, uint32_t value);
 void S9xResetSDD1();
 void S9xSDD1PostLoadState();
+#ifdef SDD1_DECOMP
+uint8_t* S9xSDD1Decompress(uint8_t* buffer, uint8_t* in, uint32_t len);
+void S9xSDD1FreeCache();
+#endif
 
 #endif
 
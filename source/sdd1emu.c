@@ -108,8 +108,7 @@ static int valid_bits;
 static uint16_t in_stream;
 static uint8_t* in_buf;
 static uint8_t bit_ctr[8];
-static uint8_t context_states[32];
-static int context_MPS[32];
+static uint8_t context_states[32]; /* evolution state | MPS << 6 */
 static int bitplane_type;
 static int high_context_bits;
 static int low_context_bits;
@@ -206,30 +205,40 @@ static inline uint8_t GolombGetBit(int code_size)
    return (bit_ctr[code_size] == 0) ? 1 : 0;
 }
 
-static inline uint8_t ProbGetBit(uint8_t context)
+/* The evolution table folded with the MPS bit: prob_next[bit][state | MPS << 6]
+ * is the context's next packed state for each GolombGetBit() result, so the
+ * probability update is two lookups instead of a chain of branches. */
+static uint8_t prob_code_size[0x80];
+static uint8_t prob_next[3][0x80];
+static bool prob_tables_ready = false;
+
+static void InitProbTables()
 {
-   uint8_t state = context_states[context];
-   uint8_t bit = GolombGetBit(evolution_table[state].code_size);
+   int state, mps;
 
-   if (bit & 1)
+   for (mps = 0; mps < 2; mps++)
    {
-      context_states[context] = evolution_table[state].LPS_next;
-      if (state < 2)
-      {
-         context_MPS[context] ^= 1;
-         return context_MPS[context]; /* just inverted, so just return it */
-      }
-      else
+      for (state = 0; state < 33; state++)
       {
-         return context_MPS[context] ^ 1; /* we know bit is 1, so use a constant */
+         int v = state | (mps << 6);
+         prob_code_size[v] = evolution_table[state].code_size;
+         prob_next[0][v] = v;
+         prob_next[1][v] = evolution_table[state].LPS_next |
+                           ((mps ^ (state < 2)) << 6);
+         prob_next[2][v] = evolution_table[state].MPS_next | (mps << 6);
       }
    }
-   else if (bit)
-   {
-      context_states[context] = evolution_table[state].MPS_next;
-      /* zero here, zero there, no difference so drop through. */
-   }
-   return context_MPS[context]; /* we know bit is 0, so don't bother xoring */
+   prob_tables_ready = true;
+}
+
+static inline uint8_t ProbGetBit(uint8_t context)
+{
+   uint8_t v = context_states[context];
+   uint8_t bit = GolombGetBit(prob_code_size[v]);
+
+   context_states[context] = prob_next[bit][v];
+   /* an LPS is always the opposite of the MPS the context held before */
+   return (v >> 6) ^ (bit & 1);
 }
 
 static inline uint8_t GetBit(uint8_t cur_bitplane)
@@ -252,6 +261,9 @@ void SDD1_decompress(uint8_t* out, uint8_t* in, int len)
 
    if (len == 0) len = 0x10000;
 
+   if (!prob_tables_ready)
+      InitProbTables();
+
    bitplane_type = in[0] >> 6;
 
    switch (in[0] & 0x30)
@@ -279,7 +291,6 @@ void SDD1_decompress(uint8_t* out, uint8_t* in, int len)
    in_buf = in + 2;
    memset(bit_ctr, 0, sizeof(bit_ctr));
    memset(context_states, 0, sizeof(context_states));
-   memset(context_MPS, 0, sizeof(context_MPS));
    memset(prev_bits, 0, sizeof(prev_bits));
 
    switch (bitplane_type)
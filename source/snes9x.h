@@ -294,10 +294,12 @@ typedef struct
    bool  SuperScopeMaster;
    bool  MouseMaster;
    bool  SuperFX;
+   bool  ThreadSuperFX; /* run GSU sessions on a worker thread */
    bool  DSP1Master;
    bool  SA1;
    bool  C4;
    bool  SDD1;
+   uint32_t SDD1CacheSize; /* bytes of decompressed S-DD1 data to keep */
    bool  SPC7110;
    bool  SPC7110RTC;
    bool  OBC1;
@@ -90,83 +90,402 @@
 #include "spc7110.h"
 #include "memmap.h"
 #include <time.h>
-#include <sys/stat.h>
-
-//Windows includes
-#ifdef __WIN32__
-#ifndef _XBOX           // chdir and getcwd not supported on Xbox hardware
-#include <direct.h>
-#define chdir _chdir
-#define getcwd _getcwd
-#endif
-
-#ifndef PATH_MAX
-#ifdef MAX_PATH
-#define PATH_MAX  MAX_PATH
-#else
-#define PATH_MAX 1024
-#endif
-#endif
-
-#else // Unix
-#include "display.h"
-#include <limits.h>
-#include <unistd.h>
-#endif
 
 const char* S9xGetFilename(const char*);
-char* osd_GetPackDir();
-//really not needed, but usually MS adds the _ to POSIX functions,
-//while *nix doesn't, so this was to "un-M$" the function.
-#define splitpath _splitpath
 
-//not much headroom, but FEOEZ has 41 tables, I think, and SPL4 has 38.
-#define MAX_TABLES 48
+SPC7110Regs s7r;        //SPC7110 registers, about 33KB
+S7RTC rtc_f9;           //FEOEZ (and Shounen Jump no SHou) RTC
+void  S9xUpdateRTC();   //S-RTC function hacked to work with the RTC
 
-//default to using 5 megs of RAM for method 3 caching.
-uint16_t cacheMegs = 5;
+/* Decompression unit. Each table entry in the data ROM selects one of three
+ * adaptive binary arithmetic coded streams: mode 0 decodes 1bpp bytes,
+ * mode 1 2bpp rows and mode 2 4bpp rows. Streams are decoded on demand into
+ * a small LRU of buffers, so a restart at a table entry that was seen before
+ * (which is how the games scroll their maps and fonts) costs nothing, and DMA
+ * can take a contiguous pointer into the decoded data. */
 
-//using function pointers to initialize cache management
-void (*CleanUp7110)(void) = NULL;
-void (*LoadUp7110)(char*) = &SPC7110Load;
-void (*Copy7110)(void) = NULL;
+#define SPC7110_STREAMS 8
 
-//size and offset of the pack data
-//offset and size of reads from pack
-typedef struct SPC7110DecompressionLocationStruct
+typedef struct
 {
-   uint32_t offset;
+   uint8_t index;
+   uint8_t invert;
+} SPC7110Context;
+
+typedef struct
+{
+   uint32_t mode;             /* 0: 1bpp, 1: 2bpp, 2: 4bpp */
+   uint32_t offset;           /* start of the stream in the data ROM */
+   uint32_t read;             /* next compressed byte */
+   uint8_t  val;
+   uint8_t  in;
+   uint8_t  span;
+   int32_t  in_count;
+   uint32_t out;
+   uint32_t out1;
+   uint32_t inverts;
+   uint32_t lps;
+   uint8_t  pixelorder[16];
+   uint8_t  planes[16];       /* mode 2 emits bitplanes 2-3 after 0-1 */
+   uint32_t planes_index;
+   SPC7110Context context[32];
+   uint8_t* data;             /* everything decoded from the stream start */
+   uint32_t length;
    uint32_t size;
-   uint16_t used_offset;
-   uint16_t used_len;
-} Data7110;
+   uint32_t stamp;
+} SPC7110Stream;
+
+static SPC7110Stream spc7110_streams[SPC7110_STREAMS];
+static SPC7110Stream* spc7110_stream = NULL;
+static uint32_t spc7110_skip = 0;
+static uint32_t spc7110_stamp = 0;
 
-//this maps an index.bin table to the decompression pack
-typedef struct SPC7110DecompressionIndexStruct
+/* {probability, next index after LPS, next index after MPS, toggle invert} */
+static const uint8_t spc7110_evolution[53][4] =
 {
-   int table;
-   bool is_file;
-   Data7110 location[256];
-} Index7110;
+   {0x5a,  1,  1, 1}, {0x25,  6,  2, 0}, {0x11,  8,  3, 0}, {0x08, 10,  4, 0},
+   {0x03, 12,  5, 0}, {0x01, 15,  5, 0},
 
-//this contains all the data for the decompression pack.
-typedef struct SPC7110DecompressionPackStructure
+   {0x5a,  7,  7, 1}, {0x3f, 19,  8, 0}, {0x2c, 21,  9, 0}, {0x20, 22, 10, 0},
+   {0x17, 23, 11, 0}, {0x11, 25, 12, 0}, {0x0c, 26, 13, 0}, {0x09, 28, 14, 0},
+   {0x07, 29, 15, 0}, {0x05, 31, 16, 0}, {0x04, 32, 17, 0}, {0x03, 34, 18, 0},
+   {0x02, 35,  5, 0},
+
+   {0x5a, 20, 20, 1}, {0x48, 39, 21, 0}, {0x3a, 40, 22, 0}, {0x2e, 42, 23, 0},
+   {0x26, 44, 24, 0}, {0x1f, 45, 25, 0}, {0x19, 46, 26, 0}, {0x15, 25, 27, 0},
+   {0x11, 26, 28, 0}, {0x0e, 26, 29, 0}, {0x0b, 27, 30, 0}, {0x09, 28, 31, 0},
+   {0x08, 29, 32, 0}, {0x07, 30, 33, 0}, {0x05, 31, 34, 0}, {0x04, 33, 35, 0},
+   {0x04, 33, 36, 0}, {0x03, 34, 37, 0}, {0x02, 35, 38, 0}, {0x02, 36,  5, 0},
+
+   {0x58, 39, 40, 1}, {0x4d, 47, 41, 0}, {0x43, 48, 42, 0}, {0x3b, 49, 43, 0},
+   {0x34, 50, 44, 0}, {0x2e, 51, 45, 0}, {0x29, 44, 46, 0}, {0x25, 45, 24, 0},
+
+   {0x56, 47, 48, 1}, {0x4f, 47, 49, 0}, {0x47, 48, 50, 0}, {0x41, 49, 51, 0},
+   {0x3c, 50, 52, 0}, {0x37, 51, 43, 0}
+};
+
+static const uint8_t spc7110_mode2_context[32][2] =
 {
-   uint8_t* binfiles[MAX_TABLES];
-   Index7110 tableEnts[MAX_TABLES];
-   int last_table;
-   int idx;
-   uint8_t last_idx;
-   uint16_t last_offset;
-} Pack7110;
-
-
-char pfold[9];          //hack variable for log naming (each game makes a different log)
-Pack7110* decompack =
-   NULL; //decompression pack uses a fair chunk of RAM, so dynalloc it.
-SPC7110Regs s7r;        //SPC7110 registers, about 33KB
-S7RTC rtc_f9;           //FEOEZ (and Shounen Jump no SHou) RTC
-void  S9xUpdateRTC();   //S-RTC function hacked to work with the RTC
+   { 1,  2},
+   { 3,  8}, {13, 14},
+   {15, 16}, {17, 18}, {19, 20}, {21, 22}, {23, 24}, {25, 26}, {25, 26},
+   {25, 26}, {25, 26}, {25, 26}, {27, 28}, {29, 30},
+   {31, 31}, {31, 31}, {31, 31}, {31, 31}, {31, 31}, {31, 31}, {31, 31},
+   {31, 31}, {31, 31}, {31, 31}, {31, 31}, {31, 31}, {31, 31}, {31, 31},
+   {31, 31}, {31, 31},
+   {31, 31}
+};
+
+/* Spread the decoded pixels (most significant pixel first) into bitplanes. */
+static uint16_t spc7110_morton16[2][256];
+static uint32_t spc7110_morton32[4][256];
+
+static void S9xSpc7110InitMorton()
+{
+   static const uint8_t map16[2][8] =
+   {
+      { 0,  8,  1,  9,  2, 10,  3, 11},
+      { 4, 12,  5, 13,  6, 14,  7, 15}
+   };
+   static const uint8_t map32[4][8] =
+   {
+      { 0,  8, 16, 24,  1,  9, 17, 25},
+      { 2, 10, 18, 26,  3, 11, 19, 27},
+      { 4, 12, 20, 28,  5, 13, 21, 29},
+      { 6, 14, 22, 30,  7, 15, 23, 31}
+   };
+   uint32_t i, b, n;
+
+   for (i = 0; i < 256; i++)
+   {
+      for (n = 0; n < 2; n++)
+         for (spc7110_morton16[n][i] = 0, b = 0; b < 8; b++)
+            if (i & (1 << b))
+               spc7110_morton16[n][i] |= 1u << map16[n][b];
+      for (n = 0; n < 4; n++)
+         for (spc7110_morton32[n][i] = 0, b = 0; b < 8; b++)
+            if (i & (1 << b))
+               spc7110_morton32[n][i] |= 1u << map32[n][b];
+   }
+}
+
+static INLINE uint8_t S9xSpc7110DataRead(SPC7110Stream* s)
+{
+   if (s->read >= s7r.DataRomSize)
+      s->read %= s7r.DataRomSize;
+   return Memory.ROM[s7r.DataRomOffset + s->read++];
+}
+
+/* One binary decision in context con; the caller reads the decoded bit back
+ * as (lps ^ inverts) & 1. Returns whether the less probable symbol came up. */
+static INLINE uint32_t S9xSpc7110DecodeBit(SPC7110Stream* s, uint32_t con)
+{
+   SPC7110Context* ctx = &s->context[con];
+   const uint8_t* evolution = spc7110_evolution[ctx->index];
+   uint32_t prob = evolution[0];
+   uint32_t flag_lps;
+   uint32_t shift = 0;
+
+   if (s->val <= s->span - prob)
+   {
+      s->span -= prob;
+      flag_lps = 0;
+   }
+   else
+   {
+      s->val -= s->span - (prob - 1);
+      s->span = prob - 1;
+      flag_lps = 1;
+   }
+
+   while (s->span < 0x7f)
+   {
+      shift++;
+      s->span = (s->span << 1) + 1;
+      s->val = (s->val << 1) + (s->in >> 7);
+      s->in <<= 1;
+      if (--s->in_count == 0)
+      {
+         s->in = S9xSpc7110DataRead(s);
+         s->in_count = 8;
+      }
+   }
+
+   s->lps = (s->lps << 1) + flag_lps;
+   s->inverts = (s->inverts << 1) + ctx->invert;
+
+   if (flag_lps & evolution[3])
+      ctx->invert ^= 1;
+   if (flag_lps)
+      ctx->index = evolution[1];
+   else if (shift)
+      ctx->index = evolution[2];
+   return flag_lps;
+}
+
+static INLINE void S9xSpc7110MoveToFront(uint8_t* order, uint32_t n, uint32_t value)
+{
+   uint32_t m;
+   for (m = 0; m < n - 1 && order[m] != value; m++);
+   for (; m > 0; m--)
+      order[m] = order[m - 1];
+   order[0] = value;
+}
+
+static INLINE uint32_t S9xSpc7110RefContext(uint32_t a, uint32_t b, uint32_t c)
+{
+   if (a == b)
+      return b != c;
+   if (b == c)
+      return 2;
+   return 4 - (a == c);
+}
+
+/* Eight 4bpp pixels, first pixel in the top nibble. Like mode 1, the plane
+ * pair from the high pixel bits goes out first; the other pair is held back
+ * until the tile's eight rows are done, as in a SNES 4bpp tile. */
+static INLINE void S9xSpc7110EmitMode2Row(SPC7110Stream* s, uint32_t out)
+{
+   uint32_t data = spc7110_morton32[0][out & 0xff] + spc7110_morton32[1][(out >> 8) & 0xff]
+                 + spc7110_morton32[2][(out >> 16) & 0xff] + spc7110_morton32[3][out >> 24];
+   s->data[s->length++] = data >> 24;
+   s->data[s->length++] = data >> 16;
+   s->planes[s->planes_index++] = data >> 8;
+   s->planes[s->planes_index++] = data;
+   if (s->planes_index == 16)
+   {
+      memcpy(s->data + s->length, s->planes, 16);
+      s->length += 16;
+      s->planes_index = 0;
+   }
+}
+
+static void S9xSpc7110Decode(SPC7110Stream* s, uint32_t target)
+{
+   uint8_t realorder[16];
+   uint32_t pixel, bit, con, refcon, a, b, c, data;
+
+   /* every pass below emits at most 18 bytes */
+   if (target + 32 > s->size)
+   {
+      uint32_t size = s->size ? s->size : 0x4000;
+      uint8_t* grown;
+      while (size < target + 32)
+         size <<= 1;
+      grown = (uint8_t*)realloc(s->data, size);
+      if (!grown)
+         return;
+      s->data = grown;
+      s->size = size;
+   }
+
+   switch (s->mode)
+   {
+   case 0:
+      while (s->length < target)
+      {
+         for (bit = 0; bit < 8; bit++)
+         {
+            uint32_t mask = (1 << (bit & 3)) - 1;
+            uint32_t flag_lps, mps;
+            con = mask + ((s->inverts & mask) ^ (s->lps & mask));
+            if (bit > 3)
+               con += 15;
+            flag_lps = S9xSpc7110DecodeBit(s, con);
+            mps = ((s->out >> 15) & 1) ^ (s->inverts & 1);
+            s->out = (s->out << 1) + (mps ^ flag_lps);
+         }
+         s->data[s->length++] = s->out;
+      }
+      break;
+   case 1:
+      while (s->length < target)
+      {
+         for (pixel = 0; pixel < 8; pixel++)
+         {
+            a = (s->out >> 2) & 3;
+            b = (s->out >> 14) & 3;
+            c = (s->out >> 16) & 3;
+            con = S9xSpc7110RefContext(a, b, c);
+
+            S9xSpc7110MoveToFront(s->pixelorder, 4, a);
+            memcpy(realorder, s->pixelorder, 4);
+            S9xSpc7110MoveToFront(realorder, 4, c);
+            S9xSpc7110MoveToFront(realorder, 4, b);
+            S9xSpc7110MoveToFront(realorder, 4, a);
+
+            for (bit = 0; bit < 2; bit++)
+            {
+               S9xSpc7110DecodeBit(s, con);
+               con = 5 + (con << 1) + ((s->lps ^ s->inverts) & 1);
+            }
+            s->out = (s->out << 2) + realorder[(s->lps ^ s->inverts) & 3];
+         }
+         data = spc7110_morton16[0][s->out & 0xff] + spc7110_morton16[1][(s->out >> 8) & 0xff];
+         s->data[s->length++] = data >> 8;
+         s->data[s->length++] = data;
+      }
+      break;
+   case 2:
+      while (s->length < target)
+      {
+         for (pixel = 0; pixel < 8; pixel++)
+         {
+            a = s->out & 0x0f;
+            b = (s->out >> 28) & 0x0f;
+            c = s->out1 & 0x0f;
+            refcon = S9xSpc7110RefContext(a, b, c);
+
+            S9xSpc7110MoveToFront(s->pixelorder, 16, a);
+            memcpy(realorder, s->pixelorder, 16);
+            S9xSpc7110MoveToFront(realorder, 16, c);
+            S9xSpc7110MoveToFront(realorder, 16, b);
+            S9xSpc7110MoveToFront(realorder, 16, a);
+
+            for (con = 0, bit = 0; bit < 4; bit++)
+            {
+               S9xSpc7110DecodeBit(s, con);
+               con = spc7110_mode2_context[con][(s->lps ^ s->inverts) & 1] + (con == 1 ? refcon : 0);
+            }
+            s->out1 = (s->out1 << 4) + ((s->out >> 28) & 0x0f);
+            s->out = (s->out << 4) + realorder[(s->lps ^ s->inverts) & 0x0f];
+         }
+         S9xSpc7110EmitMode2Row(s, s->out);
+      }
+      break;
+   }
+}
+
+static void S9xSpc7110FreeStreams()
+{
+   int i;
+   for (i = 0; i < SPC7110_STREAMS; i++)
+      free(spc7110_streams[i].data);
+   memset(spc7110_streams, 0, sizeof(spc7110_streams));
+   spc7110_stream = NULL;
+   spc7110_skip = 0;
+}
+
+/* Latch the table entry selected by $4801-$4804 and position the read
+ * pointer at the $4805-$4806 offset, scaled by the stream's mode. */
+static void S9xSpc7110SelectStream()
+{
+   uint32_t table = s7r.reg4801 | (s7r.reg4802 << 8) | (s7r.reg4803 << 16);
+   uint32_t addr, mode, offset, i;
+   SPC7110Stream* s = NULL;
+
+   spc7110_stream = NULL;
+   if (s7r.DataRomSize == 0)
+      return;
+
+   addr = s7r.DataRomOffset + (table + 4 * s7r.reg4804) % s7r.DataRomSize;
+   mode = Memory.ROM[addr];
+   offset = (Memory.ROM[addr + 1] << 16) | (Memory.ROM[addr + 2] << 8) | Memory.ROM[addr + 3];
+   if (mode > 2)
+      return;
+   spc7110_skip = (s7r.reg4805 | (s7r.reg4806 << 8)) << mode;
+
+   for (i = 0; i < SPC7110_STREAMS; i++)
+   {
+      SPC7110Stream* e = &spc7110_streams[i];
+      if (e->data && e->mode == mode && e->offset == offset)
+      {
+         s = e;
+         break;
+      }
+      if (!s || e->stamp < s->stamp)
+         s = e;
+   }
+
+   if (s->mode != mode || s->offset != offset || !s->data)
+   {
+      uint8_t* data = s->data;
+      uint32_t size = s->size;
+      memset(s, 0, sizeof(SPC7110Stream));
+      s->data = data;
+      s->size = size;
+      s->mode = mode;
+      s->offset = offset;
+      s->read = offset;
+      s->span = 0xff;
+      s->val = S9xSpc7110DataRead(s);
+      s->in = S9xSpc7110DataRead(s);
+      s->in_count = 8;
+      for (i = 0; i < 16; i++)
+         s->pixelorder[i] = i;
+   }
+   s->stamp = ++spc7110_stamp;
+   spc7110_stream = s;
+}
+
+/* Returns count decoded bytes from the current read position and advances
+ * past them. The pointer stays valid until the next call. */
+uint8_t* S9xSpc7110Decompress(uint32_t count)
+{
+   SPC7110Stream* s = spc7110_stream;
+   uint32_t pos = spc7110_skip + s7r.bank50Internal;
+
+   s7r.bank50Internal += count;
+   if (s && s->length < pos + count)
+      S9xSpc7110Decode(s, pos + count);
+   if (!s || s->length < pos + count)
+   {
+      memset(s7r.bank50, 0, count);
+      return s7r.bank50;
+   }
+   return s->data + pos;
+}
+
+/* Decoder state is not part of the snapshot; rebuild it from the registers. */
+void S9xSpc7110PostLoadState()
+{
+   S9xSpc7110SelectStream();
+}
+
+void S9xSpc7110Deinit()
+{
+   S9xSpc7110FreeStreams();
+}
 
 //Emulate power on state
 void S9xSpc7110Init()
@@ -222,346 +541,31 @@ void S9xSpc7110Init()
    s7r.offset_add = 0;
    s7r.AlignBy = 1;
 
-   (*LoadUp7110)(osd_GetPackDir());
+   S9xSpc7110FreeStreams();
+   S9xSpc7110InitMorton();
 
    s7r.bank50Internal = 0;
    memset(s7r.bank50, 0x00, DECOMP_BUFFER_SIZE);
 }
 
 
-//full cache decompression routine (memcpy) Method 1
-void MovePackData()
-{
-   //log the last entry
-   Data7110* log = &
-                   (decompack->tableEnts[decompack->idx].location[decompack->last_idx]);
-   if ((log->used_len + log->used_offset) < (decompack->last_offset +
-         (unsigned short)s7r.bank50Internal))
-   {
-      log->used_len = s7r.bank50Internal;
-      log->used_offset = decompack->last_offset;
-   }
-
-   //set up for next logging
-   decompack->last_offset = (s7r.reg4805) | (s7r.reg4806 << 8);
-
-   decompack->last_idx = s7r.reg4804;
-
-   //start decompression
-   int table = (s7r.reg4803 << 16) | (s7r.reg4802 << 8) | s7r.reg4801;
-
-   //the table is a offset multiplier byte and a big-endian pointer
-   int j = 4 * s7r.reg4804;
-   j += s7r.DataRomOffset;
-   j += table;
-
-   //set proper offsetting.
-   if (s7r.reg480B == 0)
-      s7r.AlignBy = 0;
-   else
-   {
-      switch (Memory.ROM[j])
-      {
-      case 0x03:
-         s7r.AlignBy = 8;
-         break;
-      case 0x01:
-         s7r.AlignBy = 2;
-         break;
-      case 0x02:
-         s7r.AlignBy = 4;
-         break;
-      case 0x00:
-      default:
-         s7r.AlignBy = 1;
-         break;
-      }
-   }
-   //note that we are still setting up for the next log.
-   decompack->last_offset *= s7r.AlignBy;
-   decompack->last_offset %= DECOMP_BUFFER_SIZE;
-
-   //find the table
-   if (table != decompack->last_table)
-   {
-      int i = 0;
-      while (i < MAX_TABLES && decompack->tableEnts[i].table != table)
-         i++;
-      if (i == MAX_TABLES)
-      {
-#ifdef _XBOX
-         FILE* fp = fopen("T:\\sp7err.out", "a");
-#else
-         FILE* fp = fopen("sp7err.out", "a");
-#endif
-
-         //       fprintf(fp, "Table Entry %06X:%02X not found\n", table, s7r.reg4804);
-         fclose(fp);
-         return;
-      }
-      decompack->idx = i;
-      decompack->last_table = table;
-   }
-
-   //copy data
-   if (decompack->binfiles[decompack->idx])
-   {
-      memcpy(s7r.bank50,
-             &(decompack->binfiles[decompack->idx][decompack->tableEnts[decompack->idx].location[s7r.reg4804].offset]),
-             decompack->tableEnts[decompack->idx].location[s7r.reg4804].size);
-   }
-}
-
-
-//this is similar to the last function, but it keeps the last 5 accessed files open,
-// and reads the data directly. Method 2
-void ReadPackData()
-{
-   static int table_age_2;
-   static int table_age_3;
-   static int table_age_4;
-   static int table_age_5;
-
-   int table = (s7r.reg4803 << 16) | (s7r.reg4802 << 8) | s7r.reg4801;
-
-   if (table == 0)
-   {
-      table_age_2 = table_age_3 = table_age_4 = table_age_5 = MAX_TABLES;
-      return;
-   }
-
-   if (table_age_2 == 0 && table_age_3 == 0 && table_age_4 == 0
-         && table_age_5 == 0)
-      table_age_2 = table_age_3 = table_age_4 = table_age_5 = MAX_TABLES;
-   Data7110* log = &
-                   (decompack->tableEnts[decompack->idx].location[decompack->last_idx]);
-   if ((log->used_len + log->used_offset) < (decompack->last_offset +
-         (unsigned short)s7r.bank50Internal))
-   {
-      log->used_len = s7r.bank50Internal;
-      log->used_offset = decompack->last_offset;
-   }
-
-   decompack->last_offset = (s7r.reg4805) | (s7r.reg4806 << 8);
-
-   decompack->last_idx = s7r.reg4804;
-
-   int j = 4 * s7r.reg4804;
-   j += s7r.DataRomOffset;
-   j += table;
-
-   if (s7r.reg480B == 0)
-      s7r.AlignBy = 0;
-   else
-   {
-      switch (Memory.ROM[j])
-      {
-      case 0x03:
-         s7r.AlignBy = 8;
-         break;
-      case 0x01:
-         s7r.AlignBy = 2;
-         break;
-      case 0x02:
-         s7r.AlignBy = 4;
-         break;
-      case 0x00:
-      default:
-         s7r.AlignBy = 1;
-         break;
-      }
-   }
-   decompack->last_offset *= s7r.AlignBy;
-   decompack->last_offset %= DECOMP_BUFFER_SIZE;
-   if (table != decompack->last_table)
-   {
-      int i = 0;
-      while (i < MAX_TABLES && decompack->tableEnts[i].table != table)
-         i++;
-      if (i == MAX_TABLES)
-      {
-         FILE* fp = fopen("sp7err.out", "a");
-         //       fprintf(fp, "Table Entry %06X:%02X not found\n", table, s7r.reg4804);
-         fclose(fp);
-         return;
-      }
-      if (i != table_age_2 && i != table_age_3 && i != table_age_4
-            && i != table_age_5)
-      {
-         if (table_age_5 != MAX_TABLES && decompack->binfiles[table_age_5])
-         {
-            fclose((FILE*)(decompack->binfiles[table_age_5]));
-            (decompack->binfiles[table_age_5]) = NULL;
-         }
-         table_age_5 = table_age_4;
-         table_age_4 = table_age_3;
-         table_age_3 = table_age_2;
-         table_age_2 = decompack->idx;
-         char name[PATH_MAX];
-         //open file
-         char drive [_MAX_DRIVE + 1];
-         char dir [_MAX_DIR + 1];
-         char fname [_MAX_FNAME + 1];
-         char ext [_MAX_EXT + 1];
-
-         splitpath(Memory.ROMFilename, drive, dir, fname, ext);
-         strcpy(name, drive);
-         //strcat(filename, "\\");
-         strcat(name, dir);
-
-         strcat(name, pfold);
-         char bfname[11];
-         sprintf(bfname, "%06X.bin", table);
-         strcat(name, "/");
-         strcat(name, bfname);
-         decompack->binfiles[i] = (uint8_t*)fopen(name, "rb");
-      }
-      else
-      {
-         //fix tables in this case
-         if (table_age_5 == i)
-         {
-            table_age_5 = table_age_4;
-            table_age_4 = table_age_3;
-            table_age_3 = table_age_2;
-            table_age_2 = decompack->idx;
-         }
-         if (table_age_4 == i)
-         {
-            table_age_4 = table_age_3;
-            table_age_3 = table_age_2;
-            table_age_2 = decompack->idx;
-         }
-         if (table_age_3 == i)
-         {
-            table_age_3 = table_age_2;
-            table_age_2 = decompack->idx;
-         }
-         if (table_age_2 == i)
-            table_age_2 = decompack->idx;
-      }
-      decompack->idx = i;
-      decompack->last_table = table;
-   }
-   //do read here.
-   if (decompack->binfiles[decompack->idx])
-   {
-      fseek((FILE*)(decompack->binfiles[decompack->idx]),
-            decompack->tableEnts[decompack->idx].location[s7r.reg4804].offset, 0);
-      fread(s7r.bank50, 1, (
-               decompack->tableEnts[decompack->idx].location[s7r.reg4804].size),
-            (FILE*)(decompack->binfiles[decompack->idx]));
-   }
-}
-
-//Cache Method 3: some entries are cached, others are file handles.
-//use is_file to distinguish.
-void GetPackData()
-{
-   Data7110* log = &
-                   (decompack->tableEnts[decompack->idx].location[decompack->last_idx]);
-   if ((log->used_len + log->used_offset) < (decompack->last_offset +
-         (unsigned short)s7r.bank50Internal))
-   {
-      log->used_len = s7r.bank50Internal;
-      log->used_offset = decompack->last_offset;
-   }
-
-   decompack->last_offset = (s7r.reg4805) | (s7r.reg4806 << 8);
-
-   decompack->last_idx = s7r.reg4804;
-   int table = (s7r.reg4803 << 16) | (s7r.reg4802 << 8) | s7r.reg4801;
-
-   int j = 4 * s7r.reg4804;
-   j += s7r.DataRomOffset;
-   j += table;
-
-   if (s7r.reg480B == 0)
-      s7r.AlignBy = 0;
-   else
-   {
-      switch (Memory.ROM[j])
-      {
-      case 0x03:
-         s7r.AlignBy = 8;
-         break;
-      case 0x01:
-         s7r.AlignBy = 2;
-         break;
-      case 0x02:
-         s7r.AlignBy = 4;
-         break;
-      case 0x00:
-      default:
-         s7r.AlignBy = 1;
-         break;
-      }
-   }
-   decompack->last_offset *= s7r.AlignBy;
-   decompack->last_offset %= DECOMP_BUFFER_SIZE;
-   if (table != decompack->last_table)
-   {
-      int i = 0;
-      while (i < MAX_TABLES && decompack->tableEnts[i].table != table)
-         i++;
-      if (i == MAX_TABLES)
-      {
-         FILE* fp = fopen("sp7err.out", "a");
-         //       fprintf(fp, "Table Entry %06X:%02X not found\n", table, s7r.reg4804);
-         fclose(fp);
-         return;
-      }
-      decompack->idx = i;
-      decompack->last_table = table;
-   }
-   if (decompack->binfiles[decompack->idx])
-   {
-      if (decompack->tableEnts[decompack->idx].is_file)
-      {
-         fseek((FILE*)decompack->binfiles[decompack->idx],
-               decompack->tableEnts[decompack->idx].location[s7r.reg4804].offset, 0);
-         fread(s7r.bank50, 1, (
-                  decompack->tableEnts[decompack->idx].location[s7r.reg4804].size),
-               (FILE*)(decompack->binfiles[decompack->idx]));
-      }
-      else
-      {
-         memcpy(s7r.bank50,
-                &(decompack->binfiles[decompack->idx][decompack->tableEnts[decompack->idx].location[s7r.reg4804].offset]),
-                decompack->tableEnts[decompack->idx].location[s7r.reg4804].size);
-      }
-   }
-}
-
 //reads SPC7110 and RTC registers.
 uint8_t S9xGetSPC7110(uint16_t Address)
 {
    switch (Address)
    {
    //decompressed data read port. decrements 4809-A (with wrap)
-   //4805-6 is the offset into the bank
-   //AlignBy is set (afaik) at decompression time, and is the offset multiplier
-   //bank50internal is an internal pointer to the actual byte to read.
-   //so you read from offset*multiplier + bank50internal
-   //the offset registers cannot be incremented due to the offset multiplier.
+   //bank50internal counts the bytes read since decompression started at
+   //the 4805-6 offset, so the byte comes from offset + bank50internal.
    case 0x4800:
    {
       unsigned short count = s7r.reg4809 | (s7r.reg480A << 8);
-      uint32_t i, j;
-      j = (s7r.reg4805 | (s7r.reg4806 << 8));
-      j *= s7r.AlignBy;
-      i = j;
       if (count > 0)
          count--;
       else count = 0xFFFF;
       s7r.reg4809 = 0x00ff & count;
       s7r.reg480A = (0xff00 & count) >> 8;
-      i += s7r.bank50Internal;
-      i %= DECOMP_BUFFER_SIZE;
-      s7r.reg4800 = s7r.bank50[i];
-
-      s7r.bank50Internal++;
-      s7r.bank50Internal %= DECOMP_BUFFER_SIZE;
+      s7r.reg4800 = *S9xSpc7110Decompress(1);
    }
    return s7r.reg4800;
    //table register low
@@ -599,7 +603,6 @@ uint8_t S9xGetSPC7110(uint16_t Address)
    case 0x480A:
       return s7r.reg480A;
    //Offset enable.
-   //if this is zero, 4805-6 are useless. Emulated by setting AlignBy to 0
    case 0x480B:
       return s7r.reg480B;
    //decompression finished: just emulated by switching each read.
@@ -968,7 +971,7 @@ void S9xSetSPC7110(uint8_t data, uint16_t Address)
    //offset high, starts decompression
    case 0x4806:
       s7r.reg4806 = data;
-      (*Copy7110)();
+      S9xSpc7110SelectStream();
       s7r.bank50Internal = 0;
       s7r.reg480C &= 0x7F;
       break;
@@ -995,38 +998,8 @@ void S9xSetSPC7110(uint8_t data, uint16_t Address)
 
    //Offset enable
    case 0x480B:
-   {
       s7r.reg480B = data;
-      int table = (s7r.reg4803 << 16) | (s7r.reg4802 << 8) | s7r.reg4801;
-
-      int j = 4 * s7r.reg4804;
-      j += s7r.DataRomOffset;
-      j += table;
-
-      if (s7r.reg480B == 0)
-         s7r.AlignBy = 0;
-      else
-      {
-         switch (Memory.ROM[j])
-         {
-         case 0x03:
-            s7r.AlignBy = 8;
-            break;
-         case 0x01:
-            s7r.AlignBy = 2;
-            break;
-         case 0x02:
-            s7r.AlignBy = 4;
-            break;
-         case 0x00:
-         default:
-            s7r.AlignBy = 1;
-            break;
-         }
-      }
-      //       s7r.decomp_set=true;
-   }
-   break;
+      break;
    //$4810 is probably read only.
 
    //Data port address low
@@ -1651,309 +1624,6 @@ uint8_t* Get7110BasePtr(uint32_t Address)
    return &Memory.ROM[i];
 }
 
-//loads the index into memory.
-//index.bin is little-endian
-//format index (1)-table(3)-file offset(4)-length(4)
-bool Load7110Index(char* filename)
-{
-   FILE* fp;
-   uint8_t buffer[12];
-   int table = 0;
-   uint8_t index = 0;
-   uint32_t offset = 0;
-   uint32_t size = 0;
-   int i = 0;
-   fp = fopen(filename, "rb");
-   if (NULL == fp)
-      return false;
-
-   int f_len;
-   //do
-   while (1)
-   {
-      i = 0;
-      f_len = fread(buffer, 1, 12, fp);
-      if (f_len < 12) break;
-
-      table = (buffer[3] << 16) | (buffer[2] << 8) | buffer[1];
-      index = buffer[0];
-      offset = (buffer[7] << 24) | (buffer[6] << 16) | (buffer[5] << 8) | buffer[4];
-      size = (buffer[11] << 24) | (buffer[10] << 16) | (buffer[9] << 8) | buffer[8];
-      while (i < MAX_TABLES && decompack->tableEnts[i].table != table
-             && decompack->tableEnts[i].table != 0)
-         i++;
-      if (i == MAX_TABLES)
-         return false;
-      //added
-      decompack->tableEnts[i].table = table;
-      //-----
-      decompack->tableEnts[i].location[index].offset = offset;
-      decompack->tableEnts[i].location[index].size = size;
-      decompack->tableEnts[i].location[index].used_len = 0;
-      decompack->tableEnts[i].location[index].used_offset = 0;
-
-   }
-   //while(!feof(fp));
-   fclose(fp);
-   return true;
-}
-
-
-//Cache 1 load function
-void SPC7110Load(char* dirname)
-{
-   char temp_path[PATH_MAX];
-   int i = 0;
-
-   decompack = (Pack7110*)malloc(sizeof(Pack7110));
-
-#ifndef _XBOX
-   //getcwd(temp_path, PATH_MAX);
-#endif
-
-   memset(decompack, 0, sizeof(Pack7110));
-
-#ifndef _XBOX
-   //if (-1 == chdir(dirname))
-      //S9xMessage(0, 0, "Graphics Pack not found!");
-#endif
-
-#ifndef _XBOX
-   //Load7110Index("index.bin");
-#else
-   // D:\\ is always app.path in Xbox
-   Load7110Index("d:\\index.bin");
-#endif
-
-   for (i = 0; i < MAX_TABLES; i++)
-   {
-      if (decompack->tableEnts[i].table != 0)
-      {
-         char binname[PATH_MAX];
-#ifndef _XBOX
-         sprintf(binname, "%06X.bin", decompack->tableEnts[i].table);
-#else
-         sprintf(binname, "%s%06X.bin", filename, decompack->tableEnts[i].table);
-#endif
-         //struct stat buf;
-        // if (-1 != stat(binname, &buf))
-        //    decompack->binfiles[i] = (uint8_t*)malloc(buf.st_size);
-        // FILE* fp = fopen(binname, "rb");
-         //if (fp)
-         //{
-         //   fread(decompack->binfiles[i], buf.st_size, 1, fp);
-        //    fclose(fp);
-        // }
-      }
-   }
-
-#ifndef _XBOX
-   //chdir(temp_path);
-#endif
-
-   Copy7110 = &MovePackData;
-   CleanUp7110 = &Del7110Gfx;
-
-}
-
-//Cache 2 load function
-void SPC7110Open(char* dirname)
-{
-   char temp_path[PATH_MAX];
-   int i = 0;
-
-   decompack = (Pack7110*)malloc(sizeof(Pack7110));
-
-#ifndef _XBOX
-   //getcwd(temp_path, PATH_MAX);
-#endif
-
-   memset(decompack, 0, sizeof(Pack7110));
-
-#ifndef _XBOX
-   //if (-1 == chdir(dirname))
-   //   S9xMessage(0, 0, "Graphics Pack not found!");
-#endif
-
-#ifndef _XBOX
-   Load7110Index("index.bin");
-#else
-   // D:\\ is always app.path in Xbox
-   Load7110Index("d:\\index.bin");
-#endif
-
-   for (i = 0; i < MAX_TABLES; i++)
-      decompack->binfiles[i] = NULL;
-
-   ReadPackData();
-
-#ifndef _XBOX
-   //chdir(temp_path);
-#endif
-
-   Copy7110 = &ReadPackData;
-   CleanUp7110 = &Close7110Gfx;
-
-}
-
-//Cache 3's load function
-void SPC7110Grab(char* dirname)
-{
-   char temp_path[PATH_MAX];
-   int i = 0;
-
-   decompack = (Pack7110*)malloc(sizeof(Pack7110));
-
-#ifndef _XBOX
-   //getcwd(temp_path, PATH_MAX);
-#endif
-
-   int32_t buffer_size = 1024 * 1024 * cacheMegs; //*some setting
-
-   memset(decompack, 0, sizeof(Pack7110));
-#ifndef _XBOX
-
-   //if (-1 == chdir(dirname))
-   //   S9xMessage(0, 0, "Graphics Pack not found!");
-#endif
-
-#ifndef _XBOX
-   Load7110Index("index.bin");
-#else
-   // D:\\ is always app.path in Xbox
-   Load7110Index("d:\\index.bin");
-#endif
-
-   for (i = 0; i < MAX_TABLES; i++)
-   {
-      if (decompack->tableEnts[i].table != 0)
-      {
-         char binname[PATH_MAX];
-#ifndef _XBOX
-         sprintf(binname, "%06X.bin", decompack->tableEnts[i].table);
-#else
-         sprintf(binname, "%s%06X.bin", filename, decompack->tableEnts[i].table);
-#endif
-         //struct stat buf;
-         ////add load/no load calculations here
-         //if (-1 != stat(binname, &buf))
-         //{
-         //   if (buf.st_size < buffer_size)
-         //      decompack->binfiles[i] = (uint8_t*)malloc(buf.st_size);
-         //   FILE* fp = fopen(binname, "rb");
-         //   //use them here
-         //   if (fp)
-         //   {
-         //      if (buf.st_size < buffer_size)
-         //      {
-         //         fread(decompack->binfiles[i], buf.st_size, 1, fp);
-         //         fclose(fp);
-         //         buffer_size -= buf.st_size;
-         //         decompack->tableEnts[i].is_file = false;
-         //      }
-         //      else
-         //      {
-         //         decompack->binfiles[i] = (uint8_t*)fp;
-         //         decompack->tableEnts[i].is_file = true;
-         //      }
-         //   }
-         //}
-      }
-   }
-
-#ifndef _XBOX
-   //chdir(temp_path);
-#endif
-
-   Copy7110 = &GetPackData;
-   CleanUp7110 = &Drop7110Gfx;
-
-
-}
-
-//Cache 1 clean up function
-void Del7110Gfx()
-{
-   int i;
-   if (Settings.SPC7110)
-   {
-      Do7110Logging();
-   }
-   for (i = 0; i < MAX_TABLES; i++)
-   {
-      if (decompack->binfiles[i] != NULL)
-      {
-         free(decompack->binfiles[i]);
-         decompack->binfiles[i] = NULL;
-      }
-   }
-   Settings.SPC7110 = false;
-   Settings.SPC7110RTC = false;
-   if (NULL != decompack)
-      free(decompack);
-   decompack = NULL;
-   CleanUp7110 = NULL;
-   Copy7110 = NULL;
-}
-
-//Cache2 cleanup function
-void Close7110Gfx()
-{
-   int i;
-   if (Settings.SPC7110)
-   {
-      Do7110Logging();
-   }
-   for (i = 0; i < MAX_TABLES; i++)
-   {
-      if (decompack->binfiles[i] != NULL)
-      {
-         fclose((FILE*)decompack->binfiles[i]);
-         decompack->binfiles[i] = NULL;
-      }
-   }
-   Settings.SPC7110 = false;
-   Settings.SPC7110RTC = false;
-   if (NULL != decompack)
-      free(decompack);
-   decompack = NULL;
-   CleanUp7110 = NULL;
-   Copy7110 = NULL;
-}
-
-//cache 3's clean-up code
-void Drop7110Gfx()
-{
-   int i;
-   if (Settings.SPC7110)
-   {
-      Do7110Logging();
-   }
-   for (i = 0; i < MAX_TABLES; i++)
-   {
-      if (decompack->binfiles[i] != NULL)
-      {
-         if (decompack->tableEnts[i].is_file)
-         {
-            fclose((FILE*)decompack->binfiles[i]);
-            decompack->binfiles[i] = NULL;
-         }
-         else
-         {
-            free(decompack->binfiles[i]);
-            decompack->binfiles[i] = NULL;
-         }
-      }
-   }
-   Settings.SPC7110 = false;
-   Settings.SPC7110RTC = false;
-   if (NULL != decompack)
-      free(decompack);
-   decompack = NULL;
-   CleanUp7110 = NULL;
-   Copy7110 = NULL;
-}
-
 //emulate a reset.
 void S9xSpc7110Reset()
 {
@@ -2007,213 +1677,10 @@ void S9xSpc7110Reset()
    s7r.AlignBy = 1;
    s7r.bank50Internal = 0;
    memset(s7r.bank50, 0x00, DECOMP_BUFFER_SIZE);
+   spc7110_stream = NULL;
+   spc7110_skip = 0;
 }
 
-
-//outputs a cumulative log for the game.
-//there's nothing really weird here, just
-//reading the old log, and writing a new one.
-//note the logs are explicitly little-endian, not host byte order.
-void Do7110Logging()
-{
-   uint8_t ent_temp;
-   FILE* flog;
-   int entries = 0;
-
-   if (Settings.SPC7110)
-   {
-      //flush last read into logging
-      (*Copy7110)();
-
-      if (!strncmp((char*)&Memory.ROM [0xffc0], "SUPER POWER LEAG 4   ", 21))
-      {
-#ifdef _XBOX
-         flog = fopen("T:\\spl4-sp7.dat", "rb");
-#else
-         flog = fopen("spl4-sp7.dat", "rb");
-#endif
-      }
-      else if (!strncmp((char*)&Memory.ROM [0xffc0], "MOMOTETSU HAPPY      ", 21))
-      {
-#ifdef _XBOX
-         flog = fopen("T:\\smht-sp7.dat", "rb");
-#else
-         flog = fopen("smht-sp7.dat", "rb");
-#endif
-      }
-      else if (!strncmp((char*)&Memory.ROM [0xffc0], "HU TENGAI MAKYO ZERO ", 21))
-      {
-#ifdef _XBOX
-         flog = fopen("T:\\feoezsp7.dat", "rb");
-#else
-         flog = fopen("feoezsp7.dat", "rb");
-#endif
-      }
-      else if (!strncmp((char*)&Memory.ROM [0xffc0], "JUMP TENGAIMAKYO ZERO", 21))
-      {
-#ifdef _XBOX
-         flog = fopen("T:\\sjumpsp7.dat", "rb");
-#else
-         flog = fopen("sjumpsp7.dat", "rb");
-#endif
-      }
-      else
-      {
-#ifdef _XBOX
-         flog = fopen("T:\\misc-sp7.dat", "rb");
-#else
-         flog = fopen("misc-sp7.dat", "rb");
-#endif
-      }
-
-      if (flog)
-      {
-         uint8_t buffer[8];
-         int table = 0;
-         uint16_t offset = 0;
-         uint16_t length = 0;
-         fseek(flog, 35, 0);
-
-         int f_len;
-         //do
-         while (1)
-         {
-            int i = 0;
-            Data7110* log = NULL;
-            f_len = fread(buffer, 1, 8, flog);
-            if (f_len < 8) break;
-
-            table = buffer[0] | (buffer[1] << 8) | (buffer[2] << 16);
-            offset = buffer[6] | (buffer[7] << 8);
-            length = buffer[4] | (buffer[5] << 8);
-            while (i < MAX_TABLES && log == NULL)
-            {
-               if (decompack->tableEnts[i].table == table)
-               {
-                  log = &(decompack->tableEnts[i].location[(buffer[3])]);
-                  if ((log->used_offset + log->used_len) < (offset + length))
-                  {
-                     log->used_offset = offset;
-                     log->used_len = length;
-                  }
-               }
-               i++;
-            }
-         }
-         //while(!feof(flog));
-         fclose(flog);
-      }
-
-
-      if (!strncmp((char*)&Memory.ROM [0xffc0], "SUPER POWER LEAG 4   ", 21))
-      {
-#ifdef _XBOX   // cwd could be the dvd-rom, so write to T:\\ which is storage region for each title
-         flog = fopen("T:\\spl4-sp7.dat", "wb");
-#else
-         flog = fopen("spl4-sp7.dat", "wb");
-#endif
-      }
-      else if (!strncmp((char*)&Memory.ROM [0xffc0], "MOMOTETSU HAPPY      ", 21))
-      {
-#ifdef _XBOX
-         flog = fopen("T:\\smht-sp7.dat", "wb");
-#else
-         flog = fopen("smht-sp7.dat", "wb");
-#endif
-      }
-      else if (!strncmp((char*)&Memory.ROM [0xffc0], "HU TENGAI MAKYO ZERO ", 21))
-      {
-#ifdef _XBOX
-         flog = fopen("T:\\feoezsp7.dat", "wb");
-#else
-         flog = fopen("feoezsp7.dat", "wb");
-#endif
-      }
-      else if (!strncmp((char*)&Memory.ROM [0xffc0], "JUMP TENGAIMAKYO ZERO", 21))
-      {
-#ifdef _XBOX
-         flog = fopen("T:\\sjumpsp7.dat", "wb");
-#else
-         flog = fopen("sjumpsp7.dat", "wb");
-#endif
-      }
-      else
-      {
-#ifdef _XBOX
-         flog = fopen("T:\\misc-sp7.dat", "wb");
-#else
-         flog = fopen("misc-sp7.dat", "wb");
-#endif
-      }
-      //count entries
-      if (flog)
-      {
-         int j = 0;
-         int temp = 0;
-         for (j = 0; j < MAX_TABLES; j++)
-         {
-            int k;
-            for (k = 0; k < 256; k++)
-            {
-               if (decompack->tableEnts[j].location[k].used_len != 0)
-                  entries++;
-            }
-         }
-         ent_temp = entries & 0xFF;
-         fwrite(&ent_temp, 1, 1, flog);
-         ent_temp = (entries >> 8) & 0xFF;
-         fwrite(&ent_temp, 1, 1, flog);
-         ent_temp = (entries >> 16) & 0xFF;
-         fwrite(&ent_temp, 1, 1, flog);
-         ent_temp = (entries >> 24) & 0xFF;
-         fwrite(&ent_temp, 1, 1, flog);
-         fwrite(&temp, 1, 4, flog);
-         fwrite(&temp, 1, 4, flog);
-         fwrite(&temp, 1, 4, flog);
-         fwrite(&temp, 1, 4, flog);
-         fwrite(&temp, 1, 4, flog);
-         fwrite(&temp, 1, 4, flog);
-         fwrite(&temp, 1, 4, flog);
-
-         ent_temp = 0;
-         fwrite(&ent_temp, 1, 1, flog);
-         ent_temp = 0;
-         fwrite(&ent_temp, 1, 1, flog);
-         ent_temp = 0;
-         fwrite(&ent_temp, 1, 1, flog);
-
-         for (j = 0; j < MAX_TABLES; j++)
-         {
-            int k;
-            for (k = 0; k < 256; k++)
-            {
-               if (decompack->tableEnts[j].location[k].used_len != 0)
-               {
-                  ent_temp = decompack->tableEnts[j].table & 0xFF;
-                  fwrite(&ent_temp, 1, 1, flog); //801
-                  ent_temp = (decompack->tableEnts[j].table >> 8) & 0xFF;;
-                  fwrite(&ent_temp, 1, 1, flog); //802
-                  ent_temp = (decompack->tableEnts[j].table >> 16) & 0xFF;;
-                  fwrite(&ent_temp, 1, 1, flog); //803
-                  ent_temp = k & 0xFF;
-                  fwrite(&ent_temp, 1, 1, flog); //804
-                  ent_temp = decompack->tableEnts[j].location[k].used_len & 0xFF;
-                  fwrite(&ent_temp, 1, 1, flog); //lsb of
-                  ent_temp = (decompack->tableEnts[j].location[k].used_len >> 8) & 0xFF;
-                  fwrite(&ent_temp, 1, 1, flog); //msb of
-                  ent_temp = (decompack->tableEnts[j].location[k].used_offset) & 0xFF;
-                  fwrite(&ent_temp, 1, 1, flog); //lsb of
-                  ent_temp = (decompack->tableEnts[j].location[k].used_offset >> 8) & 0xFF;
-                  fwrite(&ent_temp, 1, 1, flog); //msb of
-               }
-            }
-         }
-         fwrite(&temp, 1, 4, flog);
-         fwrite(&temp, 1, 4, flog);
-         fclose(flog);
-      }
-   }
-}
 bool S9xSaveSPC7110RTC(S7RTC* rtc_f9)
 {
    FILE* fp;
@@ -92,32 +92,18 @@
 
 #define DECOMP_BUFFER_SIZE 0x10000
 
-extern void (*LoadUp7110)(char*);
-extern void (*CleanUp7110)(void);
-extern void (*Copy7110)(void);
-
-extern uint16_t cacheMegs;
-
-void Del7110Gfx(void);
-void Close7110Gfx(void);
-void Drop7110Gfx(void);
 uint8_t S9xGetSPC7110(uint16_t Address);
 uint8_t S9xGetSPC7110Byte(uint32_t Address);
 uint8_t* Get7110BasePtr(uint32_t);
 void S9xSetSPC7110(uint8_t data, uint16_t Address);
 void S9xSpc7110Init();
-uint8_t* Get7110BasePtr(uint32_t);
+void S9xSpc7110Deinit();
 void S9xSpc7110Reset();
+void S9xSpc7110PostLoadState();
+uint8_t* S9xSpc7110Decompress(uint32_t count);
 void S9xUpdateRTC();
-void Do7110Logging();
 int   S9xRTCDaysInMonth(int month, int year);
 
-//These are platform-dependant functions, but should work on
-//most systems that use GNU compilers, and on Win32.
-void SPC7110Load(char*);
-void SPC7110Open(char*);
-void SPC7110Grab(char*);
-
 typedef struct SPC7110RTC
 {
    unsigned char reg[16];
@@ -376,6 +376,30 @@ void DrawClippedTile16(uint32_t Tile, int32_t Offset,
    RENDER_CLIPPED_TILE(WRITE_4PIXELS16, WRITE_4PIXELS16_FLIPPED, 4)
 }
 
+// Returns the eight cached pixels of the tile row starting at StartLine,
+// converting the tile first if needed, or NULL if the whole tile is blank.
+uint8_t* GetCachedTileRow(uint32_t Tile, uint32_t StartLine)
+{
+   uint8_t* pCache;
+
+   uint32_t TileAddr = BG.TileAddress + ((Tile & 0x3ff) << BG.TileShift);
+   if ((Tile & 0x1ff) >= 256)
+      TileAddr += BG.NameSelect;
+
+   TileAddr &= 0xffff;
+
+   uint32_t TileNumber;
+   pCache = &BG.Buffer[(TileNumber = (TileAddr >> BG.TileShift)) << 6];
+
+   if (!BG.Buffered [TileNumber])
+      BG.Buffered[TileNumber] = ConvertTile(pCache, TileAddr);
+
+   if (BG.Buffered [TileNumber] == BLANK_TILE)
+      return NULL;
+
+   return pCache + StartLine;
+}
+
 void DrawTile16HalfWidth(uint32_t Tile, int32_t Offset, uint32_t StartLine,
                          uint32_t LineCount)
 {
@@ -0,0 +1,121 @@
+// Single-producer/single-consumer ring buffer of interleaved stereo
+// int16_t frames. The emulation thread writes into it from the libretro
+// audio callback and the output thread drains it, without either side
+// having to take a lock. Nothing in here is Vita specific, so any host
+// can include it.
+
+#ifndef __AUDIO_RING_H__
+#define __AUDIO_RING_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__GNUC__)
+#define AUDIO_RING_LOAD(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define AUDIO_RING_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#define AUDIO_RING_LOAD(p) (*(volatile uint32_t*)(p))
+#define AUDIO_RING_STORE(p, v) (*(volatile uint32_t*)(p) = (v))
+#endif
+
+typedef struct
+{
+    int16_t *data;       // capacity * 2 samples
+    uint32_t capacity;   // in frames, must be a power of two
+    uint32_t head;       // frames written, only touched by the producer
+    uint32_t tail;       // frames read, only touched by the consumer
+
+    // writes that had to drop frames (producer side) and reads that found
+    // less than a full period buffered (consumer side)
+    uint32_t overruns;
+    uint32_t underruns;
+} audio_ring_t;
+
+/***
+ * Sets up the ring on top of caller-provided storage of capacity * 2 samples.
+ */
+static inline void audio_ring_init(audio_ring_t *ring, int16_t *storage, uint32_t capacity)
+{
+    ring->data = storage;
+    ring->capacity = capacity;
+    ring->head = 0;
+    ring->tail = 0;
+    ring->overruns = 0;
+    ring->underruns = 0;
+}
+
+/***
+ * Number of frames currently buffered.
+ */
+static inline uint32_t audio_ring_fill(const audio_ring_t *ring)
+{
+    return AUDIO_RING_LOAD(&ring->head) - AUDIO_RING_LOAD(&ring->tail);
+}
+
+/***
+ * Number of frames that can be written without dropping any.
+ */
+static inline uint32_t audio_ring_space(const audio_ring_t *ring)
+{
+    return ring->capacity - audio_ring_fill(ring);
+}
+
+/***
+ * Producer side. Copies as many frames as fit and returns how many that was;
+ * the rest are dropped and counted as an overrun.
+ */
+static inline size_t audio_ring_write(audio_ring_t *ring, const int16_t *frames, size_t count)
+{
+    uint32_t head = ring->head;
+    uint32_t space = ring->capacity - (head - AUDIO_RING_LOAD(&ring->tail));
+    uint32_t pos, first;
+
+    if (count > space)
+    {
+        count = space;
+        ring->overruns++;
+    }
+
+    pos = head & (ring->capacity - 1);
+    first = ring->capacity - pos;
+    if (first > count)
+        first = count;
+
+    memcpy(&ring->data[pos * 2], frames, first * 2 * sizeof(int16_t));
+    memcpy(&ring->data[0], &frames[first * 2], (count - first) * 2 * sizeof(int16_t));
+
+    AUDIO_RING_STORE(&ring->head, head + (uint32_t)count);
+    return count;
+}
+
+/***
+ * Consumer side. Audio hardware wants whole periods, so this either copies
+ * exactly count frames and returns count, or copies nothing, counts an
+ * underrun and returns 0.
+ */
+static inline size_t audio_ring_read(audio_ring_t *ring, int16_t *frames, size_t count)
+{
+    uint32_t tail = ring->tail;
+    uint32_t fill = AUDIO_RING_LOAD(&ring->head) - tail;
+    uint32_t pos, first;
+
+    if (count > fill)
+    {
+        ring->underruns++;
+        return 0;
+    }
+
+    pos = tail & (ring->capacity - 1);
+    first = ring->capacity - pos;
+    if (first > count)
+        first = count;
+
+    memcpy(frames, &ring->data[pos * 2], first * 2 * sizeof(int16_t));
+    memcpy(&frames[first * 2], &ring->data[0], (count - first) * 2 * sizeof(int16_t));
+
+    AUDIO_RING_STORE(&ring->tail, tail + (uint32_t)count);
+    return count;
+}
+
+#endif
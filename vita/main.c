@@ -56,6 +56,27 @@ int retro_environment_callback(unsigned cmd, void *data)
     if (curr_frame == 0)
         printf("Inside of retro_environment_callback");
 
+    switch (cmd)
+    {
+    case RETRO_ENVIRONMENT_GET_CAN_DUPE:
+        // the video callback keeps the last frame in its texture
+        *(bool*)data = true;
+        return 1;
+    case RETRO_ENVIRONMENT_GET_CURRENT_SOFTWARE_FRAMEBUFFER:
+        // lets the core render straight into our texture
+        return get_current_software_framebuffer((struct retro_framebuffer*)data);
+    case RETRO_ENVIRONMENT_GET_CORE_RATE_CONTROL:
+        // our audio thread plays at a fixed rate, so the core has to keep
+        // the ring from drifting
+        *(bool*)data = true;
+        return 1;
+    case RETRO_ENVIRONMENT_SET_AUDIO_BUFFER_STATUS_CALLBACK:
+        // drives the core's dynamic rate control from our audio ring
+        set_audio_buffer_status_callback(data ?
+            ((const struct retro_audio_buffer_status_callback*)data)->callback : NULL);
+        return 1;
+    }
+
     return 0;
 }
 
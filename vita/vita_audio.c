@@ -9,20 +9,8 @@
  */
 size_t retro_audio_sample_batch_callback(const int16_t *data, size_t frames)
 {
-    sceKernelLockMutex(audio_mutex, 1, NULL);
-
-	// make sure we don't overbuffer
-    if (frames + curr_buffer_frames > AUDIO_SAMPLE_COUNT * 2)
-    {
-        frames = (AUDIO_SAMPLE_COUNT * 2) - curr_buffer_frames;
-    }
-
-    // store the data in our buffer
-    memcpy(&retro_audio_callback_buffer[curr_buffer_frames * 2], data, frames * 2 * sizeof(int16_t));
-    curr_buffer_frames += frames;
-
-    sceKernelUnlockMutex(audio_mutex, 1);
-    return frames;
+    // anything that doesn't fit is dropped and counted as an overrun
+    return audio_ring_write(&audio_ring, data, frames);
 }
 
 /***
@@ -30,26 +18,7 @@ size_t retro_audio_sample_batch_callback(const int16_t *data, size_t frames)
  */
 int audio_callback(void *buffer, unsigned int *length, void *userdata)
 {
-    int i;
-    int len = *length;
-
-    sceKernelLockMutex(audio_mutex, 1, NULL);
-
-    // see if we've buffered enough frames
-    if (len <= curr_buffer_frames)
-    {
-        memcpy(buffer, &retro_audio_callback_buffer[0], len * 2 * sizeof(int16_t));
-        curr_buffer_frames -= len;
-        memmove(&retro_audio_callback_buffer[0], &retro_audio_callback_buffer[len * 2], sizeof(int16_t) * 2 * curr_buffer_frames);
-
-        sceKernelUnlockMutex(audio_mutex, 1);
-        return len;
-    }
-    else
-    {
-        sceKernelUnlockMutex(audio_mutex, 1);
-        return 0;
-    }
+    return audio_ring_read(&audio_ring, (int16_t*)buffer, *length);
 }
 
 /***
@@ -170,8 +139,8 @@ int setup_audio()
         return 0;
     }
 
-    // initialize the buffer our libretro audio callback will fill with data as it's available
-    retro_audio_callback_buffer = (int16_t*)malloc(sizeof(int16_t) * AUDIO_SAMPLE_COUNT * 4);
+    // initialize the ring our libretro audio callback will fill with data as it's available
+    retro_audio_callback_buffer = (int16_t*)malloc(sizeof(int16_t) * 2 * AUDIO_RING_FRAMES);
 
     if (!retro_audio_callback_buffer)
     {
@@ -179,14 +148,11 @@ int setup_audio()
         sceKernelExitProcess(0);
     }
 
-    curr_buffer_frames = 0;
+    audio_ring_init(&audio_ring, retro_audio_callback_buffer, AUDIO_RING_FRAMES);
 
     // setup our callbacks
     set_audio_channel_callback(0, audio_callback, 0);
 
-    // initialize the audio buffer mutex
-    audio_mutex = sceKernelCreateMutex("AudioMutex", 0, 1, 0);
-
     return AUDIO_SAMPLE_COUNT;
 }
 
@@ -218,7 +184,8 @@ void audio_shutdown()
     }
 
     free_buffers();
-    sceKernelDeleteMutex(audio_mutex);
+    free(retro_audio_callback_buffer);
+    retro_audio_callback_buffer = NULL;
 }
 
 /***
@@ -323,3 +290,26 @@ void set_audio_channel_callback(int channel, pspAudioCallback callback, void *us
     pci->Userdata = userdata;
     pci->Callback = callback;
 }
+
+/***
+ * Sets the callback the core wants to receive the audio buffer fill level on.
+ */
+void set_audio_buffer_status_callback(retro_audio_buffer_status_callback_t callback)
+{
+    audio_buffer_status_callback = callback;
+}
+
+/***
+ * Tells the core how full the ring is; called once before every retro_run().
+ */
+void report_audio_buffer_status()
+{
+    unsigned int fill;
+
+    if (!audio_buffer_status_callback)
+        return;
+
+    fill = audio_ring_fill(&audio_ring);
+    audio_buffer_status_callback(!stop_audio,
+        fill * 100 / AUDIO_RING_FRAMES, fill < AUDIO_SAMPLE_COUNT);
+}
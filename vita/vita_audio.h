@@ -8,6 +8,7 @@
 #define AUDIO_CHANNELS 1
 #define AUDIO_SAMPLE_COUNT 512
 #define AUDIO_OUTPUT_RATE 32000
+#define AUDIO_RING_FRAMES (AUDIO_SAMPLE_COUNT * 4)
 #define PSP_AUDIO_SAMPLE_ALIGN(s) (((s) + 63) & ~63)
 #define PSP_AUDIO_SAMPLE_TRUNCATE(s) ((s) & ~63)
 #define PSP_AUDIO_MAX_VOLUME 0x8000
@@ -20,6 +21,9 @@
 #include <psp2/kernel/sysmem.h>
 #include <psp2/audioout.h>
 
+#include "audio_ring.h"
+#include "../libretro/libretro.h"
+
 typedef int(*pspAudioCallback)(void *buffer, unsigned int *sample_count, void *userdata);
 
 // represents a single audio sample, with a left and right value
@@ -39,15 +43,14 @@ typedef struct {
     void *Userdata;
 } ChannelInfo;
 
-// maintain concurrency between the thread that's buffering audio
-// data and the thread that's playing it
-static SceUID audio_mutex;
-
-// keep track of our current audio frame buffer and its length
-// (the data received in the libretro audio callback)
-static unsigned int curr_buffer_frames;
+// frames received in the libretro audio callback, waiting to be played;
+// the emulation thread only writes and the audio thread only reads
+static audio_ring_t audio_ring;
 static int16_t *retro_audio_callback_buffer;
 
+// the core's dynamic rate control hook, fed with the ring's fill level
+static retro_audio_buffer_status_callback_t audio_buffer_status_callback;
+
 // buffers and variables for each of our audio channels
 static volatile int stop_audio;
 static ChannelInfo audio_status[AUDIO_CHANNELS];
@@ -62,6 +65,8 @@ int audio_callback(void *buffer, unsigned int *length, void *userdata);
 static void free_buffers();
 static int output_audio_blocking(unsigned int channel, unsigned int vol1, unsigned int vol2, void *buf, int length);
 void set_audio_channel_callback(int channel, pspAudioCallback callback, void *userdata);
+void set_audio_buffer_status_callback(retro_audio_buffer_status_callback_t callback);
+void report_audio_buffer_status();
 void audio_shutdown();
 
 #endif
@@ -117,6 +117,7 @@ PL_MENU_ITEMS_BEGIN(OptionMenuDef)
         PL_MENU_ITEM("Frame limiter", OPTION_SYNC_FREQ, FrameLimitOptions, "\026\250\020 Change screen update frequency")
         PL_MENU_ITEM("Frame skipping", OPTION_FRAMESKIP, FrameSkipOptions, "\026\250\020 Change number of frames skipped per update")
         PL_MENU_ITEM("VSync", OPTION_VSYNC, ToggleOptions, "\026\250\020 Enable to reduce tearing; disable to increase speed")
+        PL_MENU_ITEM("SuperFX thread", OPTION_SUPERFX_THREAD, ToggleOptions, "\026\250\020 Run the SuperFX chip on a second core; faster, but may break some games")
         PL_MENU_ITEM("PSP clock frequency", OPTION_CLOCK_FREQ, PspClockFreqOptions, "\026\250\020 Larger values: faster emulation, faster battery depletion (default: 333MHz)")
         PL_MENU_ITEM("Show FPS counter", OPTION_SHOW_FPS, ToggleOptions, "\026\250\020 Show/hide the frames-per-second counter")
     PL_MENU_HEADER("Menu")
@@ -402,6 +403,7 @@ void LoadOptions()
     Options.VSync         = pl_ini_get_int(&init, "Video", "VSync", 0);
     Options.ClockFreq     = pl_ini_get_int(&init, "Video", "PSP Clock Frequency", 444);
     Options.ShowFps       = pl_ini_get_int(&init, "Video", "Show FPS", 0);
+    Options.SuperFXThread = pl_ini_get_int(&init, "Video", "SuperFX Thread", 0);
 
     Options.ControlMode   = pl_ini_get_int(&init, "Menu", "Control Mode", 0);
     UiMetric.Animate      = pl_ini_get_int(&init, "Menu", "Animate", 1);
@@ -433,6 +435,7 @@ int SaveOptions()
     pl_ini_set_int(&init, "Video", "VSync", Options.VSync);
     pl_ini_set_int(&init, "Video", "PSP Clock Frequency", Options.ClockFreq);
     pl_ini_set_int(&init, "Video", "Show FPS", Options.ShowFps);
+    pl_ini_set_int(&init, "Video", "SuperFX Thread", Options.SuperFXThread);
 
     pl_ini_set_int(&init, "Menu", "Control Mode", Options.ControlMode);
     pl_ini_set_int(&init, "Menu", "Animate", UiMetric.Animate);
@@ -497,6 +500,8 @@ void DisplayMenu()
             if ((item = pl_menu_find_item_by_id(&OptionUiMenu.Menu, OPTION_VSYNC)))
                 pl_menu_select_option_by_value(item, (void*)Options.VSync);
 
+            item = pl_menu_find_item_by_id(&OptionUiMenu.Menu, OPTION_SUPERFX_THREAD);
+            pl_menu_select_option_by_value(item, (void*)Options.SuperFXThread);
             item = pl_menu_find_item_by_id(&OptionUiMenu.Menu, OPTION_CLOCK_FREQ);
             pl_menu_select_option_by_value(item, (void*)Options.ClockFreq);
             item = pl_menu_find_item_by_id(&OptionUiMenu.Menu, OPTION_SHOW_FPS);
@@ -530,6 +535,7 @@ void DisplayMenu()
             { 
                 // run one frame of the emulator
                 curr_fps = pl_perf_update_counter(&FpsCounter);
+                report_audio_buffer_status();
                 retro_run();
 
                 // wait if needed 
@@ -843,6 +849,9 @@ int OnMenuItemChanged(const struct PspUiMenu *uimenu, pl_menu_item* item, const
         case OPTION_VSYNC:
             Options.VSync = value;
             break;
+        case OPTION_SUPERFX_THREAD:
+            Options.SuperFXThread = value;
+            break;
         case OPTION_CLOCK_FREQ:
             Options.ClockFreq = value;
             break;
@@ -1079,7 +1088,10 @@ void OnSystemRender(const void *uiobject, const void *item_obj)
 
     /* Draw a small representation of the screen */
     pspVideoShadowRect(x, y, x + w - 1, y + h - 1, PSP_COLOR_BLACK, 3);
-    vita2d_draw_texture_scale(tex, x, y, 1.0f, 1.0f);
+    if (tex)
+        vita2d_draw_texture_part_scale(tex, x, y, 0, tex_frame_y,
+            Screen->Viewport.Width, Screen->Viewport.Height,
+            (float)w / Screen->Viewport.Width, (float)h / Screen->Viewport.Height);
     pspVideoDrawRect(x, y, x + w - 1, y + h - 1, PSP_COLOR_GRAY);
 
     OnGenericRender(uiobject, item_obj);
@@ -1145,6 +1157,9 @@ void OnOptionsChange()
     Settings.MouseMaster = (Options.ControllerDevice == SNES_MOUSE_SWAPPED);
     Settings.MouseSpeed = Options.MouseSpeed;
 
+    // GSU worker thread
+    Settings.ThreadSuperFX = Options.SuperFXThread;
+
     // frame limiter
     if (Options.UpdateFreq)
     {
@@ -29,6 +29,7 @@
 #include "../source/memmap.h"
 #include "../libretro/libretro.h"
 #include "vita_video.h"
+#include "vita_audio.h"
 
 #define TAB_QUICKLOAD 0
 #define TAB_STATE     1
@@ -50,6 +51,7 @@
 #define OPTION_ANIMATE           10
 #define OPTION_CONTROLLER_DEVICE 11
 #define OPTION_MOUSE_SENSITIVITY 12
+#define OPTION_SUPERFX_THREAD    13
 
 #define SYSTEM_RESET           1
 #define SYSTEM_SCRNSHOT        2
@@ -98,6 +100,7 @@ typedef struct
     int TextureFilter;
     int ControllerDevice;
     int MouseSpeed;
+    int SuperFXThread;
 } EmulatorOptions;
 
 struct ButtonConfig
@@ -10,51 +10,116 @@ float scale_x, scale_y;
 int pos_x, pos_y;
 unsigned short h, w;
 vita2d_texture *tex;
-void *tex_data;
+unsigned tex_frame_y;
+vita2d_texture *tex_bufs[2];
+unsigned tex_back;
+unsigned tex_width, tex_height, tex_pitch;
 PspImage *Screen;
 SceGxmTextureFilter tex_filter;
 
 /***
- * Callback for when a new frame is generated that we need to render.
+ * Makes sure both render textures can hold a width x height frame. Frames
+ * alternate between the two so the CPU can fill one while the GPU is still
+ * drawing the other, which means a texture only has to be waited on when it
+ * is freed.
  */
-bool retro_video_refresh_callback(const void *data, unsigned width, unsigned height, size_t pitch)
+static bool ensure_texture(unsigned width, unsigned height)
 {
-	curr_frame++;
+    int i;
+
+    if (tex_bufs[0] && width <= tex_width && height <= tex_height)
+        return true;
+
+    if (tex_bufs[0])
+    {
+        vita2d_wait_rendering_done();
+        for (i = 0; i < 2; i++)
+        {
+            vita2d_free_texture(tex_bufs[i]);
+            tex_bufs[i] = NULL;
+        }
+        tex = NULL;
+    }
 
-    // initialize our main render texture once we get the dimensions for the first time
-    if (!tex)
+    for (i = 0; i < 2; i++)
     {
-        tex = vita2d_create_empty_texture_format(width, height, SCE_GXM_TEXTURE_FORMAT_R5G6B5);
-        tex_data = vita2d_texture_get_datap(tex);
+        tex_bufs[i] = vita2d_create_empty_texture_format(width, height, SCE_GXM_TEXTURE_FORMAT_R5G6B5);
+        if (!tex_bufs[i])
+        {
+            if (i)
+                vita2d_free_texture(tex_bufs[0]);
+            tex_bufs[0] = NULL;
+            return false;
+        }
+    }
 
-        // initialize PSPImage
-        if (Screen)
-            free(Screen);
-        int size = width * height * 2;
+    tex_width = width;
+    tex_height = height;
+    tex_pitch = vita2d_texture_get_stride(tex_bufs[0]);
+    for (i = 0; i < 2; i++)
+        memset(vita2d_texture_get_datap(tex_bufs[i]), 0, tex_pitch * height);
 
+    tex = tex_bufs[0];
+    tex_back = 1;
+    tex_frame_y = 0;
+
+    // initialize PSPImage
+    if (!Screen)
         Screen = (PspImage*)malloc(sizeof(PspImage));
 
-        Screen->TextureFormat = SCE_GXM_TEXTURE_FORMAT_R5G6B5;
-        Screen->PalSize = (unsigned short)0;
-        memset(tex_data, 0, size);
-
-        Screen->Width = width;
-        Screen->Height = height;
-        Screen->Pixels = tex_data;
-        Screen->Texture = tex;
-
-        Screen->Viewport.X = 0;
-        Screen->Viewport.Y = 0;
-        Screen->Viewport.Width = width;
-        Screen->Viewport.Height = height;
-
-        int i;
-        for (i = 1; i < width; i *= 2);
-            Screen->PowerOfTwo = (i == width);
-        Screen->BytesPerPixel = 2;
-        Screen->FreeBuffer = 0;
-        Screen->Depth = 16;
-    }
+    Screen->TextureFormat = SCE_GXM_TEXTURE_FORMAT_R5G6B5;
+    Screen->PalSize = (unsigned short)0;
+
+    Screen->Width = tex_pitch / 2;
+    Screen->Height = height;
+    Screen->Pixels = vita2d_texture_get_datap(tex);
+    Screen->Texture = tex;
+
+    Screen->Viewport.X = 0;
+    Screen->Viewport.Y = 0;
+    Screen->Viewport.Width = width;
+    Screen->Viewport.Height = height;
+
+    for (i = 1; i < Screen->Width; i *= 2);
+        Screen->PowerOfTwo = (i == Screen->Width);
+    Screen->BytesPerPixel = 2;
+    Screen->FreeBuffer = 0;
+    Screen->Depth = 16;
+
+    // new textures need their filtering set up again
+    OptionsChanged = true;
+
+    return true;
+}
+
+/***
+ * Hands the core the texture that isn't on screen to render into, so frames
+ * don't need copying.
+ */
+bool get_current_software_framebuffer(struct retro_framebuffer *fb)
+{
+    if (!ensure_texture(fb->width, fb->height))
+        return false;
+
+    fb->data = vita2d_texture_get_datap(tex_bufs[tex_back]);
+    fb->pitch = tex_pitch;
+    fb->format = RETRO_PIXEL_FORMAT_RGB565;
+    fb->memory_flags = 0;
+
+    return true;
+}
+
+/***
+ * Callback for when a new frame is generated that we need to render.
+ */
+bool retro_video_refresh_callback(const void *data, unsigned width, unsigned height, size_t pitch)
+{
+    int i;
+
+	curr_frame++;
+
+    if (!ensure_texture(width, height))
+        return false;
 
     // initialize our render variables if they're uninitalized, or
     // if they've changed due to user action
@@ -91,23 +156,53 @@ bool retro_video_refresh_callback(const void *data, unsigned width, unsigned hei
         // handle texture filtering options
         tex_filter = Options.TextureFilter ? SCE_GXM_TEXTURE_FILTER_LINEAR : SCE_GXM_TEXTURE_FILTER_POINT;
 
-        sceGxmTextureSetMinFilter(&(tex->gxm_tex), tex_filter);
-        sceGxmTextureSetMagFilter(&(tex->gxm_tex), tex_filter);
+        for (i = 0; i < 2; i++)
+        {
+            sceGxmTextureSetMinFilter(&(tex_bufs[i]->gxm_tex), tex_filter);
+            sceGxmTextureSetMagFilter(&(tex_bufs[i]->gxm_tex), tex_filter);
+        }
 	}
 
-	// copy the input pixels into the output buffer
-	const uint16_t* in_pixels = (const uint16_t*)data;
-	uint16_t *out_pixels = (uint16_t *)tex_data;
-
-	for (h = 0; h < height; h++, in_pixels += pitch / 2, out_pixels += width) 
+	// a NULL frame is a duplicate of the last one, which is still sitting in
+	// the front texture; anything else goes into the back texture, either
+	// rendered there by the core already or copied in here, and then swaps
+	// with the front one
+	if (data)
 	{
-		memcpy(out_pixels, in_pixels, width * sizeof(uint16_t));
+		const uint8_t* back = (const uint8_t*)vita2d_texture_get_datap(tex_bufs[tex_back]);
+		const uint8_t* in = (const uint8_t*)data;
+
+		if (in >= back && in + (height - 1) * pitch + width * sizeof(uint16_t) <= back + tex_pitch * tex_height &&
+			pitch == tex_pitch && (in - back) % tex_pitch == 0)
+		{
+			tex_frame_y = (in - back) / tex_pitch;
+		}
+		else
+		{
+			const uint16_t* in_pixels = (const uint16_t*)data;
+			uint16_t *out_pixels = (uint16_t *)back;
+
+			for (h = 0; h < height; h++, in_pixels += pitch / 2, out_pixels += tex_pitch / 2)
+			{
+				memcpy(out_pixels, in_pixels, width * sizeof(uint16_t));
+			}
+			tex_frame_y = 0;
+		}
+
+		tex = tex_bufs[tex_back];
+		tex_back ^= 1;
+
+		Screen->Texture = tex;
+		Screen->Pixels = (uint8_t*)vita2d_texture_get_datap(tex) + tex_pitch * tex_frame_y;
+		Screen->Height = height;
+		Screen->Viewport.Width = width;
+		Screen->Viewport.Height = height;
 	}
 
     // draw the screen
 	vita2d_start_drawing();
 
-	vita2d_draw_texture_scale(tex, pos_x, pos_y, scale_x, scale_y);
+	vita2d_draw_texture_part_scale(tex, pos_x, pos_y, 0, tex_frame_y, Screen->Viewport.Width, Screen->Viewport.Height, scale_x, scale_y);
 
     if(Options.ShowFps)
         show_fps();
@@ -138,6 +233,17 @@ void show_fps()
  */
 void video_shutdown()
 {
-    free(tex);
-    free(tex_data);
+    int i;
+
+    if (tex_bufs[0])
+    {
+        vita2d_wait_rendering_done();
+        for (i = 0; i < 2; i++)
+        {
+            vita2d_free_texture(tex_bufs[i]);
+            tex_bufs[i] = NULL;
+        }
+    }
+
+    tex = NULL;
 }
\ No newline at end of file
@@ -24,7 +24,9 @@ extern unsigned long curr_frame;
 extern float curr_fps;
 extern float scale_x, scale_y;
 extern vita2d_texture *tex;
+extern unsigned tex_frame_y;
 
+bool get_current_software_framebuffer(struct retro_framebuffer *fb);
 bool retro_video_refresh_callback(const void *data, unsigned width, unsigned height, size_t pitch);
 void show_fps();
 void video_shutdown();